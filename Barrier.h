@@ -0,0 +1,36 @@
+#ifndef BARRIER_H
+#define BARRIER_H
+
+#include <mutex>
+#include <condition_variable>
+
+// Reusable barrier for a fixed number of threads. Everything written
+// before arriveAndWait() is visible to all threads after it returns.
+class Barrier {
+public:
+    // Constructor - number of threads taking part in each phase
+    explicit Barrier(unsigned int count)
+        : count(count), waiting(0), generation(0) {}
+
+    // Block until all threads of the current phase have arrived
+    void arriveAndWait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        unsigned int phase = generation;
+        if (++waiting == count) {
+            waiting = 0;
+            generation++;
+            released.notify_all();
+            return;
+        }
+        released.wait(lock, [&] { return generation != phase; });
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable released;
+    unsigned int count;       // Threads per phase
+    unsigned int waiting;     // Threads arrived in the current phase
+    unsigned int generation;  // Completed phases
+};
+
+#endif // BARRIER_H
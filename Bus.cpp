@@ -0,0 +1,291 @@
+#include "Bus.h"
+#include "Cache.h"
+#include "BusModel.h"
+#include "SnoopFilter.h"
+#include "L2Cache.h"
+#include "SharingProfiler.h"
+#include "Checkpoint.h"
+#include <algorithm>
+#include <limits>
+
+// Parse "mesi", "moesi" or "mesif"
+bool Bus::parseProtocol(const std::string& name, CoherenceProtocol& protocol) {
+    if (name == "mesi")  { protocol = CoherenceProtocol::MESI;  return true; }
+    if (name == "moesi") { protocol = CoherenceProtocol::MOESI; return true; }
+    if (name == "mesif") { protocol = CoherenceProtocol::MESIF; return true; }
+    return false;
+}
+
+// Name of a protocol for reports
+const char* Bus::protocolName(CoherenceProtocol protocol) {
+    switch (protocol) {
+    case CoherenceProtocol::MOESI: return "MOESI";
+    case CoherenceProtocol::MESIF: return "MESIF";
+    default:                       return "MESI";
+    }
+}
+
+// Constructor
+Bus::Bus(CoherenceProtocol protocol, const std::vector<Cache*>& caches, BusModel& timing,
+         unsigned int blockSize, const unsigned int& clock)
+    : protocol(protocol), caches(caches), timing(timing), blockSize(blockSize), clock(clock),
+      snoopFilter(nullptr), l2(nullptr), sharingProfiler(nullptr),
+      writebackBuffers(false), nextDrain(0), functional(false), snoopedHolders(0),
+      invalidations(0), trafficBytes(0), cacheToCache(0), dataResponses(0),
+      snoopWritebacks(0), cacheFills(0), cacheFillCycles(0), memoryFills(0),
+      memoryFillCycles(0) {
+}
+
+CoherenceProtocol Bus::getProtocol() const {
+    return protocol;
+}
+
+// Directory of sharers to snoop instead of every cache
+void Bus::setSnoopFilter(SnoopFilter* filter) {
+    snoopFilter = filter;
+}
+
+// Shared L2 behind the caches
+void Bus::setL2(L2Cache* cache) {
+    l2 = cache;
+}
+
+// Caches buffer writebacks, so drained entries must be retired
+void Bus::setWritebackBuffers(bool enabled) {
+    writebackBuffers = enabled;
+    nextDrain = 0;
+}
+
+// A buffered entry of some cache finishes draining at `cycle`
+void Bus::noteWriteback(unsigned int cycle) {
+    nextDrain = std::min(nextDrain, cycle);
+}
+
+// Functional warming: snoop, but count nothing and reserve no bus time
+void Bus::setFunctional(bool enabled) {
+    functional = enabled;
+}
+
+#ifdef L1SIM_INSTRUMENT
+// Attribute each transaction's traffic to its block
+void Bus::setSharingProfiler(SharingProfiler* profiler) {
+    sharingProfiler = profiler;
+}
+#endif
+
+// Retire the drained write-back buffer entries of every cache
+void Bus::retireWritebacks() {
+    // Judged by the bus's cycle, not each peer's possibly stale clock
+    nextDrain = std::numeric_limits<unsigned int>::max();
+    for (Cache* cache : caches) {
+        cache->retireWritebacks(clock);
+        nextDrain = std::min(nextDrain, cache->getNextWritebackDrain());
+    }
+}
+
+// Peers holding a valid or buffered copy of the block
+unsigned int Bus::countSharers(const Address& addr, int requestingCore) const {
+    if (snoopFilter) {
+        uint64_t others = snoopFilter->getSharers(addr.getBlockAddress())
+                        & ~(uint64_t(1) << requestingCore);
+        return __builtin_popcountll(others);
+    }
+
+    unsigned int setIdx = addr.getIndex();
+    uint32_t tag = addr.getTag();
+    unsigned int sharers = 0;
+    for (int c = 0; c < (int)caches.size(); ++c) {
+        if (c == requestingCore) continue;
+        bool held = false;
+        for (auto& line : caches[c]->getSets()[setIdx].getLines()) {
+            if (line.isValid() && line.getTag() == tag) {
+                held = true;
+                break;
+            }
+        }
+        // A dirty copy waiting in a write-back buffer is invalidated too
+        if (held || caches[c]->isBuffered(addr.getBlockAddress()))
+            sharers++;
+    }
+    return sharers;
+}
+
+// Let one cache snoop the transaction
+template <class Protocol>
+void Bus::snoop(int core, BusTransaction t, const Address& addr, int requestingCore,
+                BusResult& result) {
+    SnoopReply reply;
+    bool held = caches[core]->template snoop<Protocol>(t, addr, requestingCore, reply);
+    if (held && t != BusTransaction::FLUSH) {
+        snoopedHolders |= uint64_t(1) << core;
+        result.shared = true;
+    }
+    if (!functional) {
+        if (reply.supply) dataResponses++;
+        if (reply.writeback) snoopWritebacks++;
+    }
+
+    // The first cache to forward the data supplies it
+    if (reply.supply && !result.dataProvided) {
+        result.dataProvided = true;
+        result.sourceCore = core;
+        result.suppliedLine = reply.line;
+        if (!functional)
+            cacheToCache++;
+    }
+}
+
+// The transaction path of one protocol
+template <class Protocol>
+BusResult Bus::run(BusTransaction t, const Address& addr, int requestingCore) {
+    BusResult result;
+
+    // Writebacks that have drained by now can no longer be snooped
+    if (writebackBuffers && clock >= nextDrain)
+        retireWritebacks();
+
+    // --- 1) Account for and reserve the bus ---
+    TransactionCost cost = Protocol::cost(t, blockSize);
+    if (functional) {
+        cost.dataBytes = 0;
+    } else {
+        invalidations += cost.invalidations;
+        if (cost.invalidatesSharers)
+            invalidations += countSharers(addr, requestingCore);
+        trafficBytes += cost.dataBytes;
+        // A split bus is scheduled by the requesting cache, phase by phase
+        if (!timing.isSplit())
+            timing.reserve(clock, cost.busCycles);
+    }
+#ifdef L1SIM_INSTRUMENT
+    if (sharingProfiler)
+        sharingProfiler->recordTraffic(addr.getBlockAddress(), cost.dataBytes);
+#endif
+
+    // --- 2) Snooping: let every *other* cache react ---
+    if (l2 && l2->isInclusive() && t != BusTransaction::FLUSH &&
+        !l2->contains(addr.getBlockAddress())) {
+        // Not in the inclusive L2, so in no L1 either: nobody to snoop
+        l2->noteFilteredSnoop();
+    } else if (snoopFilter) {
+        // Only caches holding a valid copy can react; visit them in core
+        // order (mask taken up front, since invalidations update the filter)
+        uint64_t targets = snoopFilter->getSharers(addr.getBlockAddress())
+                         & ~(uint64_t(1) << requestingCore);
+        while (targets) {
+            snoop<Protocol>(__builtin_ctzll(targets), t, addr, requestingCore, result);
+            targets &= targets - 1;
+        }
+    } else {
+        for (int core = 0; core < (int)caches.size(); ++core) {
+            if (core == requestingCore) continue;
+            snoop<Protocol>(core, t, addr, requestingCore, result);
+        }
+    }
+    return result;
+}
+
+// Run one transaction from requestingCore's cache
+BusResult Bus::transact(BusTransaction t, const Address& addr, int requestingCore) {
+    switch (protocol) {
+    case CoherenceProtocol::MOESI: return run<MoesiProtocol>(t, addr, requestingCore);
+    case CoherenceProtocol::MESIF: return run<MesifProtocol>(t, addr, requestingCore);
+    default:                       return run<MesiProtocol>(t, addr, requestingCore);
+    }
+}
+
+// State a block fetched by a read is installed in
+MESIState Bus::readFillState(const BusResult& result) const {
+    switch (protocol) {
+    case CoherenceProtocol::MOESI: return MoesiProtocol::readFill(result.shared, result.dataProvided);
+    case CoherenceProtocol::MESIF: return MesifProtocol::readFill(result.shared, result.dataProvided);
+    default:                       return MesiProtocol::readFill(result.shared, result.dataProvided);
+    }
+}
+
+// A demand miss's fill took `cycles`
+void Bus::recordFill(bool fromCache, unsigned int cycles) {
+    if (functional) return;
+    if (fromCache) {
+        cacheFills++;
+        cacheFillCycles += cycles;
+    } else {
+        memoryFills++;
+        memoryFillCycles += cycles;
+    }
+}
+
+// Cores that held the block of a transaction since the last call; clears it
+uint64_t Bus::takeSnoopedHolders() {
+    uint64_t holders = snoopedHolders;
+    snoopedHolders = 0;
+    return holders;
+}
+
+// Statistics
+uint64_t Bus::getInvalidationCount() const {
+    return invalidations;
+}
+
+uint64_t Bus::getTrafficBytes() const {
+    return trafficBytes;
+}
+
+uint64_t Bus::getCacheToCacheTransfers() const {
+    return cacheToCache;
+}
+
+uint64_t Bus::getDataResponses() const {
+    return dataResponses;
+}
+
+uint64_t Bus::getSnoopWritebacks() const {
+    return snoopWritebacks;
+}
+
+uint64_t Bus::getCacheFills() const {
+    return cacheFills;
+}
+
+uint64_t Bus::getCacheFillCycles() const {
+    return cacheFillCycles;
+}
+
+uint64_t Bus::getMemoryFills() const {
+    return memoryFills;
+}
+
+uint64_t Bus::getMemoryFillCycles() const {
+    return memoryFillCycles;
+}
+
+unsigned int Bus::getBlockSize() const {
+    return blockSize;
+}
+
+// Checkpoint the statistics
+void Bus::saveState(CheckpointWriter& out) const {
+    out.put(invalidations);
+    out.put(trafficBytes);
+    out.put(cacheToCache);
+    out.put(dataResponses);
+    out.put(snoopWritebacks);
+    out.put(cacheFills);
+    out.put(cacheFillCycles);
+    out.put(memoryFills);
+    out.put(memoryFillCycles);
+}
+
+// Restore the statistics (buffered writebacks are rechecked on the next transaction)
+void Bus::loadState(CheckpointReader& in) {
+    invalidations = in.get<uint64_t>();
+    trafficBytes = in.get<uint64_t>();
+    cacheToCache = in.get<uint64_t>();
+    dataResponses = in.get<uint64_t>();
+    snoopWritebacks = in.get<uint64_t>();
+    cacheFills = in.get<uint64_t>();
+    cacheFillCycles = in.get<uint64_t>();
+    memoryFills = in.get<uint64_t>();
+    memoryFillCycles = in.get<uint64_t>();
+    nextDrain = 0;
+}
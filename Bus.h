@@ -0,0 +1,265 @@
+#ifndef BUS_H
+#define BUS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Address.h"
+#include "CacheLine.h"
+
+class Cache;
+class BusModel;
+class SnoopFilter;
+class L2Cache;
+class SharingProfiler;
+class CheckpointWriter;
+class CheckpointReader;
+
+// Bus transaction types for coherence protocol
+enum class BusTransaction {
+    BUS_RD,     // Bus Read (for shared copy)
+    BUS_RDX,    // Bus Read Exclusive (for exclusive copy)
+    BUS_UPGR,   // Bus Upgrade (from shared to modified)
+    FLUSH,      // Flush (writing back dirty block)
+    INVALIDATE  // Invalidate other copies
+};
+
+// Coherence protocols the bus can run
+enum class CoherenceProtocol { MESI, MOESI, MESIF };
+
+// What a transaction costs on the bus
+struct TransactionCost {
+    unsigned int busCycles;      // Atomic bus reservation length
+    unsigned int dataBytes;      // Bytes moved (bus traffic)
+    unsigned int invalidations;  // Counted per transaction
+    bool invalidatesSharers;     // Also count every peer holding a copy
+};
+
+// How a cache holding a block in some state reacts to a snooped transaction
+struct SnoopAction {
+    bool held;          // The transaction concerns this copy
+    MESIState next;     // State it moves to
+    bool supply;        // Provides the block's data
+    bool writeback;     // Writes the block to memory first
+};
+
+// How one snooping cache answered a transaction
+struct SnoopReply {
+    bool supply = false;
+    bool writeback = false;
+    const CacheLine* line = nullptr;   // Supplier's line (nullptr: the data is in memory)
+};
+
+// Outcome of a transaction for the requesting cache
+struct BusResult {
+    bool dataProvided = false;         // A peer supplies the block
+    int sourceCore = -1;               // ... the first one that did
+    bool shared = false;               // Some peer held a valid copy
+    const CacheLine* suppliedLine = nullptr;   // Supplier's line, as it was handed over
+};
+
+// Protocols are policy types holding constant tables, so each protocol's
+// transaction path (Bus::run, Cache::snoop) compiles its lookups inline.
+// SNOOP is indexed [transaction][state] in enum order; a block installed by
+// a read miss takes readFill(shared, supplied).
+struct SnoopingProtocol {
+    static constexpr MESIState M = MESIState::MODIFIED;
+    static constexpr MESIState E = MESIState::EXCLUSIVE;
+    static constexpr MESIState S = MESIState::SHARED;
+    static constexpr MESIState I = MESIState::INVALID;
+    static constexpr MESIState O = MESIState::OWNED;
+    static constexpr MESIState F = MESIState::FORWARD;
+
+    // A copy that reacts: its next state, whether it supplies, whether it writes back
+    static constexpr SnoopAction to(MESIState next, bool supply, bool writeback) {
+        return {true, next, supply, writeback};
+    }
+    // A copy the transaction does not concern
+    static constexpr SnoopAction ignore(MESIState state) {
+        return {false, state, false, false};
+    }
+
+    // Cost of one transaction for a block of blockSize bytes (the same bus for every protocol)
+    static TransactionCost cost(BusTransaction t, unsigned int blockSize) {
+        switch (t) {
+        case BusTransaction::BUS_RD:     return {2 * (blockSize / 4), blockSize, 0, false};
+        case BusTransaction::BUS_RDX:    return {2 * (blockSize / 4), blockSize, 0, true};
+        case BusTransaction::BUS_UPGR:   return {2, 0, 1, false};
+        case BusTransaction::INVALIDATE: return {2, 0, 1, false};
+        case BusTransaction::FLUSH:      return {100, blockSize, 0, false};
+        }
+        return {0, 0, 0, false};
+    }
+};
+
+// MESI: every copy answers a read; a modified one is written back to memory
+// and shared from then on.
+struct MesiProtocol : SnoopingProtocol {
+    static constexpr SnoopAction SNOOP[5][6] = {
+        //            M                  E                  S                  I          O          F
+        /* BUS_RD  */ {to(S, true, true), to(S, true, false), to(S, true, false), ignore(I), ignore(O), ignore(F)},
+        /* BUS_RDX */ {to(I, true, true), to(I, false, false), to(I, false, false), ignore(I), ignore(O), ignore(F)},
+        /* UPGR    */ {ignore(M), ignore(E), to(I, false, false), ignore(I), ignore(O), ignore(F)},
+        /* FLUSH   */ {to(M, false, false), to(E, false, false), to(S, false, false), ignore(I), to(O, false, false), to(F, false, false)},
+        /* INVAL   */ {to(I, true, true), to(I, false, false), to(I, false, false), ignore(I), ignore(O), ignore(F)},
+    };
+
+    static MESIState readFill(bool shared, bool supplied) {
+        (void)shared;
+        return supplied ? S : E;
+    }
+};
+
+// MOESI: a modified copy that is read becomes OWNED and keeps supplying the
+// dirty block, so memory is only written when the owner evicts it; a write
+// miss takes the dirty data (and the duty to write it back) from M or O.
+struct MoesiProtocol : SnoopingProtocol {
+    static constexpr SnoopAction SNOOP[5][6] = {
+        //            M                   E                   S                   I          O                   F
+        /* BUS_RD  */ {to(O, true, false), to(S, true, false), to(S, true, false), ignore(I), to(O, true, false), ignore(F)},
+        /* BUS_RDX */ {to(I, true, false), to(I, false, false), to(I, false, false), ignore(I), to(I, true, false), ignore(F)},
+        /* UPGR    */ {ignore(M), ignore(E), to(I, false, false), ignore(I), to(I, false, false), ignore(F)},
+        /* FLUSH   */ {to(M, false, false), to(E, false, false), to(S, false, false), ignore(I), to(O, false, false), to(F, false, false)},
+        /* INVAL   */ {to(I, true, false), to(I, false, false), to(I, false, false), ignore(I), to(I, true, false), ignore(F)},
+    };
+
+    static MESIState readFill(bool shared, bool supplied) {
+        (void)shared;
+        return supplied ? S : E;
+    }
+};
+
+// MESIF: of the clean copies only the FORWARD one answers, and the newest
+// reader takes that role, so a read gets one response instead of one per
+// sharer. With only SHARED copies left (the forwarder evicted), memory
+// supplies.
+struct MesifProtocol : SnoopingProtocol {
+    static constexpr SnoopAction SNOOP[5][6] = {
+        //            M                  E                   S                   I          O          F
+        /* BUS_RD  */ {to(S, true, true), to(S, true, false), to(S, false, false), ignore(I), ignore(O), to(S, true, false)},
+        /* BUS_RDX */ {to(I, true, true), to(I, false, false), to(I, false, false), ignore(I), ignore(O), to(I, true, false)},
+        /* UPGR    */ {ignore(M), ignore(E), to(I, false, false), ignore(I), ignore(O), to(I, false, false)},
+        /* FLUSH   */ {to(M, false, false), to(E, false, false), to(S, false, false), ignore(I), to(O, false, false), to(F, false, false)},
+        /* INVAL   */ {to(I, true, true), to(I, false, false), to(I, false, false), ignore(I), ignore(O), to(I, true, false)},
+    };
+
+    static MESIState readFill(bool shared, bool supplied) {
+        (void)supplied;
+        return shared ? F : E;
+    }
+};
+
+// The shared snooping bus between the L1 caches.
+//
+// A cache hands each transaction to transact(); the bus accounts for it
+// (traffic, invalidations, cache-to-cache transfers), reserves an atomic bus
+// for its length, then lets every other cache that may hold the block snoop
+// it, in core order: all of them, only the snoop filter's sharers, or none
+// when an inclusive L2 shows no L1 has the block. The requester learns
+// synchronously whether a peer supplies the data, since it installs the
+// block in the same cycle.
+//
+// The protocol is fixed at construction; transact() switches on it once and
+// runs that protocol's instantiation of the transaction path.
+//
+// Drained write-back buffer entries stop being snoopable. The bus retires
+// them across all caches only once some entry can have finished (it tracks
+// the earliest drain cycle), rather than sweeping every cache on every
+// transaction.
+class Bus {
+public:
+    // Parse "mesi", "moesi" or "mesif"; returns false for anything else
+    static bool parseProtocol(const std::string& name, CoherenceProtocol& protocol);
+
+    // Name of a protocol for reports
+    static const char* protocolName(CoherenceProtocol protocol);
+
+    // Constructor - caches indexed by core id; `clock` is the simulator's
+    // cycle, which times reservations and writeback retirement
+    Bus(CoherenceProtocol protocol, const std::vector<Cache*>& caches, BusModel& timing,
+        unsigned int blockSize, const unsigned int& clock);
+
+    CoherenceProtocol getProtocol() const;
+
+    // Directory of sharers to snoop instead of every cache (nullptr = none)
+    void setSnoopFilter(SnoopFilter* filter);
+    // Shared L2; an inclusive one filters snoops of blocks no L1 holds (nullptr = none)
+    void setL2(L2Cache* cache);
+    // Caches buffer writebacks, so drained entries must be retired
+    void setWritebackBuffers(bool enabled);
+    // A buffered entry of some cache finishes draining at `cycle`
+    void noteWriteback(unsigned int cycle);
+    // Functional warming: snoop as usual, but count nothing and reserve no bus time
+    void setFunctional(bool enabled);
+#ifdef L1SIM_INSTRUMENT
+    // Attribute each transaction's traffic to its block (nullptr = none)
+    void setSharingProfiler(SharingProfiler* profiler);
+#endif
+
+    // Run one transaction from requestingCore's cache
+    BusResult transact(BusTransaction t, const Address& addr, int requestingCore);
+
+    // State a block fetched by a read (BUS_RD) is installed in
+    MESIState readFillState(const BusResult& result) const;
+
+    // A demand miss's fill took `cycles` (from a peer or the write-back buffer, or from memory)
+    void recordFill(bool fromCache, unsigned int cycles);
+
+    // Cores that held the block of a transaction (other than a FLUSH) since
+    // the last call, as a bitmask; clears it
+    uint64_t takeSnoopedHolders();
+
+    // Statistics
+    uint64_t getInvalidationCount() const;
+    uint64_t getTrafficBytes() const;
+    uint64_t getCacheToCacheTransfers() const;
+    uint64_t getDataResponses() const;     // Snooped copies that supplied data (the first counts too)
+    uint64_t getSnoopWritebacks() const;   // Blocks written to memory by a snooped transaction
+    uint64_t getCacheFills() const;
+    uint64_t getCacheFillCycles() const;
+    uint64_t getMemoryFills() const;
+    uint64_t getMemoryFillCycles() const;
+    unsigned int getBlockSize() const;
+
+    // Checkpoint the statistics
+    void saveState(CheckpointWriter& out) const;
+    void loadState(CheckpointReader& in);
+
+private:
+    // The transaction path of one protocol
+    template <class Protocol>
+    BusResult run(BusTransaction t, const Address& addr, int requestingCore);
+    // Let one cache snoop the transaction
+    template <class Protocol>
+    void snoop(int core, BusTransaction t, const Address& addr, int requestingCore,
+               BusResult& result);
+    // Peers holding a valid or buffered copy of the block
+    unsigned int countSharers(const Address& addr, int requestingCore) const;
+    // Retire the drained write-back buffer entries of every cache
+    void retireWritebacks();
+
+    CoherenceProtocol protocol;
+    const std::vector<Cache*>& caches;
+    BusModel& timing;
+    unsigned int blockSize;
+    const unsigned int& clock;
+    SnoopFilter* snoopFilter;
+    L2Cache* l2;
+    SharingProfiler* sharingProfiler;
+    bool writebackBuffers;
+    unsigned int nextDrain;       // No buffered entry finishes before this cycle
+    bool functional;
+    uint64_t snoopedHolders;
+
+    uint64_t invalidations;
+    uint64_t trafficBytes;
+    uint64_t cacheToCache;
+    uint64_t dataResponses;
+    uint64_t snoopWritebacks;
+    uint64_t cacheFills;
+    uint64_t cacheFillCycles;
+    uint64_t memoryFills;
+    uint64_t memoryFillCycles;
+};
+
+#endif // BUS_H
@@ -0,0 +1,159 @@
+#include "BusModel.h"
+#include "Checkpoint.h"
+#include <algorithm>
+
+// Constructor
+BusModel::BusModel(Mode mode, int blockSize, unsigned int memoryBanks)
+    : mode(mode), blockSize(blockSize), transferCycles(2 * (blockSize / 4)), busyUntil(0),
+      requestFree(0), bankFree(std::max(1u, memoryBanks), 0),
+      transactions(0), queueCycles(0), maxQueueDelay(0) {
+}
+
+// Parse "atomic" or "split"
+bool BusModel::parseMode(const std::string& name, Mode& result) {
+    if (name == "atomic") { result = Mode::ATOMIC; return true; }
+    if (name == "split")  { result = Mode::SPLIT;  return true; }
+    return false;
+}
+
+// Atomic: hold the bus for the transaction's full length
+unsigned int BusModel::reserve(unsigned int cycle, unsigned int length) {
+    unsigned int start = std::max(cycle, busyUntil);
+    busyUntil = start + length;
+    account(start - cycle);
+    return start;
+}
+
+// Address-bus phase
+unsigned int BusModel::requestPhase(unsigned int cycle, unsigned int& waited) {
+    unsigned int start = std::max(cycle, requestFree);
+    waited += start - cycle;
+    requestFree = start + REQUEST_CYCLES;
+    return requestFree;
+}
+
+// Data-bus phase: the first gap of transferCycles at or after `cycle`. A
+// transfer may slot in ahead of one reserved for later (a cache-to-cache
+// response overtaking a memory fill still in its bank).
+unsigned int BusModel::dataPhase(unsigned int cycle, unsigned int& waited) {
+    unsigned int start = cycle;
+    size_t pos = 0;
+    for (; pos < dataSlots.size(); pos++) {
+        const Slot& slot = dataSlots[pos];
+        if (slot.end <= start) continue;
+        if (slot.start >= start + transferCycles) break;
+        start = slot.end;
+    }
+    waited += start - cycle;
+    dataSlots.insert(dataSlots.begin() + pos, Slot{start, start + transferCycles});
+    return start + transferCycles;
+}
+
+// Forget data-bus reservations that ended before `cycle`
+void BusModel::retire(unsigned int cycle) {
+    size_t done = 0;
+    while (done < dataSlots.size() && dataSlots[done].end <= cycle) done++;
+    if (done) dataSlots.erase(dataSlots.begin(), dataSlots.begin() + done);
+}
+
+// Split: a block fill from a peer cache or from memory
+unsigned int BusModel::scheduleFill(unsigned int cycle, uint32_t blockAddress, bool fromCache) {
+    retire(cycle);
+    unsigned int waited = 0;
+    unsigned int ready = requestPhase(cycle, waited);
+    if (!fromCache) {
+        unsigned int& bank = bankFree[blockAddress / blockSize % bankFree.size()];
+        unsigned int start = std::max(ready, bank);
+        waited += start - ready;
+        bank = start + MEMORY_LATENCY;
+        ready = bank;
+    }
+    unsigned int done = dataPhase(ready, waited);
+    account(waited);
+    return done;
+}
+
+// Split: a writeback; the bank absorbs the block after it has left the cache
+unsigned int BusModel::scheduleWriteback(unsigned int cycle, uint32_t blockAddress) {
+    retire(cycle);
+    unsigned int waited = 0;
+    unsigned int sent = dataPhase(requestPhase(cycle, waited), waited);
+    unsigned int& bank = bankFree[blockAddress / blockSize % bankFree.size()];
+    bank = std::max(sent, bank) + MEMORY_LATENCY;
+    account(waited);
+    return sent;
+}
+
+// Split: an address-only transaction
+void BusModel::scheduleControl(unsigned int cycle) {
+    unsigned int waited = 0;
+    requestPhase(cycle, waited);
+    account(waited);
+}
+
+// Note one finished transaction's total wait
+void BusModel::account(unsigned int waited) {
+    transactions++;
+    queueCycles += waited;
+    maxQueueDelay = std::max(maxQueueDelay, waited);
+}
+
+// Cycle until which the bus is known to be busy
+unsigned int BusModel::getBusyUntil() const {
+    if (mode == Mode::ATOMIC) {
+        return busyUntil;
+    }
+    return dataSlots.empty() ? requestFree : std::max(requestFree, dataSlots.back().end);
+}
+
+// Transactions seen
+uint64_t BusModel::getTransactionCount() const {
+    return transactions;
+}
+
+// Total cycles transactions waited for a resource
+uint64_t BusModel::getQueueCycles() const {
+    return queueCycles;
+}
+
+// Longest wait of a single transaction
+unsigned int BusModel::getMaxQueueDelay() const {
+    return maxQueueDelay;
+}
+
+// Get the bus mode
+BusModel::Mode BusModel::getMode() const {
+    return mode;
+}
+
+// Check for the split-transaction model
+bool BusModel::isSplit() const {
+    return mode == Mode::SPLIT;
+}
+
+// Get the number of memory banks
+unsigned int BusModel::getMemoryBanks() const {
+    return static_cast<unsigned int>(bankFree.size());
+}
+
+// Checkpoint the reservations and queueing statistics
+void BusModel::saveState(CheckpointWriter& out) const {
+    out.put(busyUntil);
+    out.put(requestFree);
+    out.putVector(dataSlots);
+    out.putVector(bankFree);
+    out.put(transactions);
+    out.put(queueCycles);
+    out.put(maxQueueDelay);
+}
+
+// Restore the reservations and queueing statistics
+void BusModel::loadState(CheckpointReader& in) {
+    busyUntil = in.get<unsigned int>();
+    requestFree = in.get<unsigned int>();
+    dataSlots = in.getVector<Slot>();
+    in.getVectorInto(bankFree);
+    transactions = in.get<uint64_t>();
+    queueCycles = in.get<uint64_t>();
+    maxQueueDelay = in.get<unsigned int>();
+}
@@ -0,0 +1,101 @@
+#ifndef BUS_MODEL_H
+#define BUS_MODEL_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class CheckpointWriter;
+class CheckpointReader;
+
+// Timing of the shared bus and the memory behind it.
+//
+// ATOMIC is the original model: every transaction reserves the whole bus
+// for its full length (a FLUSH for 100 cycles) and fill latencies are fixed
+// by the caches, so the reservation never delays anything; it only tells
+// the event-driven loop when the bus is busy.
+//
+// SPLIT separates each transaction into phases on independent resources:
+//   request : 1 cycle on the address bus (one request per cycle)
+//   memory  : the block's bank (block address modulo banks) is busy for the
+//             memory latency; other banks and both buses keep working
+//   data    : 2 cycles per word on the data bus, in the first free gap
+// A fill from memory is request -> memory -> data, a cache-to-cache fill
+// request -> data, a writeback request -> data (the bank write then happens
+// behind the cache's back), an upgrade or invalidate only a request. Each
+// phase waits for its resource; those waits are the queueing delay.
+class BusModel {
+public:
+    enum class Mode { ATOMIC, SPLIT };
+
+    // Defaults of the original model
+    static const unsigned int MEMORY_LATENCY = 100;
+    static const unsigned int REQUEST_CYCLES = 1;
+
+    // Constructor
+    BusModel(Mode mode, int blockSize, unsigned int memoryBanks = 1);
+
+    // Parse "atomic" or "split"; returns false for anything else
+    static bool parseMode(const std::string& name, Mode& mode);
+
+    // Atomic: hold the bus for `length` cycles from the first free cycle at or
+    // after `cycle`; returns the start cycle
+    unsigned int reserve(unsigned int cycle, unsigned int length);
+
+    // Split: a block fill requested at `cycle`; returns the cycle its last word arrives
+    unsigned int scheduleFill(unsigned int cycle, uint32_t blockAddress, bool fromCache);
+
+    // Split: a dirty block written back at `cycle`; returns the cycle it has left the cache
+    unsigned int scheduleWriteback(unsigned int cycle, uint32_t blockAddress);
+
+    // Split: an address-only transaction (upgrade, invalidate) at `cycle`
+    void scheduleControl(unsigned int cycle);
+
+    // Cycle until which the bus is known to be busy (event-driven loop)
+    unsigned int getBusyUntil() const;
+
+    // Queueing statistics
+    uint64_t getTransactionCount() const;
+    uint64_t getQueueCycles() const;      // Total cycles transactions waited for a resource
+    unsigned int getMaxQueueDelay() const;
+
+    Mode getMode() const;
+    bool isSplit() const;
+    unsigned int getMemoryBanks() const;
+
+    // Checkpoint the reservations and queueing statistics (same mode and banks on load)
+    void saveState(CheckpointWriter& out) const;
+    void loadState(CheckpointReader& in);
+
+private:
+    // Address-bus phase; returns the cycle after it
+    unsigned int requestPhase(unsigned int cycle, unsigned int& waited);
+
+    // Data-bus phase for a block ready at `cycle`; returns the cycle after it
+    unsigned int dataPhase(unsigned int cycle, unsigned int& waited);
+
+    // Forget data-bus reservations that ended before `cycle`
+    void retire(unsigned int cycle);
+
+    // Note one finished transaction's total wait
+    void account(unsigned int waited);
+
+    Mode mode;
+    unsigned int blockSize;
+    unsigned int transferCycles;          // 2 cycles per word of a block
+    unsigned int busyUntil;               // Atomic reservation
+    unsigned int requestFree;             // First cycle the address bus is free
+    // Reserved data-bus transfers, in time order
+    struct Slot {
+        unsigned int start;
+        unsigned int end;
+    };
+    std::vector<Slot> dataSlots;
+    std::vector<unsigned int> bankFree;   // First cycle each memory bank is free
+
+    uint64_t transactions;
+    uint64_t queueCycles;
+    unsigned int maxQueueDelay;
+};
+
+#endif // BUS_MODEL_H
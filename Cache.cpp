@@ -1,453 +1,1172 @@
-#include "Cache.h"
-#include <iostream>
-
-// Constructor: set up each cache set and initialize counters
-Cache::Cache(int coreId,
-             int numSets,
-             int associativity,
-             int blockSize,
-             int setBits,
-             int blockBits,
-             MainMemory& mainMemory)
-    : coreId(coreId)
-    , mainMemory(mainMemory)
-    , setBits(setBits)
-    , blockBits(blockBits)
-    , numSets(numSets)
-    , blockSize(blockSize)
-    , associativity(associativity)
-    , accessCount(0)
-    , hitCount(0)
-    , missCount(0)
-    , readCount(0)
-    , writeCount(0)
-    , coherenceCount(0)
-    , pendingMiss(false)
-    , missResolveTime(0)
-    , currentCycle(0)
-    , dataSourceCache(-1)
-{
-    // Allocate and initialize each cache set
-    sets.reserve(numSets);
-    for (int i = 0; i < numSets; ++i) {
-        sets.emplace_back(associativity, blockSize);
-    }
-}
-
-// Read operation: returns true on hit (1 cycle), false on miss (blocks processor)
-bool Cache::read(const Address& addr) {
-    accessCount++;
-    readCount++;
-
-    // Stall if a previous miss is unresolved
-    if (pendingMiss) {
-        return false;
-    }
-
-    // Decode address: set index, tag
-    uint32_t setIndex = addr.getIndex();
-    uint32_t tag      = addr.getTag();
-    
-    // Bounds check
-    if (setIndex >= sets.size()) {
-        std::cerr << "Cache::read(): setIndex out of range: " << setIndex << std::endl;
-        return false;
-    }
-
-    CacheSet& cacheSet = sets[setIndex];
-    CacheLine* line    = cacheSet.findLine(tag);
-    
-    
-    if (line) {
-        // CACHE HIT
-        hitCount++;
-        cacheSet.updateLRU(line);
-        // No MESI state change required on read hit
-        return true;
-    }
-
-    // CACHE MISS: begin block fill
-    missCount++;
-    pendingMiss     = true;
-    dataSourceCache = -1;
-
-    // Select victim line (invalid preferred, else LRU)
-    CacheLine* victim = cacheSet.findVictim();
-    if (victim ->isValid()) {
-        evictionCount++;
-        if (victim -> isDirty()) {
-            writebackCount++;
-        }
-    }
-    // If victim is dirty (Modified), write back to memory first
-    if (victim->isValid() && victim->isDirty()) {
-        uint32_t victimTag       = victim->getTag();
-        uint32_t victimBlockAddr = (victimTag << (setBits + blockBits))
-                                    | (setIndex << blockBits);
-
-        // Notify others of flush
-        Address flushAddr(victimBlockAddr, setBits, blockBits);
-        bool dummyProvided = false;
-        int  dummySource   = -1;
-        issueCoherenceRequest(BusTransaction::FLUSH, flushAddr, dummyProvided, dummySource);
-
-        // Write back to memory (100-cycle penalty)
-        mainMemory.writeBlock(victimBlockAddr, victim->getData());
-        missResolveTime = currentCycle + 100;
-    } else {
-        missResolveTime = currentCycle;
-    }
-
-    // Issue BusRd to probe other caches
-    bool providedByPeer = false;
-    int  peerId         = -1;
-    issueCoherenceRequest(BusTransaction::BUS_RD, addr, providedByPeer, peerId);
-    
-    // Set data source based on whether another cache provided the data
-    if (providedByPeer) {
-        dataSourceCache = peerId;
-    }
-
-    // Decide MESI state: SHARED if any peer had it, else EXCLUSIVE
-    MESIState newState = (dataSourceCache >= 0)
-                        ? MESIState::SHARED
-                        : MESIState::EXCLUSIVE;
-
-    // Timing: 2 cycles/word if from cache, else 100 cycles memory
-    if (dataSourceCache >= 0) {
-        
-        int numWords = blockSize / 4;
-        missResolveTime += 2 * numWords;
-    } else {
-        
-        missResolveTime += 100;
-    }
-    
-    // Fetch block (data only, timing handled separately)
-    std::vector<uint8_t> data = fetchBlockFromMemoryOrCache(addr, newState);
-
-    // Install block into cache line
-    victim->loadData(data, tag, newState);
-
-    return false;  // processor must stall until miss resolves
-}
-
-// Write operation: returns true on hit, false on miss (blocks processor)
-bool Cache::write(const Address& addr) {
-    accessCount++;
-    writeCount++;
-
-    if (pendingMiss) {
-        return false;
-    }
-
-    uint32_t setIndex = addr.getIndex();
-    uint32_t tag      = addr.getTag();
-    uint32_t offset   = addr.getOffset();
-
-    
-
-    if (setIndex >= sets.size()) {
-        std::cerr << "Cache::write(): setIndex out of range: " << setIndex << std::endl;
-        return false;
-    }
-
-    CacheSet& cacheSet = sets[setIndex];
-    CacheLine* line    = cacheSet.findLine(tag);
-
-    if (line) {
-        // WRITE HIT
-        hitCount++;
-        cacheSet.updateLRU(line);
-
-        MESIState curState = line->getMESIState();
-        if (curState == MESIState::SHARED || curState == MESIState::EXCLUSIVE) {
-            
-                  
-            // Need to invalidate other copies if in SHARED state
-            if (curState == MESIState::SHARED) {
-                // Invalidate other sharers
-                bool dummyProvided = false;
-                int  dummySource   = -1;
-                issueCoherenceRequest(BusTransaction::BUS_UPGR, addr, dummyProvided, dummySource);
-                // BUS_UPGR: 2-cycle bus transfer (no stall)
-            }
-            
-            // Transition directly to MODIFIED
-            line->setMESIState(MESIState::MODIFIED);
-        }
-        // If already MODIFIED, no state change needed
-
-        // Perform write 
-        uint32_t wordOffset = offset & ~0x3;
-        uint32_t dummyData  = 0xDEADBEEF;
-        line->writeWord(wordOffset, dummyData);
-        return true;
-    }
-
-    // WRITE MISS (write-allocate)
-    missCount++;
-    pendingMiss     = true;
-    dataSourceCache = -1;
-
-   
-
-    CacheLine* victim = cacheSet.findVictim();
-    if (victim ->isValid()) {
-        evictionCount++;
-        if (victim -> isDirty()) {
-            writebackCount++;
-        }
-    }
-    if (victim->isValid() && victim->isDirty()) {
-
-        uint32_t victimTag       = victim->getTag();
-        uint32_t victimBlockAddr = (victimTag << (setBits + blockBits))
-                                    | (setIndex << blockBits);
-
-        Address flushAddr(victimBlockAddr, setBits, blockBits);
-        bool dummyProvided = false;
-        int  dummySource   = -1;
-        issueCoherenceRequest(BusTransaction::FLUSH, flushAddr, dummyProvided, dummySource);
-        
-        
-                  
-        mainMemory.writeBlock(victimBlockAddr, victim->getData());
-        missResolveTime = currentCycle + 100;
-    } else {
-        missResolveTime = currentCycle;
-    }
-
-    // Request exclusive ownership
-    bool providedByPeer = false;
-    int  peerId         = -1;
-    issueCoherenceRequest(BusTransaction::BUS_RDX, addr, providedByPeer, peerId);
-    
-    if (providedByPeer) {
-        dataSourceCache = peerId;
-        
-    } else {
-        // Important: Check if any other cache had data that they wrote back and invalidated
-        // This is necessary because BUS_RDX causes all other caches to invalidate their copies
-        // without transferring data directly to us, even if they've written back to memory
-        for (int i = 0; i < (int)allCaches.size(); i++) {
-            if (i == coreId) continue;
-            
-            Cache* otherCache = allCaches[i];
-            auto& sets = otherCache->getSets();
-            
-            // If we can find an invalidated entry, mark it as the source
-            // so we don't go to DRAM unnecessarily
-            if (addr.getIndex() < sets.size()) {
-                auto& lines = sets[addr.getIndex()].getLines();
-                for (auto& line : lines) {
-                    if (!line.isValid() && line.getTag() == addr.getTag()) {
-                        
-                        dataSourceCache = i;
-                        break;
-                    }
-                }
-            }
-            if (dataSourceCache >= 0) break;
-        }
-    }
-
-    // We will modify, so set as MODIFIED
-    MESIState newState = MESIState::MODIFIED;
-    auto data = fetchBlockFromMemoryOrCache(addr, newState);
-
-    // Calculate timing for data transfer
-    if (dataSourceCache >= 0) {
-        int numWords = blockSize / 4;
-        missResolveTime += 2 * numWords;
-    } else {
-        missResolveTime += 100;
-    }
-
-    // Install block and perform write
-    victim->loadData(data, tag, newState);
-    uint32_t wordOffset = offset & ~0x3;
-    uint32_t dummyData  = 0xDEADBEEF;
-    victim->writeWord(wordOffset, dummyData);
-
-    return false;
-}
-
-// Check if a pending miss has completed
-bool Cache::checkMissResolved() {
-    if (pendingMiss && currentCycle >= missResolveTime) {
-        pendingMiss = false;
-        return true;
-    }
-    return false;
-}
-
-// Advance the cycle
-void Cache::setCycle(unsigned int cycle) {
-    currentCycle = cycle;
-}
-
-// Provide simulator's coherence callback
-void Cache::setCoherenceCallback(const CoherenceCallback& cb) {
-    coherenceCallback = cb;
-}
-
-// Issue a bus transaction to other caches
-void Cache::issueCoherenceRequest(BusTransaction transType,
-                                  const Address& addr,
-                                  bool& dataProvided,
-                                  int& sourceCache)
-{
-    if (coherenceCallback) {
-        coherenceCallback(transType, addr, coreId, dataProvided, sourceCache);
-        coherenceCount++;
-    }
-}
-
-// Fetch a block's bytes from cache or memory
-std::vector<uint8_t> Cache::fetchBlockFromMemoryOrCache(const Address& addr,
-    MESIState& state)
-{
-    uint32_t blockAddr = addr.getBlockAddress();
-
-    // 1) If some peer supplied it, get from cache
-    if (dataSourceCache >= 0 && dataSourceCache < (int)allCaches.size()) {
-        
-                
-        Cache* supplier = allCaches[dataSourceCache];
-        auto& sets = supplier->getSets();
-        if (addr.getIndex() < sets.size()) {
-            auto& lines = sets[addr.getIndex()].getLines();
-            
-            for (auto& line : lines) {
-                if (line.isValid() && line.getTag() == addr.getTag()) {
-                    return line.getData();
-                }
-            }
-        }
-        
-        // Fallback if peer data not found (shouldn't happen if coherence works correctly)
-        
-    }
-    
-    // 2) Otherwise, fetch from main memory
-   
-            
-    return mainMemory.readBlock(blockAddr);
-}
-
-// Handle a snooped bus transaction from another cache
-bool Cache::handleBusTransaction(BusTransaction transType,
-                                 const Address& addr,
-                                 int requestingCore,
-                                 bool& providedData)
-{
-    uint32_t setIndex = addr.getIndex();
-    uint32_t tag      = addr.getTag();
-
-    if (setIndex >= sets.size()) return false;
-
-    CacheSet& set   = sets[setIndex];
-    CacheLine* line = set.findLine(tag);
-    if (!line) return false;  // No matching line in this cache
-
-    MESIState curState = line->getMESIState();
-    
-    
-    
-    switch (transType) {
-      case BusTransaction::BUS_RD:
-        // Another cache wants to read this data
-        if (curState == MESIState::MODIFIED) {
-            // Need to write back modified data and transition to SHARED
-            
-                  
-            mainMemory.writeBlock(addr.getBlockAddress(), line->getData());
-            line->setMESIState(MESIState::SHARED);
-            providedData = true;
-            return true;
-        } else if (curState == MESIState::EXCLUSIVE) {
-            // No need to write back, but transition to SHARED
-            
-                  
-            line->setMESIState(MESIState::SHARED);
-            providedData = true;
-            return true;
-        } else if (curState == MESIState::SHARED) {
-            // Already shared, can provide data
-            providedData = true;
-            return true;
-        }
-        break;
-
-      case BusTransaction::BUS_RDX:
-        // Another cache wants exclusive access
-        if (curState != MESIState::INVALID) {
-            if (curState == MESIState::MODIFIED) {
-                // Write back before invalidating
-                
-                      
-                mainMemory.writeBlock(addr.getBlockAddress(), line->getData());
-                providedData = true;
-            }
-            
-                  
-            line->setMESIState(MESIState::INVALID);
-            return true;
-        }
-        break;
-
-      case BusTransaction::INVALIDATE:
-        // Explicit invalidate request
-        if (curState != MESIState::INVALID) {
-            
-                  
-            if (curState == MESIState::MODIFIED) {
-                // Write back before invalidating
-                mainMemory.writeBlock(addr.getBlockAddress(), line->getData());
-                providedData = true;
-            }
-            
-            line->setMESIState(MESIState::INVALID);
-            return true;
-        }
-        break;
-
-      case BusTransaction::BUS_UPGR:
-        // Another cache wants to upgrade from SHARED to MODIFIED
-        if (curState == MESIState::SHARED) {
-          
-                  
-            // Drop shared copy
-            line->setMESIState(MESIState::INVALID);
-            return true;
-        }
-        break;
-
-      case BusTransaction::FLUSH:
-        // Another core wrote back; no local state change
-      
-              
-        return true;
-    }
-
-    return false;
-}
-
-// Other getters (unchanged)...
-unsigned int Cache::getAccessCount()   const { return accessCount; }
-unsigned int Cache::getHitCount()      const { return hitCount; }
-unsigned int Cache::getMissCount()     const { return missCount; }
-unsigned int Cache::getReadCount()     const { return readCount; }
-unsigned int Cache::getWriteCount()    const { return writeCount; }
-unsigned int Cache::getCoherenceCount()const { return coherenceCount; }
-int          Cache::getSetBits()       const { return setBits; }
-int          Cache::getBlockBits()     const { return blockBits; }
-int          Cache::getCoreId()        const { return coreId; }
-int Cache::getAssociativity() const {
-    return associativity;
-}
-const std::vector<CacheSet>& Cache::getSets() const { return sets; }
-bool Cache::hasPendingMiss() const { return pendingMiss; }
-unsigned int Cache::getEvictionCount() const {return evictionCount; }
-unsigned int Cache::getWritebackCount() const {return writebackCount;}
\ No newline at end of file
+#include "Cache.h"
+#include "Checkpoint.h"
+#include <iostream>
+#include <algorithm>
+#include <limits>
+
+// Constructor: set up each cache set and initialize counters
+Cache::Cache(int coreId,
+             int numSets,
+             int associativity,
+             int blockSize,
+             int setBits,
+             int blockBits,
+             MainMemory& mainMemory,
+             ReplacementPolicy policy)
+    : coreId(coreId)
+    , mainMemory(mainMemory)
+    , setBits(setBits)
+    , blockBits(blockBits)
+    , numSets(numSets)
+    , blockSize(blockSize)
+    , associativity(associativity)
+    , pendingMiss(false)
+    , missResolveTime(0)
+    , currentCycle(0)
+    , dataSourceCache(-1)
+    , suppliedLine(nullptr)
+    , coherenceBus(nullptr)
+    , peerCaches(nullptr)
+    , snoopFilter(nullptr)
+    , splitBus(nullptr)
+    , functional(false)
+    , l2(nullptr)
+    , storeData(mainMemory.storesData())
+    , mshrCount(1)
+    , accessRejected(false)
+    , writebackEntries(0)
+    , writebackDrainEnd(0)
+{
+    // Allocate and initialize each cache set
+    // (tag-only mode: lines carry no payload)
+    sets.reserve(numSets);
+    for (int i = 0; i < numSets; ++i) {
+        sets.emplace_back(associativity, storeData ? blockSize : 0, policy);
+    }
+    selectAccessPath(true);
+}
+
+// Point the access paths at FixedGeometry<SetBits, Ways, BlockBits> if it matches
+template <int SetBits, int Ways, int BlockBits>
+bool Cache::useFixedGeometry() {
+    if (setBits != SetBits || associativity != Ways || blockBits != BlockBits) {
+        return false;
+    }
+    readPath  = &Cache::readAccess<FixedGeometry<SetBits, Ways, BlockBits>>;
+    writePath = &Cache::writeAccess<FixedGeometry<SetBits, Ways, BlockBits>>;
+    fixedGeometry = true;
+    return true;
+}
+
+// Choose the read/write paths: a precompiled geometry (s, E, b) when the
+// configuration is one of them, otherwise the runtime-geometry path
+void Cache::selectAccessPath(bool allowFixed) {
+    readPath  = &Cache::readAccess<RuntimeGeometry>;
+    writePath = &Cache::writeAccess<RuntimeGeometry>;
+    fixedGeometry = false;
+    if (!allowFixed) {
+        return;
+    }
+    useFixedGeometry<6, 2, 5>() || useFixedGeometry<6, 1, 5>() ||
+    useFixedGeometry<6, 4, 5>() || useFixedGeometry<6, 8, 5>() ||
+    useFixedGeometry<5, 2, 5>() || useFixedGeometry<7, 2, 5>() ||
+    useFixedGeometry<6, 2, 4>() || useFixedGeometry<6, 2, 6>();
+}
+
+// Use the precompiled access path for this geometry when there is one
+void Cache::setFixedGeometry(bool enabled) {
+    selectAccessPath(enabled);
+}
+
+// Check if the access paths are a precompiled geometry
+bool Cache::hasFixedGeometry() const {
+    return fixedGeometry;
+}
+
+#ifdef L1SIM_INSTRUMENT
+// Start classifying misses and keeping per-set histograms
+void Cache::enableMissProfile() {
+    missProfiler = std::make_unique<MissProfiler>(numSets, associativity);
+}
+
+// Get the miss profile (nullptr unless enabled)
+const MissProfiler* Cache::getMissProfiler() const {
+    return missProfiler.get();
+}
+
+// Attach the shared per-block sharing attribution
+void Cache::setSharingProfiler(SharingProfiler* profiler) {
+    sharingProfiler = profiler;
+}
+#endif
+
+// Read operation: returns true on hit (1 cycle), false on miss (blocks processor)
+bool Cache::read(const Address& addr) {
+    return (this->*readPath)(addr);
+}
+
+// Write operation: returns true on hit, false on miss (blocks processor)
+bool Cache::write(const Address& addr) {
+    return (this->*writePath)(addr);
+}
+
+// Read body for one geometry type
+template <class Geometry>
+bool Cache::readAccess(const Address& addr) {
+    const Geometry geometry(setBits, associativity, blockBits);
+    if (mshrCount > 1 && !acceptAccess(addr)) {
+        return false;  // Every MSHR busy: reissued once one frees
+    }
+    stats.accesses++;
+    stats.reads++;
+
+    // Stall if a previous miss is unresolved
+    if (pendingMiss) {
+        return false;
+    }
+#ifdef L1SIM_INSTRUMENT
+    if (sharingProfiler) sharingProfiler->recordAccess(coreId, addr.getAddress(), false);
+#endif
+
+    // Decode address: set index, tag
+    uint32_t setIndex = geometry.index(addr.getAddress());
+    uint32_t tag      = geometry.tag(addr.getAddress());
+    
+    // Bounds check
+    if (setIndex >= sets.size()) {
+        std::cerr << "Cache::read(): setIndex out of range: " << setIndex << std::endl;
+        return false;
+    }
+
+    CacheSet& cacheSet = sets[setIndex];
+    CacheLine* line    = geometry.findLine(cacheSet, tag);
+    
+    
+    if (line) {
+        if (mshrCount > 1 && isBlockInFlight(addr.getBlockAddress())) {
+            // Secondary miss: merged into the MSHR already fetching the block
+            stats.misses++;
+            stats.mshrMerges++;
+#ifdef L1SIM_INSTRUMENT
+            if (missProfiler) missProfiler->recordMerge(setIndex, addr.getBlockAddress());
+#endif
+            cacheSet.updateLRU(line);
+            return true;
+        }
+        
+        // CACHE HIT
+        stats.hits++;
+#ifdef L1SIM_INSTRUMENT
+        if (missProfiler) missProfiler->recordHit(setIndex, addr.getBlockAddress());
+#endif
+        cacheSet.updateLRU(line);
+        if (prefetcher && claimPrefetch(addr)) {
+            return false;  // Prefetched block still on its way
+        }
+        // No MESI state change required on read hit
+        return true;
+    }
+
+    // CACHE MISS: begin block fill
+    stats.misses++;
+#ifdef L1SIM_INSTRUMENT
+    if (missProfiler) missProfiler->recordMiss(setIndex, addr.getBlockAddress());
+#endif
+    pendingMiss     = true;
+    dataSourceCache = -1;
+    suppliedLine    = nullptr;
+    bool refill = false;   // Block comes back from this cache's write-back buffer
+    if (writebackEntries) {
+        retireWritebacks(currentCycle);
+        refill = takeWriteback(addr.getBlockAddress());
+        if (refill) stats.wbRefills++;
+    }
+
+    // Select victim line (invalid preferred, else LRU)
+    CacheLine* victim = cacheSet.findVictim();
+    if (victim ->isValid()) {
+        stats.evictions++;
+#ifdef L1SIM_INSTRUMENT
+        if (missProfiler) missProfiler->recordEviction(setIndex);
+#endif
+        if (victim -> isDirty()) {
+            stats.writebacks++;
+        }
+        if (prefetcher) {
+            dropPrefetch((victim->getTag() << (setBits + blockBits)) | (setIndex << blockBits));
+        }
+    }
+    // If victim is dirty (Modified), write back to memory first
+    if (victim->isValid() && victim->isDirty()) {
+        uint32_t victimTag       = victim->getTag();
+        uint32_t victimBlockAddr = (victimTag << (setBits + blockBits))
+                                    | (setIndex << blockBits);
+
+        // Notify others of flush
+        Address flushAddr(victimBlockAddr, setBits, blockBits);
+        issueCoherenceRequest(BusTransaction::FLUSH, flushAddr);
+
+        // Write back to memory (100-cycle penalty)
+        if (writebackEntries) {
+            // Park it in the write-back buffer; the fill waits only for a free entry
+            missResolveTime = bufferWriteback(victimBlockAddr, victim);
+        } else {
+            mainMemory.writeBlock(victimBlockAddr, victim->getData());
+            missResolveTime = writebackDone(victimBlockAddr, currentCycle);
+        }
+        stats.writebackStall += missResolveTime - currentCycle;
+    } else {
+        missResolveTime = currentCycle;
+    }
+
+    // Issue BusRd to probe other caches
+    BusResult result = issueCoherenceRequest(BusTransaction::BUS_RD, addr);
+    
+    // Set data source based on whether another cache provided the data
+    takeDataSource(result);
+
+    // Decide the state (MESI: SHARED if any peer had it, else EXCLUSIVE)
+    MESIState newState = readFillState(result);
+
+    // Timing: 2 cycles/word if from cache, else 100 cycles memory
+    unsigned int fillStart = missResolveTime;
+    bool fromCache = dataSourceCache >= 0 || refill;
+    missResolveTime = fillDone(addr.getBlockAddress(), fromCache, fillStart);
+    if (coherenceBus) coherenceBus->recordFill(fromCache, missResolveTime - fillStart);
+    
+    // Fetch block and install it into the cache line (timing handled above)
+    uint32_t replacedTag = victim->getTag();
+    installBlock(victim, addr, newState);
+    cacheSet.insertLine(victim);
+    if (snoopFilter) {
+        refreshSnoopFilter(setIndex, replacedTag);
+        if (replacedTag != tag) refreshSnoopFilter(setIndex, tag);
+    }
+    if (prefetcher) {
+        runPrefetcher(addr);
+    }
+    if (mshrCount > 1) {
+        // Non-blocking: the fill completes in an MSHR while the core moves on
+        pendingMiss = false;
+        allocateMshr(addr.getBlockAddress(), missResolveTime);
+        return true;
+    }
+
+    return false;  // processor must stall until miss resolves
+}
+
+// Write body for one geometry type
+template <class Geometry>
+bool Cache::writeAccess(const Address& addr) {
+    const Geometry geometry(setBits, associativity, blockBits);
+    if (mshrCount > 1 && !acceptAccess(addr)) {
+        return false;  // Every MSHR busy: reissued once one frees
+    }
+    stats.accesses++;
+    stats.writes++;
+
+    if (pendingMiss) {
+        return false;
+    }
+#ifdef L1SIM_INSTRUMENT
+    if (sharingProfiler) sharingProfiler->recordAccess(coreId, addr.getAddress(), true);
+#endif
+
+    uint32_t setIndex = geometry.index(addr.getAddress());
+    uint32_t tag      = geometry.tag(addr.getAddress());
+    uint32_t offset   = geometry.offset(addr.getAddress());
+
+    
+
+    if (setIndex >= sets.size()) {
+        std::cerr << "Cache::write(): setIndex out of range: " << setIndex << std::endl;
+        return false;
+    }
+
+    CacheSet& cacheSet = sets[setIndex];
+    CacheLine* line    = geometry.findLine(cacheSet, tag);
+
+    if (line) {
+        // WRITE HIT (or, with MSHRs, a secondary miss merged into the block's fill)
+        bool merged = mshrCount > 1 && isBlockInFlight(addr.getBlockAddress());
+        if (merged) {
+            stats.misses++;
+            stats.mshrMerges++;
+        } else {
+            stats.hits++;
+        }
+#ifdef L1SIM_INSTRUMENT
+        if (missProfiler) {
+            if (merged) missProfiler->recordMerge(setIndex, addr.getBlockAddress());
+            else        missProfiler->recordHit(setIndex, addr.getBlockAddress());
+        }
+#endif
+        cacheSet.updateLRU(line);
+
+        MESIState curState = line->getMESIState();
+        if (curState != MESIState::MODIFIED) {
+            
+                  
+            // Need to invalidate other copies unless EXCLUSIVE
+            // (SHARED, or OWNED/FORWARD under MOESI/MESIF)
+            if (curState != MESIState::EXCLUSIVE) {
+                // Invalidate other sharers
+                issueCoherenceRequest(BusTransaction::BUS_UPGR, addr);
+                // BUS_UPGR: 2-cycle bus transfer (no stall)
+                if (splitBus && !functional) splitBus->scheduleControl(currentCycle);
+            }
+            
+            // Transition directly to MODIFIED
+            line->setMESIState(MESIState::MODIFIED);
+        }
+        // If already MODIFIED, no state change needed
+
+        // Perform write 
+        uint32_t wordOffset = offset & ~0x3;
+        uint32_t dummyData  = 0xDEADBEEF;
+        line->writeWord(wordOffset, dummyData);
+        if (!merged && prefetcher && claimPrefetch(addr)) {
+            return false;  // Prefetched block still on its way
+        }
+        return true;
+    }
+
+    // WRITE MISS (write-allocate)
+    stats.misses++;
+#ifdef L1SIM_INSTRUMENT
+    if (missProfiler) missProfiler->recordMiss(setIndex, addr.getBlockAddress());
+#endif
+    pendingMiss     = true;
+    dataSourceCache = -1;
+    suppliedLine    = nullptr;
+    bool refill = false;
+    if (writebackEntries) {
+        retireWritebacks(currentCycle);
+        refill = takeWriteback(addr.getBlockAddress());
+        if (refill) stats.wbRefills++;
+    }
+
+   
+
+    CacheLine* victim = cacheSet.findVictim();
+    if (victim ->isValid()) {
+        stats.evictions++;
+#ifdef L1SIM_INSTRUMENT
+        if (missProfiler) missProfiler->recordEviction(setIndex);
+#endif
+        if (victim -> isDirty()) {
+            stats.writebacks++;
+        }
+        if (prefetcher) {
+            dropPrefetch((victim->getTag() << (setBits + blockBits)) | (setIndex << blockBits));
+        }
+    }
+    if (victim->isValid() && victim->isDirty()) {
+
+        uint32_t victimTag       = victim->getTag();
+        uint32_t victimBlockAddr = (victimTag << (setBits + blockBits))
+                                    | (setIndex << blockBits);
+
+        Address flushAddr(victimBlockAddr, setBits, blockBits);
+        issueCoherenceRequest(BusTransaction::FLUSH, flushAddr);
+        
+        
+                  
+        if (writebackEntries) {
+            // Park it in the write-back buffer; the fill waits only for a free entry
+            missResolveTime = bufferWriteback(victimBlockAddr, victim);
+        } else {
+            mainMemory.writeBlock(victimBlockAddr, victim->getData());
+            missResolveTime = writebackDone(victimBlockAddr, currentCycle);
+        }
+        stats.writebackStall += missResolveTime - currentCycle;
+    } else {
+        missResolveTime = currentCycle;
+    }
+
+    // Request exclusive ownership
+    BusResult result = issueCoherenceRequest(BusTransaction::BUS_RDX, addr);
+    
+    if (result.dataProvided) {
+        takeDataSource(result);
+        
+    } else if (snoopFilter) {
+        // Same search as below, but the filter already tracks which peers
+        // kept an invalidated way with this tag
+        uint64_t holders = snoopFilter->getStaleHolders(addr.getBlockAddress())
+                         & ~(uint64_t(1) << coreId);
+        if (holders) {
+            dataSourceCache = __builtin_ctzll(holders);
+        }
+    } else if (peerCaches) {
+        // Important: Check if any other cache had data that they wrote back and invalidated
+        // This is necessary because BUS_RDX causes all other caches to invalidate their copies
+        // without transferring data directly to us, even if they've written back to memory
+        for (int i = 0; i < (int)peerCaches->size(); i++) {
+            if (i == coreId) continue;
+            
+            Cache* otherCache = (*peerCaches)[i];
+            auto& sets = otherCache->getSets();
+            
+            // If we can find an invalidated entry, mark it as the source
+            // so we don't go to DRAM unnecessarily
+            if (addr.getIndex() < sets.size()) {
+                auto& lines = sets[addr.getIndex()].getLines();
+                for (auto& line : lines) {
+                    if (!line.isValid() && line.getTag() == addr.getTag()) {
+                        
+                        dataSourceCache = i;
+                        break;
+                    }
+                }
+            }
+            if (dataSourceCache >= 0) break;
+        }
+    }
+
+    // We will modify, so set as MODIFIED
+    MESIState newState = MESIState::MODIFIED;
+
+    // Calculate timing for data transfer
+    unsigned int fillStart = missResolveTime;
+    bool fromCache = dataSourceCache >= 0 || refill;
+    missResolveTime = fillDone(addr.getBlockAddress(), fromCache, fillStart);
+    if (coherenceBus) coherenceBus->recordFill(fromCache, missResolveTime - fillStart);
+
+    // Install block and perform write
+    uint32_t replacedTag = victim->getTag();
+    installBlock(victim, addr, newState);
+    cacheSet.insertLine(victim);
+    if (snoopFilter) {
+        refreshSnoopFilter(setIndex, replacedTag);
+        if (replacedTag != tag) refreshSnoopFilter(setIndex, tag);
+    }
+    uint32_t wordOffset = offset & ~0x3;
+    uint32_t dummyData  = 0xDEADBEEF;
+    victim->writeWord(wordOffset, dummyData);
+    if (prefetcher) {
+        runPrefetcher(addr);
+    }
+    if (mshrCount > 1) {
+        pendingMiss = false;
+        allocateMshr(addr.getBlockAddress(), missResolveTime);
+        return true;
+    }
+
+    return false;
+}
+
+// True if the access would hit without any bus transaction
+bool Cache::canCompleteLocally(const Address& addr, bool isWrite) const {
+    if (pendingMiss || addr.getIndex() >= sets.size()) {
+        return false;
+    }
+    const CacheLine* line = sets[addr.getIndex()].findLine(addr.getTag());
+    if (!line) {
+        return false;
+    }
+    if (!pendingPrefetches.empty() && pendingPrefetches.count(addr.getBlockAddress())) {
+        return false;  // First use of a prefetched block trains the prefetcher
+    }
+    if (mshrCount > 1 && isBlockInFlight(addr.getBlockAddress())) {
+        return false;  // Secondary miss
+    }
+    MESIState state = line->getMESIState();
+    return !isWrite || state == MESIState::MODIFIED || state == MESIState::EXCLUSIVE;
+}
+
+// Check if a pending miss has completed
+bool Cache::checkMissResolved() {
+    if (pendingMiss && currentCycle >= missResolveTime) {
+        pendingMiss = false;
+        return true;
+    }
+    return false;
+}
+
+// Advance the cycle
+void Cache::setCycle(unsigned int cycle) {
+    currentCycle = cycle;
+}
+
+// Set the number of MSHRs (1 keeps the blocking cache)
+void Cache::setMshrCount(unsigned int count) {
+    mshrCount = std::max(1u, count);
+    mshrs.assign(mshrCount > 1 ? mshrCount : 0, Mshr());
+}
+
+// Get the number of MSHRs
+unsigned int Cache::getMshrCount() const {
+    return mshrCount;
+}
+
+// True if the last read/write was refused and must be reissued
+bool Cache::wasRejected() const {
+    return accessRejected;
+}
+
+// Retire finished fills and decide whether an access can be taken now.
+// Hits and secondary misses need no MSHR; a primary miss needs a free one,
+// and without one the core stalls until the earliest fill has ended.
+bool Cache::acceptAccess(const Address& addr) {
+    accessRejected = false;
+    unsigned int earliest = std::numeric_limits<unsigned int>::max();
+    bool freeMshr = false;
+    for (auto& m : mshrs) {
+        if (m.busy && m.ready < currentCycle) {
+            m.busy = false;
+        }
+        if (m.busy) {
+            earliest = std::min(earliest, m.ready);
+        } else {
+            freeMshr = true;
+        }
+    }
+    if (freeMshr || addr.getIndex() >= sets.size() ||
+        sets[addr.getIndex()].findLine(addr.getTag())) {
+        return true;
+    }
+
+    accessRejected  = true;
+    stats.mshrFull++;
+    pendingMiss     = true;
+    missResolveTime = earliest;
+    return false;
+}
+
+// Check if a block's fill is still in flight in an MSHR
+bool Cache::isBlockInFlight(uint32_t blockAddr) const {
+    for (const auto& m : mshrs) {
+        if (m.busy && m.merging && m.blockAddr == blockAddr && m.ready >= currentCycle) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Record a fill in a free MSHR; returns false if every MSHR is busy
+bool Cache::allocateMshr(uint32_t blockAddr, unsigned int ready) {
+    // An older fill of the same block lost its line (evicted or invalidated
+    // before it completed); it keeps its MSHR but takes no more merges
+    for (auto& m : mshrs) {
+        if (m.busy && m.blockAddr == blockAddr) {
+            m.merging = false;
+        }
+    }
+    for (auto& m : mshrs) {
+        if (!m.busy || m.ready < currentCycle) {
+            m.blockAddr = blockAddr;
+            m.ready     = ready;
+            m.busy      = true;
+            m.merging   = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Size the write-back buffer; buffered blocks are written to memory first
+void Cache::setWritebackBuffer(unsigned int entries) {
+    while (!writebackBuffer.empty()) {
+        completeWriteback(0);
+    }
+    writebackEntries = entries;
+}
+
+// Get the write-back buffer's capacity (0 = none)
+unsigned int Cache::getWritebackBufferSize() const {
+    return writebackEntries;
+}
+
+// Queue a dirty victim behind the buffer's earlier writebacks. Returns the
+// cycle the miss may go on: now, or when the oldest entry reaches memory if
+// the buffer is full.
+unsigned int Cache::bufferWriteback(uint32_t blockAddr, const CacheLine* victim) {
+    retireWritebacks(currentCycle);
+    unsigned int start = currentCycle;
+    if (writebackBuffer.size() >= writebackEntries) {
+        stats.wbFull++;
+        start = std::max(start, writebackBuffer.front().done);
+        completeWriteback(0);
+    }
+
+    // Entries drain one at a time, each over the bus like an unbuffered writeback
+    unsigned int drainStart = std::max(start, writebackDrainEnd);
+    writebackDrainEnd = writebackDone(blockAddr, drainStart);
+    writebackBuffer.push_back(PendingWriteback{blockAddr, writebackDrainEnd, victim->getData()});
+    if (coherenceBus) coherenceBus->noteWriteback(writebackDrainEnd);
+    return start;
+}
+
+// Write the entries that have finished draining by `cycle` to memory
+void Cache::retireWritebacks(unsigned int cycle) {
+    while (!writebackBuffer.empty() && writebackBuffer.front().done <= cycle) {
+        completeWriteback(0);
+    }
+}
+
+// Cycle the oldest buffered block finishes draining (entries drain in order)
+unsigned int Cache::getNextWritebackDrain() const {
+    return writebackBuffer.empty() ? std::numeric_limits<unsigned int>::max()
+                                   : writebackBuffer.front().done;
+}
+
+// Pull a block out of the buffer early (snooped, or missed on again); false if absent
+bool Cache::takeWriteback(uint32_t blockAddr) {
+    for (size_t i = 0; i < writebackBuffer.size(); i++) {
+        if (writebackBuffer[i].blockAddr == blockAddr) {
+            completeWriteback(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Write one entry to memory and release it
+void Cache::completeWriteback(size_t index) {
+    uint32_t blockAddr = writebackBuffer[index].blockAddr;
+    mainMemory.writeBlock(blockAddr, writebackBuffer[index].data);
+    writebackBuffer.erase(writebackBuffer.begin() + index);
+    if (snoopFilter) {
+        Address block(blockAddr, setBits, blockBits);
+        refreshSnoopFilter(block.getIndex(), block.getTag());
+    }
+}
+
+// Check if a block is waiting in the write-back buffer
+bool Cache::isBuffered(uint32_t blockAddr) const {
+    for (const auto& entry : writebackBuffer) {
+        if (entry.blockAddr == blockAddr) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Stall until every outstanding miss has returned
+bool Cache::drainMisses() {
+    bool outstanding = false;
+    unsigned int last = 0;
+    for (const auto& m : mshrs) {
+        if (m.busy && m.ready > currentCycle) {  // A fill ending this cycle is done
+            outstanding = true;
+            last = std::max(last, m.ready);
+        }
+    }
+    if (!outstanding) {
+        return false;
+    }
+    pendingMiss     = true;
+    missResolveTime = last;
+    return true;
+}
+
+// Connect the shared bus that runs this cache's transactions
+void Cache::setBus(Bus* bus) {
+    coherenceBus = bus;
+}
+
+// Provide the list of caches sharing the bus
+void Cache::setPeerCaches(const std::vector<Cache*>* peers) {
+    peerCaches = peers;
+}
+
+// Provide the snoop filter and register every block (and stale tag) already in the sets
+void Cache::setSnoopFilter(SnoopFilter* filter) {
+    snoopFilter = filter;
+    if (!snoopFilter) return;
+    for (uint32_t s = 0; s < sets.size(); ++s) {
+        for (const auto& line : sets[s].getLines()) {
+            refreshSnoopFilter(s, line.getTag());
+        }
+    }
+}
+
+// Report whether this cache now holds (or keeps a stale tag for) one block
+void Cache::refreshSnoopFilter(uint32_t setIndex, uint32_t tag) {
+    const CacheSet& set = sets[setIndex];
+    uint32_t blockAddr = (tag << (setBits + blockBits)) | (setIndex << blockBits);
+    bool holds = set.findLine(tag) != nullptr || (!writebackBuffer.empty() && isBuffered(blockAddr));
+    snoopFilter->update(blockAddr, coreId, holds, set.hasStaleTag(tag));
+}
+
+// Cycle a fill completes that may start at `start` (after the victim's
+// writeback); `fromCache` when a peer, or this cache's write-back buffer,
+// supplies the block
+unsigned int Cache::fillDone(uint32_t blockAddr, bool fromCache, unsigned int start) {
+    unsigned int latency = fromCache ? 2 * (blockSize / 4) : 100;
+    bool l2Hit = false;
+    if (l2) {
+        if (fromCache) {
+            l2->insert(blockAddr);   // Keep an inclusive L2 a superset of the L1s
+        } else {
+            latency = l2->read(blockAddr, l2Hit);
+        }
+    }
+    if (functional) {
+        return start;
+    }
+    if (splitBus) {
+        // The request goes out alongside the victim's writeback, not after it;
+        // an L2 lookup comes first and an L2 hit needs no memory bank
+        if (l2 && !fromCache) {
+            return std::max(start, splitBus->scheduleFill(currentCycle + l2->getLatency(),
+                                                          blockAddr, l2Hit));
+        }
+        return std::max(start, splitBus->scheduleFill(currentCycle, blockAddr, fromCache));
+    }
+    return start + latency;
+}
+
+// Cycle a dirty block written back at `cycle` has left the cache
+unsigned int Cache::writebackDone(uint32_t blockAddr, unsigned int cycle) {
+    unsigned int latency = l2 ? l2->write(blockAddr) : 100;
+    if (functional) {
+        return cycle;
+    }
+    return splitBus ? splitBus->scheduleWriteback(cycle, blockAddr) : cycle + latency;
+}
+
+// Switch functional warming on or off
+void Cache::setFunctional(bool enabled) {
+    functional = enabled;
+}
+
+// Check if fills and writebacks currently take no time
+bool Cache::isFunctional() const {
+    return functional;
+}
+
+// Fetch blocks from (and write them back to) a shared L2 instead of memory
+void Cache::setL2(L2Cache* cache) {
+    l2 = cache;
+}
+
+// An inclusive L2 evicted a block: drop this cache's copy, writing dirty data to memory
+bool Cache::backInvalidate(uint32_t blockAddr) {
+    bool dropped = writebackEntries && takeWriteback(blockAddr);
+    Address block(blockAddr, setBits, blockBits);
+    CacheLine* line = sets[block.getIndex()].findLine(block.getTag());
+    if (!line) {
+        return dropped;
+    }
+    if (line->isDirty()) {
+        mainMemory.writeBlock(blockAddr, line->getData());
+    }
+    line->setMESIState(MESIState::INVALID);
+    if (snoopFilter) refreshSnoopFilter(block.getIndex(), block.getTag());
+    if (prefetcher) dropPrefetch(blockAddr);
+    return true;
+}
+
+// Write every dirty line back and invalidate the whole cache
+unsigned int Cache::flush(unsigned int& dirty) {
+    unsigned int dropped = 0;
+    unsigned int done = currentCycle;
+    dirty = 0;
+    for (uint32_t s = 0; s < sets.size(); ++s) {
+        for (auto& line : sets[s].getLinesModifiable()) {
+            if (!line.isValid()) continue;
+            uint32_t blockAddr = (line.getTag() << (setBits + blockBits)) | (s << blockBits);
+            if (line.isDirty()) {
+                // One writeback after the other, like dirty evictions
+                Address flushAddr(blockAddr, setBits, blockBits);
+                issueCoherenceRequest(BusTransaction::FLUSH, flushAddr);
+                mainMemory.writeBlock(blockAddr, line.getData());
+                done = writebackDone(blockAddr, done);
+                stats.writebacks++;
+                dirty++;
+            }
+            line.setMESIState(MESIState::INVALID);
+            dropped++;
+            if (snoopFilter) refreshSnoopFilter(s, line.getTag());
+            if (prefetcher) dropPrefetch(blockAddr);
+        }
+    }
+    if (done > currentCycle) {
+        pendingMiss     = true;
+        missResolveTime = done;
+    }
+    return dropped;
+}
+
+// Take fill and writeback timing from a split-transaction bus (atomic: keep fixed latencies)
+void Cache::setBusModel(BusModel* bus) {
+    splitBus = (bus && bus->isSplit()) ? bus : nullptr;
+}
+
+// Attach a prefetcher fed by this cache's demand misses
+void Cache::setPrefetcher(Prefetcher::Kind kind, unsigned int degree) {
+    pendingPrefetches.clear();
+    if (kind == Prefetcher::Kind::NONE) {
+        prefetcher.reset();
+        return;
+    }
+    prefetcher = std::make_unique<Prefetcher>(kind, degree, blockBits);
+}
+
+// Check if a prefetcher is attached
+bool Cache::hasPrefetcher() const {
+    return prefetcher != nullptr;
+}
+
+// Train the prefetcher on a demand trigger and fetch what it asks for
+void Cache::runPrefetcher(const Address& trigger) {
+    prefetchCandidates.clear();
+    prefetcher->observe(trigger.getBlockAddress() >> blockBits, prefetchCandidates);
+    for (uint32_t block : prefetchCandidates) {
+        issuePrefetch(block << blockBits, trigger.getBlockAddress());
+    }
+}
+
+// Fetch one block ahead of demand. The core does not wait for it: the line
+// is installed at once and remembers when its data arrives, so a demand
+// access before then waits only for the remainder (a late prefetch).
+void Cache::issuePrefetch(uint32_t blockAddr, uint32_t demandBlockAddr) {
+    Address target(blockAddr, setBits, blockBits);
+    uint32_t setIndex = target.getIndex();
+    CacheSet& cacheSet = sets[setIndex];
+    if (cacheSet.findLine(target.getTag())) {
+        return;  // Already cached
+    }
+    if (writebackEntries) {
+        retireWritebacks(currentCycle);
+        if (isBuffered(blockAddr)) {
+            return;  // Dirty copy still on its way out; a demand miss takes it back
+        }
+    }
+
+    CacheLine* victim = cacheSet.findVictim();
+    unsigned int writtenBack = currentCycle;
+    if (victim->isValid()) {
+        uint32_t victimBlockAddr = (victim->getTag() << (setBits + blockBits))
+                                    | (setIndex << blockBits);
+        if (victimBlockAddr == demandBlockAddr) {
+            return;  // Never displace the block the demand access just brought in
+        }
+        stats.evictions++;
+#ifdef L1SIM_INSTRUMENT
+        if (missProfiler) missProfiler->recordEviction(setIndex);
+#endif
+        dropPrefetch(victimBlockAddr);
+        if (victim->isDirty()) {
+            stats.writebacks++;
+            Address flushAddr(victimBlockAddr, setBits, blockBits);
+            issueCoherenceRequest(BusTransaction::FLUSH, flushAddr);
+            if (writebackEntries) {
+                writtenBack = bufferWriteback(victimBlockAddr, victim);
+            } else {
+                mainMemory.writeBlock(victimBlockAddr, victim->getData());
+                writtenBack = writebackDone(victimBlockAddr, currentCycle);
+            }
+        }
+    }
+
+    // Fetch with a plain BusRd, exactly like a read miss
+    BusResult result = issueCoherenceRequest(BusTransaction::BUS_RD, target);
+
+    int demandSource = dataSourceCache;
+    const CacheLine* demandLine = suppliedLine;
+    dataSourceCache = -1;
+    suppliedLine = nullptr;
+    takeDataSource(result);
+    MESIState state = readFillState(result);
+    unsigned int arrival = fillDone(blockAddr, result.dataProvided,
+                                    splitBus ? writtenBack : currentCycle);
+
+    uint32_t replacedTag = victim->getTag();
+    installBlock(victim, target, state);
+    cacheSet.insertLine(victim);
+    if (snoopFilter) {
+        refreshSnoopFilter(setIndex, replacedTag);
+        if (replacedTag != target.getTag()) refreshSnoopFilter(setIndex, target.getTag());
+    }
+    dataSourceCache = demandSource;
+    suppliedLine = demandLine;
+
+    pendingPrefetches[blockAddr] = arrival;
+    prefetchStats.issued++;
+}
+
+// First demand access to a prefetched block: count it and train on it.
+// Returns true if the data is still in flight (miss resolution set to its arrival).
+bool Cache::claimPrefetch(const Address& addr) {
+    auto it = pendingPrefetches.find(addr.getBlockAddress());
+    if (it == pendingPrefetches.end()) {
+        return false;
+    }
+    unsigned int arrival = it->second;
+    pendingPrefetches.erase(it);
+    prefetchStats.useful++;
+
+    bool inFlight = currentCycle < arrival;
+    if (inFlight) {
+        prefetchStats.late++;
+        if (mshrCount > 1 && allocateMshr(addr.getBlockAddress(), arrival)) {
+            inFlight = false;  // Waits in an MSHR like any other fill
+        } else {
+            pendingMiss     = true;
+            missResolveTime = arrival;
+        }
+    }
+    runPrefetcher(addr);
+    return inFlight;
+}
+
+// A block leaves the cache: if it was prefetched and never used, it only polluted
+void Cache::dropPrefetch(uint32_t blockAddr) {
+    if (pendingPrefetches.erase(blockAddr)) {
+        prefetchStats.polluting++;
+    }
+}
+
+// Issue a bus transaction to other caches
+BusResult Cache::issueCoherenceRequest(BusTransaction transType, const Address& addr)
+{
+    if (!coherenceBus) return BusResult();
+    stats.coherence++;
+    return coherenceBus->transact(transType, addr, coreId);
+}
+
+// Take the supplier of a transaction's data (if any) as this fill's source
+void Cache::takeDataSource(const BusResult& result) {
+    if (!result.dataProvided) return;
+    dataSourceCache = result.sourceCore;
+    suppliedLine = result.suppliedLine;
+}
+
+// State a block fetched by a read is installed in (MESI without a bus)
+MESIState Cache::readFillState(const BusResult& result) const {
+    if (coherenceBus) return coherenceBus->readFillState(result);
+    return result.dataProvided ? MESIState::SHARED : MESIState::EXCLUSIVE;
+}
+
+// Fetch a block's bytes from cache or memory (a view, copied by the caller)
+const uint8_t* Cache::fetchBlockFromMemoryOrCache(const Address& addr,
+    MESIState& state)
+{
+    uint32_t blockAddr = addr.getBlockAddress();
+
+    // 1) The supplier's line as it was handed over: it still holds the data
+    //    when the transaction invalidated it without a writeback (MOESI)
+    if (suppliedLine && suppliedLine->getTag() == addr.getTag()) {
+        return suppliedLine->getData().data();
+    }
+
+    // ... otherwise search the supplier's set for the block
+    if (peerCaches && dataSourceCache >= 0 && dataSourceCache < (int)peerCaches->size()) {
+        
+                
+        Cache* supplier = (*peerCaches)[dataSourceCache];
+        auto& sets = supplier->getSets();
+        if (addr.getIndex() < sets.size()) {
+            auto& lines = sets[addr.getIndex()].getLines();
+            
+            for (auto& line : lines) {
+                if (line.isValid() && line.getTag() == addr.getTag()) {
+                    return line.getData().data();
+                }
+            }
+        }
+        
+        // Fallback if peer data not found (shouldn't happen if coherence works correctly)
+        
+    }
+    
+    // 2) Otherwise, fetch from main memory
+   
+            
+    return mainMemory.readBlock(blockAddr);
+}
+
+// Install a block into a line: copy its bytes, or only tag/state in tag-only mode
+void Cache::installBlock(CacheLine* line, const Address& addr, MESIState state) {
+#ifdef L1SIM_INSTRUMENT
+    if (sharingProfiler) sharingProfiler->recordFill(coreId, addr.getBlockAddress());
+#endif
+    if (!storeData) {
+        // No payload to move; memory still sees (and counts) the fill
+        if (dataSourceCache < 0) {
+            mainMemory.readBlock(addr.getBlockAddress());
+        }
+        line->loadTag(addr.getTag(), state);
+        return;
+    }
+    
+    line->loadData(fetchBlockFromMemoryOrCache(addr, state), addr.getTag(), state);
+}
+
+// React to a peer's transaction under Protocol
+template <class Protocol>
+bool Cache::snoop(BusTransaction transType,
+                  const Address& addr,
+                  int requestingCore,
+                  SnoopReply& reply)
+{
+    uint32_t setIndex = addr.getIndex();
+    uint32_t tag      = addr.getTag();
+
+    if (setIndex >= sets.size()) return false;
+
+    CacheSet& set   = sets[setIndex];
+    CacheLine* line = set.findLine(tag);
+    if (!line) {
+        // A dirty block evicted but still in the write-back buffer is supplied
+        // from there (and written to memory at once) instead of being missed
+        if (writebackEntries && transType != BusTransaction::FLUSH &&
+            takeWriteback(addr.getBlockAddress())) {
+            stats.wbSnoopHits++;
+            reply.supply = transType != BusTransaction::BUS_UPGR;
+            reply.writeback = true;
+            return true;
+        }
+        return false;  // No matching line in this cache
+    }
+
+    MESIState curState = line->getMESIState();
+    const SnoopAction& action =
+        Protocol::SNOOP[static_cast<int>(transType)][static_cast<int>(curState)];
+    if (!action.held) return false;
+
+    if (action.writeback) {
+        mainMemory.writeBlock(addr.getBlockAddress(), line->getData());
+        reply.writeback = true;
+    }
+    if (action.supply) {
+        reply.supply = true;
+        reply.line = line;
+    }
+    if (action.next == curState) return true;
+
+    line->setMESIState(action.next);
+    if (action.next == MESIState::INVALID) {
+#ifdef L1SIM_INSTRUMENT
+        if (missProfiler) {
+            missProfiler->recordInvalidation(addr.getBlockAddress(),
+                                             transType == BusTransaction::BUS_UPGR);
+        }
+        if (sharingProfiler) {
+            sharingProfiler->recordInvalidation(coreId, requestingCore, addr.getBlockAddress());
+        }
+#endif
+        if (snoopFilter) refreshSnoopFilter(setIndex, tag);
+        if (prefetcher) dropPrefetch(addr.getBlockAddress());
+    }
+    return true;
+}
+
+template bool Cache::snoop<MesiProtocol>(BusTransaction, const Address&, int, SnoopReply&);
+template bool Cache::snoop<MoesiProtocol>(BusTransaction, const Address&, int, SnoopReply&);
+template bool Cache::snoop<MesifProtocol>(BusTransaction, const Address&, int, SnoopReply&);
+
+// Handle a snooped bus transaction from another cache
+bool Cache::handleBusTransaction(BusTransaction transType,
+                                 const Address& addr,
+                                 int requestingCore,
+                                 bool& providedData)
+{
+    SnoopReply reply;
+    bool held;
+    switch (coherenceBus ? coherenceBus->getProtocol() : CoherenceProtocol::MESI) {
+    case CoherenceProtocol::MOESI:
+        held = snoop<MoesiProtocol>(transType, addr, requestingCore, reply);
+        break;
+    case CoherenceProtocol::MESIF:
+        held = snoop<MesifProtocol>(transType, addr, requestingCore, reply);
+        break;
+    default:
+        held = snoop<MesiProtocol>(transType, addr, requestingCore, reply);
+        break;
+    }
+    if (reply.supply) providedData = true;
+    return held;
+}
+
+// Other getters (unchanged)...
+uint64_t Cache::getAccessCount()       const { return stats.accesses; }
+uint64_t Cache::getHitCount()          const { return stats.hits; }
+uint64_t Cache::getMissCount()         const { return stats.misses; }
+uint64_t Cache::getReadCount()         const { return stats.reads; }
+uint64_t Cache::getWriteCount()        const { return stats.writes; }
+uint64_t Cache::getCoherenceCount()    const { return stats.coherence; }
+uint64_t Cache::getEvictionCount()     const { return stats.evictions; }
+uint64_t Cache::getWritebackCount()    const { return stats.writebacks; }
+const CacheStats& Cache::getStats()    const { return stats; }
+const PrefetchStats& Cache::getPrefetchStats() const { return prefetchStats; }
+int          Cache::getSetBits()       const { return setBits; }
+int          Cache::getBlockBits()     const { return blockBits; }
+int          Cache::getCoreId()        const { return coreId; }
+int Cache::getAssociativity() const {
+    return associativity;
+}
+const std::vector<CacheSet>& Cache::getSets() const { return sets; }
+bool Cache::hasPendingMiss() const { return pendingMiss; }
+unsigned int Cache::getMissResolveTime() const { return missResolveTime; }
+
+// Checkpoint the sets, fills in flight, write-back buffer and counters
+void Cache::saveState(CheckpointWriter& out) const {
+    out.put(stats);
+    out.put<uint8_t>(pendingMiss ? 1 : 0);
+    out.put(missResolveTime);
+    out.put(currentCycle);
+    out.put(dataSourceCache);
+    out.put<uint8_t>(accessRejected ? 1 : 0);
+    out.putVector(mshrs);
+    out.put<uint64_t>(writebackBuffer.size());
+    for (const auto& entry : writebackBuffer) {
+        out.put(entry.blockAddr);
+        out.put(entry.done);
+        out.putVector(entry.data);
+    }
+    out.put(writebackDrainEnd);
+    out.put<uint64_t>(sets.size());
+    for (const auto& set : sets) {
+        set.saveState(out);
+    }
+}
+
+// Restore a checkpoint written by saveState
+void Cache::loadState(CheckpointReader& in) {
+    stats = in.get<CacheStats>();
+    pendingMiss = in.get<uint8_t>() != 0;
+    missResolveTime = in.get<unsigned int>();
+    currentCycle = in.get<unsigned int>();
+    dataSourceCache = in.get<int>();
+    suppliedLine = nullptr;
+    accessRejected = in.get<uint8_t>() != 0;
+    in.getVectorInto(mshrs);
+
+    writebackBuffer.clear();
+    uint64_t buffered = in.get<uint64_t>();
+    if (buffered > writebackEntries) {
+        in.fail();
+        return;
+    }
+    for (uint64_t i = 0; i < buffered; i++) {
+        PendingWriteback entry;
+        entry.blockAddr = in.get<uint32_t>();
+        entry.done = in.get<unsigned int>();
+        entry.data = in.getVector<uint8_t>();
+        if (coherenceBus) coherenceBus->noteWriteback(entry.done);
+        writebackBuffer.push_back(std::move(entry));
+    }
+    writebackDrainEnd = in.get<unsigned int>();
+
+    if (in.get<uint64_t>() != sets.size()) {
+        in.fail();
+        return;
+    }
+    for (auto& set : sets) {
+        set.loadState(in);
+    }
+
+    // The filter only learns of blocks as they move, so report everything
+    // held now: every way's tag, plus the blocks waiting in the buffer
+    if (snoopFilter) {
+        setSnoopFilter(snoopFilter);
+        for (const auto& entry : writebackBuffer) {
+            uint32_t setIndex = (entry.blockAddr >> blockBits) & (numSets - 1);
+            refreshSnoopFilter(setIndex, entry.blockAddr >> (setBits + blockBits));
+        }
+    }
+}
@@ -1,109 +1,235 @@
-#ifndef CACHE_H
-#define CACHE_H
-
-#include <vector>
-#include <functional>
-#include <cstdint>
-#include "CacheSet.h"
-#include "Address.h"
-#include "MainMemory.h"
-
-// Forward declaration of Cache for global list
-class Cache;
-
-// Bus transaction types for coherence protocol
-enum class BusTransaction {
-    BUS_RD,     // Bus Read (for shared copy)
-    BUS_RDX,    // Bus Read Exclusive (for exclusive copy)
-    BUS_UPGR,   // Bus Upgrade (from shared to modified)
-    FLUSH,      // Flush (writing back dirty block)
-    INVALIDATE  // Invalidate other copies
-};
-
-// Global list of all caches for cache-to-cache transfers
-extern std::vector<Cache*> allCaches;
-
-// Coherence callback signature
-typedef std::function<
-    void(BusTransaction, const Address&, int, bool&, int&)
-> CoherenceCallback;
-
-class Cache {
-public:
-    // Constructor
-    Cache(int coreId,
-          int numSets,
-          int associativity,
-          int blockSize,
-          int setBits,
-          int blockBits,
-          MainMemory& mainMemory);
-
-    // Cache operations
-    bool read(const Address& addr);
-    bool write(const Address& addr);
-
-    // Statistics
-    unsigned int getAccessCount() const;
-    unsigned int getHitCount() const;
-    unsigned int getMissCount() const;
-    unsigned int getReadCount() const;
-    unsigned int getWriteCount() const;
-    unsigned int getCoherenceCount() const;
-    unsigned int getEvictionCount() const;
-    unsigned int getWritebackCount() const;
-    // Configuration
-    int getSetBits() const;
-    int getBlockBits() const;
-    int getCoreId() const;
-    int getAssociativity() const;
-
-    // Debug/testing
-    const std::vector<CacheSet>& getSets() const;
-    bool hasPendingMiss() const;
-
-    // Miss resolution
-    bool checkMissResolved();
-    void setCycle(unsigned int cycle);
-
-    // Coherence support
-    void setCoherenceCallback(const CoherenceCallback& cb);
-    bool handleBusTransaction(BusTransaction t,
-                              const Address& addr,
-                              int requestingCore,
-                              bool& provided);
-
-private:
-    // Internal helpers
-    void issueCoherenceRequest(BusTransaction t,
-                               const Address& addr,
-                               bool& dataProvided,
-                               int& sourceCache);
-    std::vector<uint8_t> fetchBlockFromMemoryOrCache(const Address& addr,
-                                                     MESIState& state);
-
-    // Members
-    int coreId;
-    std::vector<CacheSet> sets;
-    MainMemory& mainMemory;
-    int setBits;
-    int blockBits;
-    int numSets;
-    int blockSize;
-    int associativity;
-    unsigned int accessCount;
-    unsigned int hitCount;
-    unsigned int missCount;
-    unsigned int readCount;
-    unsigned int writeCount;
-    unsigned int coherenceCount;
-    unsigned int evictionCount = 0;
-    unsigned int writebackCount = 0;
-    bool pendingMiss;
-    unsigned int missResolveTime;
-    unsigned int currentCycle;
-    int dataSourceCache;
-    CoherenceCallback coherenceCallback;
-};
-
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <vector>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <deque>
+#include "CacheSet.h"
+#include "Address.h"
+#include "MainMemory.h"
+#include "Statistics.h"
+#include "SnoopFilter.h"
+#include "Prefetcher.h"
+#include "BusModel.h"
+#include "Bus.h"
+#include "L2Cache.h"
+#include "CacheGeometry.h"
+#include "MissProfiler.h"
+#include "SharingProfiler.h"
+
+// Forward declaration of Cache for the peer list
+class Cache;
+
+class Cache {
+public:
+    // Constructor
+    Cache(int coreId,
+          int numSets,
+          int associativity,
+          int blockSize,
+          int setBits,
+          int blockBits,
+          MainMemory& mainMemory,
+          ReplacementPolicy policy = ReplacementPolicy::LRU);
+
+    // Cache operations
+    bool read(const Address& addr);
+    bool write(const Address& addr);
+    
+    // True if the access would hit without any bus transaction
+    // (read hit, or write hit in MODIFIED/EXCLUSIVE), so it touches only this cache
+    bool canCompleteLocally(const Address& addr, bool isWrite) const;
+
+    // Statistics
+    uint64_t getAccessCount() const;
+    uint64_t getHitCount() const;
+    uint64_t getMissCount() const;
+    uint64_t getReadCount() const;
+    uint64_t getWriteCount() const;
+    uint64_t getCoherenceCount() const;
+    uint64_t getEvictionCount() const;
+    uint64_t getWritebackCount() const;
+    const CacheStats& getStats() const;
+    const PrefetchStats& getPrefetchStats() const;
+    // Configuration
+    int getSetBits() const;
+    int getBlockBits() const;
+    int getCoreId() const;
+    int getAssociativity() const;
+    // Use the precompiled access path for this geometry when there is one
+    // (the default), or always the runtime-geometry path
+    void setFixedGeometry(bool enabled);
+    bool hasFixedGeometry() const;
+#ifdef L1SIM_INSTRUMENT
+    // Classify misses and keep per-set histograms (see MissProfiler.h)
+    void enableMissProfile();
+    const MissProfiler* getMissProfiler() const;   // nullptr unless enabled
+    // Per-block sharing attribution shared by all caches (nullptr = none)
+    void setSharingProfiler(SharingProfiler* profiler);
+#endif
+
+    // Debug/testing
+    const std::vector<CacheSet>& getSets() const;
+    bool hasPendingMiss() const;
+    unsigned int getMissResolveTime() const;
+
+    // Miss resolution
+    bool checkMissResolved();
+    void setCycle(unsigned int cycle);
+
+    // Non-blocking mode (more than one MSHR): misses are accepted while an MSHR
+    // is free and the core keeps going; it only stalls when all are busy
+    void setMshrCount(unsigned int count);
+    unsigned int getMshrCount() const;
+    // True if the last read/write was refused (all MSHRs busy) and must be reissued
+    bool wasRejected() const;
+    // Stall until every outstanding miss has returned; false if none is outstanding
+    bool drainMisses();
+
+    // Coherence support
+    // Shared bus that runs this cache's transactions (nullptr = none: misses
+    // fill from memory and nothing is snooped)
+    void setBus(Bus* bus);
+    // All caches on the same bus (indexed by core id), used for cache-to-cache transfers
+    void setPeerCaches(const std::vector<Cache*>* peers);
+    // Directory this cache keeps up to date with the blocks it holds (nullptr = none)
+    void setSnoopFilter(SnoopFilter* filter);
+    // Hold up to `entries` dirty victims and write them back in the background (0 = none)
+    void setWritebackBuffer(unsigned int entries);
+    unsigned int getWritebackBufferSize() const;
+    // Check if a block is waiting in the write-back buffer
+    bool isBuffered(uint32_t blockAddr) const;
+    // Write the buffered blocks that have finished draining by `cycle` to memory
+    void retireWritebacks(unsigned int cycle);
+    // Cycle the oldest buffered block finishes draining (UINT_MAX if none)
+    unsigned int getNextWritebackDrain() const;
+    // Shared L2 behind this cache (nullptr = fills and writebacks go to memory)
+    void setL2(L2Cache* cache);
+    // Inclusive L2 eviction: invalidate the block here; true if a copy was dropped
+    bool backInvalidate(uint32_t blockAddr);
+    // Context switch: write every dirty line back and invalidate the whole
+    // cache; returns the valid lines dropped, `dirty` of them written back.
+    // The cache stays busy (hasPendingMiss) until the last writeback is done.
+    unsigned int flush(unsigned int& dirty);
+    // Bus timing model; only a split-transaction bus changes fill latencies (nullptr = fixed)
+    void setBusModel(BusModel* bus);
+    // Functional warming (sampled simulation): tags, states, data and the L2
+    // are updated as usual, but fills and writebacks complete in the cycle
+    // they start and nothing is scheduled on a split bus
+    void setFunctional(bool enabled);
+    bool isFunctional() const;
+    // Attach a prefetcher fed by this cache's demand misses (Kind::NONE = detach)
+    void setPrefetcher(Prefetcher::Kind kind, unsigned int degree);
+    bool hasPrefetcher() const;
+    // React to a peer's transaction under Protocol (see Bus.h); true if this
+    // cache held the block, `reply` says whether it supplies or writes back the data
+    template <class Protocol>
+    bool snoop(BusTransaction t, const Address& addr, int requestingCore, SnoopReply& reply);
+    // snoop() under the simulator's protocol
+    bool handleBusTransaction(BusTransaction t,
+                              const Address& addr,
+                              int requestingCore,
+                              bool& provided);
+
+    // Checkpoint the sets, fills in flight, write-back buffer and counters
+    // (the prefetcher is not saved). Load into a cache configured like the
+    // saved one; its snoop filter entries are rebuilt from the loaded sets.
+    void saveState(CheckpointWriter& out) const;
+    void loadState(CheckpointReader& in);
+
+private:
+    // Read/write bodies, instantiated per geometry type (see CacheGeometry.h)
+    template <class Geometry> bool readAccess(const Address& addr);
+    template <class Geometry> bool writeAccess(const Address& addr);
+    // Point the access paths at FixedGeometry<SetBits, Ways, BlockBits> if it matches
+    template <int SetBits, int Ways, int BlockBits> bool useFixedGeometry();
+    void selectAccessPath(bool allowFixed);
+
+    // Internal helpers
+    BusResult issueCoherenceRequest(BusTransaction t, const Address& addr);
+    // Take the supplier of a transaction's data (if any) as this fill's source
+    void takeDataSource(const BusResult& result);
+    // State a block fetched by a read is installed in, under the bus's protocol
+    MESIState readFillState(const BusResult& result) const;
+    const uint8_t* fetchBlockFromMemoryOrCache(const Address& addr,
+                                               MESIState& state);
+    void installBlock(CacheLine* line, const Address& addr, MESIState state);
+    void refreshSnoopFilter(uint32_t setIndex, uint32_t tag);
+    // Prefetch support (only called with a prefetcher attached)
+    void runPrefetcher(const Address& trigger);
+    void issuePrefetch(uint32_t blockAddr, uint32_t demandBlockAddr);
+    bool claimPrefetch(const Address& addr);
+    void dropPrefetch(uint32_t blockAddr);
+    // MSHR support (only called with more than one MSHR)
+    bool acceptAccess(const Address& addr);
+    bool isBlockInFlight(uint32_t blockAddr) const;
+    bool allocateMshr(uint32_t blockAddr, unsigned int ready);
+    // Fill and writeback timing through the bus model and the L2
+    unsigned int fillDone(uint32_t blockAddr, bool fromCache, unsigned int start);
+    unsigned int writebackDone(uint32_t blockAddr, unsigned int cycle);
+    // Write-back buffer support (only called with a buffer configured)
+    unsigned int bufferWriteback(uint32_t blockAddr, const CacheLine* victim);
+    bool takeWriteback(uint32_t blockAddr);
+    void completeWriteback(size_t index);
+
+    // Members
+    int coreId;
+    std::vector<CacheSet> sets;
+    MainMemory& mainMemory;
+    int setBits;
+    int blockBits;
+    int numSets;
+    int blockSize;
+    int associativity;
+    CacheStats stats;
+    bool (Cache::*readPath)(const Address&);    // readAccess for this geometry
+    bool (Cache::*writePath)(const Address&);   // writeAccess for this geometry
+    bool fixedGeometry;   // The paths are a FixedGeometry instantiation
+    bool pendingMiss;
+    unsigned int missResolveTime;
+    unsigned int currentCycle;
+    int dataSourceCache;
+    const CacheLine* suppliedLine;   // Supplier's line for the current fill (nullptr = search)
+    Bus* coherenceBus;
+    const std::vector<Cache*>* peerCaches;
+    SnoopFilter* snoopFilter;
+    BusModel* splitBus;   // Set only for a split-transaction bus
+    bool functional;      // Functional warming: no fill/writeback latency
+    L2Cache* l2;          // Shared L2 (nullptr = none)
+    bool storeData;   // False in tag-only mode (follows MainMemory::storesData)
+    std::unique_ptr<Prefetcher> prefetcher;
+    PrefetchStats prefetchStats;
+    // Prefetched blocks not yet touched by a demand access -> cycle the data arrives
+    std::unordered_map<uint32_t, unsigned int> pendingPrefetches;
+    std::vector<uint32_t> prefetchCandidates;   // Scratch for Prefetcher::observe
+
+    // One miss status holding register: a block fill in flight
+    struct Mshr {
+        uint32_t blockAddr = 0;
+        unsigned int ready = 0;   // Last cycle of the fill; free from the cycle after
+        bool busy = false;
+        bool merging = false;     // False once the line left the cache before the fill ended
+    };
+    unsigned int mshrCount;       // 1 = blocking cache (pendingMiss only)
+    std::vector<Mshr> mshrs;      // Used when mshrCount > 1
+    bool accessRejected;
+
+    // One evicted dirty block waiting in the write-back buffer
+    struct PendingWriteback {
+        uint32_t blockAddr;
+        unsigned int done;            // Cycle its write to memory completes
+        std::vector<uint8_t> data;
+    };
+    unsigned int writebackEntries;    // 0 = no buffer: writebacks stall the miss
+    std::deque<PendingWriteback> writebackBuffer;   // Oldest (draining) first
+    unsigned int writebackDrainEnd;   // Cycle the buffer's last entry finishes draining
+
+#ifdef L1SIM_INSTRUMENT
+    std::unique_ptr<MissProfiler> missProfiler;   // Only with --miss-profile
+    SharingProfiler* sharingProfiler = nullptr;   // Only with --sharing-top
+#endif
+};
+
 #endif // CACHE_H
\ No newline at end of file
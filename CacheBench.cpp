@@ -0,0 +1,371 @@
+// Micro-benchmarks for the simulator's hot paths (Google Benchmark).
+//
+//   $make bench
+//   $./L1bench                              # everything
+//   $./L1bench --benchmark_filter=CacheSet  # one group
+//
+// The trace and end-to-end benchmarks read app1/app2 from the working
+// directory and are skipped when those traces are missing.
+
+#include "Simulator.h"
+#include "Cache.h"
+#include "CacheSet.h"
+#include "Address.h"
+#include "MainMemory.h"
+#include "TraceReader.h"
+#include "FunctionalCacheModel.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Geometry shared by the Cache benchmarks: 64 sets, 32-byte blocks
+const int SET_BITS = 6;
+const int BLOCK_BITS = 5;
+const int BLOCK_SIZE = 1 << BLOCK_BITS;
+
+// Fill every way of a set with tags 0..assoc-1 and give each a distinct LRU position
+void fillSet(CacheSet& set, int assoc) {
+    for (int w = 0; w < assoc; ++w) {
+        CacheLine* line = set.findVictim();
+        line->loadTag(static_cast<uint32_t>(w), MESIState::EXCLUSIVE);
+        set.updateLRU(line);
+    }
+}
+
+// Pseudo-random sequence for lookups the branch predictor cannot learn
+uint32_t nextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Settle a blocking miss so the next access can issue
+void resolveMiss(Cache& cache) {
+    if (cache.hasPendingMiss()) {
+        cache.setCycle(cache.getMissResolveTime());
+        cache.checkMissResolved();
+    }
+}
+
+bool tracesPresent(const std::string& app) {
+    TraceReader reader(app);
+    return reader.openTraceFiles();
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// CacheSet
+//------------------------------------------------------------------------------
+
+// Tag lookup that hits a random way
+static void BM_CacheSetFindLine(benchmark::State& state) {
+    int assoc = static_cast<int>(state.range(0));
+    CacheSet set(assoc, 0);
+    fillSet(set, assoc);
+    uint32_t rng = 0x9E3779B9;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(set.findLine(nextRandom(rng) % assoc));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CacheSetFindLine)->RangeMultiplier(2)->Range(1, 64);
+
+// Tag lookup that misses every way
+static void BM_CacheSetFindLineMiss(benchmark::State& state) {
+    int assoc = static_cast<int>(state.range(0));
+    CacheSet set(assoc, 0);
+    fillSet(set, assoc);
+    uint32_t tag = static_cast<uint32_t>(assoc);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(set.findLine(tag));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CacheSetFindLineMiss)->RangeMultiplier(2)->Range(1, 64);
+
+// Victim selection in a full set
+static void BM_CacheSetFindVictim(benchmark::State& state) {
+    int assoc = static_cast<int>(state.range(0));
+    CacheSet set(assoc, 0);
+    fillSet(set, assoc);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(set.findVictim());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CacheSetFindVictim)->RangeMultiplier(2)->Range(1, 64);
+
+// LRU promotion of a random way
+static void BM_CacheSetUpdateLRU(benchmark::State& state) {
+    int assoc = static_cast<int>(state.range(0));
+    CacheSet set(assoc, 0);
+    fillSet(set, assoc);
+    std::vector<CacheLine>& lines = set.getLinesModifiable();
+    uint32_t rng = 0x9E3779B9;
+    for (auto _ : state) {
+        set.updateLRU(&lines[nextRandom(rng) % assoc]);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CacheSetUpdateLRU)->RangeMultiplier(2)->Range(1, 64);
+
+//------------------------------------------------------------------------------
+// Cache (single core, no coherence callback)
+//------------------------------------------------------------------------------
+
+// Read hits on one resident block, through the runtime-geometry path (fixed=0)
+// or the precompiled one for this geometry (fixed=1)
+static void BM_CacheReadHit(benchmark::State& state) {
+    MainMemory memory(BLOCK_SIZE);
+    Cache cache(0, 1 << SET_BITS, static_cast<int>(state.range(0)), BLOCK_SIZE,
+                SET_BITS, BLOCK_BITS, memory);
+    cache.setFixedGeometry(state.range(1) != 0);
+    Address addr(0x1000, SET_BITS, BLOCK_BITS);
+    cache.read(addr);
+    resolveMiss(cache);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(cache.read(addr));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CacheReadHit)->ArgNames({"E", "fixed"})
+    ->Args({1, 0})->Args({1, 1})->Args({2, 0})->Args({2, 1})->Args({4, 0})->Args({4, 1})->Args({16, 0});
+
+// Write hits on one resident (already modified) block, runtime or precompiled path
+static void BM_CacheWriteHit(benchmark::State& state) {
+    MainMemory memory(BLOCK_SIZE);
+    Cache cache(0, 1 << SET_BITS, static_cast<int>(state.range(0)), BLOCK_SIZE,
+                SET_BITS, BLOCK_BITS, memory);
+    cache.setFixedGeometry(state.range(1) != 0);
+    Address addr(0x1000, SET_BITS, BLOCK_BITS);
+    cache.write(addr);
+    resolveMiss(cache);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(cache.write(addr));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CacheWriteHit)->ArgNames({"E", "fixed"})
+    ->Args({1, 0})->Args({1, 1})->Args({2, 0})->Args({2, 1})->Args({4, 0})->Args({4, 1})->Args({16, 0});
+
+// Read misses streaming through memory (clean victims, fills from memory)
+static void BM_CacheReadMiss(benchmark::State& state) {
+    MainMemory memory(BLOCK_SIZE, state.range(1) != 0);
+    Cache cache(0, 1 << SET_BITS, static_cast<int>(state.range(0)), BLOCK_SIZE,
+                SET_BITS, BLOCK_BITS, memory);
+    uint32_t address = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(cache.read(Address(address, SET_BITS, BLOCK_BITS)));
+        resolveMiss(cache);
+        address += BLOCK_SIZE;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CacheReadMiss)->ArgNames({"E", "data"})
+    ->Args({1, 1})->Args({4, 1})->Args({16, 1})->Args({4, 0});
+
+// Write misses streaming through memory (dirty victims written back)
+static void BM_CacheWriteMiss(benchmark::State& state) {
+    MainMemory memory(BLOCK_SIZE, state.range(1) != 0);
+    Cache cache(0, 1 << SET_BITS, static_cast<int>(state.range(0)), BLOCK_SIZE,
+                SET_BITS, BLOCK_BITS, memory);
+    uint32_t address = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(cache.write(Address(address, SET_BITS, BLOCK_BITS)));
+        resolveMiss(cache);
+        address += BLOCK_SIZE;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CacheWriteMiss)->ArgNames({"E", "data"})
+    ->Args({1, 1})->Args({4, 1})->Args({16, 1})->Args({4, 0});
+
+//------------------------------------------------------------------------------
+// MainMemory
+//------------------------------------------------------------------------------
+
+// Reads of blocks never written (served by the shared zero block)
+static void BM_MainMemoryReadUntouched(benchmark::State& state) {
+    MainMemory memory(BLOCK_SIZE);
+    uint32_t address = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(memory.readBlock(address));
+        address += BLOCK_SIZE;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MainMemoryReadUntouched);
+
+// Writebacks to random blocks of a footprint (0: every write is a new block)
+static void BM_MainMemoryWrite(benchmark::State& state) {
+    MainMemory memory(BLOCK_SIZE);
+    std::vector<uint8_t> data(BLOCK_SIZE, 0xAB);
+    uint32_t footprint = static_cast<uint32_t>(state.range(0));
+    uint32_t seed = 1;
+    uint32_t address = 0;
+    for (auto _ : state) {
+        if (footprint) {
+            address = (nextRandom(seed) % footprint) << BLOCK_BITS;
+        } else {
+            address += BLOCK_SIZE;
+        }
+        memory.writeBlock(address, data);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MainMemoryWrite)->ArgName("blocks")->Arg(0)->Arg(1 << 12)->Arg(1 << 18);
+
+//------------------------------------------------------------------------------
+// Address decoding
+//------------------------------------------------------------------------------
+
+// Decode an integer address into tag, index and offset
+static void BM_AddressDecode(benchmark::State& state) {
+    uint32_t rng = 0x9E3779B9;
+    for (auto _ : state) {
+        Address addr(nextRandom(rng), SET_BITS, BLOCK_BITS);
+        benchmark::DoNotOptimize(addr.getTag());
+        benchmark::DoNotOptimize(addr.getIndex());
+        benchmark::DoNotOptimize(addr.getOffset());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AddressDecode);
+
+// Parse a trace-style hex string into an address
+static void BM_AddressFromHex(benchmark::State& state) {
+    const std::string hex = "0x7ffd3a2c";
+    for (auto _ : state) {
+        Address addr(hex, SET_BITS, BLOCK_BITS);
+        benchmark::DoNotOptimize(addr.getBlockAddress());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AddressFromHex);
+
+//------------------------------------------------------------------------------
+// Trace reading
+//------------------------------------------------------------------------------
+
+// Decode app1's core-0 trace from the files (text or .btrace, whichever is present)
+static void BM_TraceReaderNext(benchmark::State& state) {
+    TraceReader reader("app1");
+    if (!reader.openTraceFiles()) {
+        state.SkipWithError("app1 traces not found");
+        return;
+    }
+    for (auto _ : state) {
+        if (!reader.hasMoreInstructions(0)) {
+            state.PauseTiming();
+            reader.resetTraces();
+            state.ResumeTiming();
+        }
+        benchmark::DoNotOptimize(reader.getNextInstruction(0));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TraceReaderNext);
+
+//------------------------------------------------------------------------------
+// Coherence
+//------------------------------------------------------------------------------
+
+// Two cores writing one block in turn: every write is a BusRdX through the
+// simulator's coherence callback that invalidates the other copy
+static void BM_CoherencePingPong(benchmark::State& state) {
+    SimulationConfig config;
+    config.appName = "app1";
+    config.setBits = SET_BITS;
+    config.associativity = 2;
+    config.blockBits = BLOCK_BITS;
+    config.snoopFilter = state.range(0) != 0;
+    Simulator sim(config);
+    if (!sim.initialize()) {
+        state.SkipWithError("app1 traces not found");
+        return;
+    }
+    Cache& first  = *sim.getCaches()[0];
+    Cache& second = *sim.getCaches()[1];
+    Address addr(0x2000, SET_BITS, BLOCK_BITS);
+    for (auto _ : state) {
+        first.write(addr);
+        resolveMiss(first);
+        second.write(addr);
+        resolveMiss(second);
+    }
+    state.SetItemsProcessed(2 * state.iterations());
+}
+BENCHMARK(BM_CoherencePingPong)->ArgName("snoop_filter")->Arg(0)->Arg(1);
+
+//------------------------------------------------------------------------------
+// End to end
+//------------------------------------------------------------------------------
+
+// Whole simulation of an application from traces decoded once up front;
+// reports simulated memory accesses per second
+static void BM_Simulate(benchmark::State& state, const std::string& app) {
+    static std::shared_ptr<const SharedTrace> loaded[2];
+    std::shared_ptr<const SharedTrace>& traces = loaded[app == "app2"];
+    if (!traces && tracesPresent(app)) {
+        traces = SharedTrace::load(app);
+    }
+    if (!traces) {
+        state.SkipWithError((app + " traces not found").c_str());
+        return;
+    }
+
+    SimulationConfig config;
+    config.appName = app;
+    config.setBits = SET_BITS;
+    config.associativity = 2;
+    config.blockBits = BLOCK_BITS;
+    config.eventDriven = state.range(0) != 0;
+    uint64_t accesses = 0;
+    for (auto _ : state) {
+        Simulator sim(config, traces);
+        sim.initialize();
+        sim.run();
+        accesses += sim.getTotalInstructions();
+    }
+    state.counters["accesses_per_second"] =
+        benchmark::Counter(static_cast<double>(accesses), benchmark::Counter::kIsRate);
+}
+BENCHMARK_CAPTURE(BM_Simulate, app1, std::string("app1"))
+    ->ArgName("event_driven")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_Simulate, app2, std::string("app2"))
+    ->ArgName("event_driven")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// The same traces through one FunctionalCacheModel per core (no timing or
+// coherence), to compare with BM_Simulate's accesses per second
+static void BM_FunctionalModel(benchmark::State& state, const std::string& app) {
+    static std::shared_ptr<const SharedTrace> loaded[2];
+    std::shared_ptr<const SharedTrace>& traces = loaded[app == "app2"];
+    if (!traces && tracesPresent(app)) {
+        traces = SharedTrace::load(app);
+    }
+    if (!traces) {
+        state.SkipWithError((app + " traces not found").c_str());
+        return;
+    }
+
+    uint64_t accesses = 0;
+    for (auto _ : state) {
+        for (const auto& core : traces->cores) {
+            FunctionalCacheModel model(SET_BITS, 2, BLOCK_BITS);
+            accesses += model.run(core).accesses;
+        }
+    }
+    state.counters["accesses_per_second"] =
+        benchmark::Counter(static_cast<double>(accesses), benchmark::Counter::kIsRate);
+}
+BENCHMARK_CAPTURE(BM_FunctionalModel, app1, std::string("app1"))
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_FunctionalModel, app2, std::string("app2"))
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,67 @@
+#ifndef CACHE_GEOMETRY_H
+#define CACHE_GEOMETRY_H
+
+#include <cstdint>
+#include "CacheSet.h"
+
+// Address decoding and tag probing for Cache's read/write hit path.
+//
+// Cache instantiates its access path once per geometry type. RuntimeGeometry
+// takes s/E/b from the configuration and works for every cache; each
+// FixedGeometry<SetBits, Ways, BlockBits> bakes them in, so the shifts and
+// masks are constants and the way loop is unrolled. Cache::selectAccessPath
+// picks a fixed instantiation when the configuration matches one of the
+// precompiled geometries and falls back to RuntimeGeometry otherwise.
+//
+// Both types have the same interface, so the access path is written once:
+//   index(address) / tag(address) / offset(address)
+//   findLine(set, tag)  ->  the valid way holding `tag`, or nullptr
+
+// Geometry known only at run time (any s, E, b)
+struct RuntimeGeometry {
+    int setBits;
+    int blockBits;
+
+    // Constructor
+    RuntimeGeometry(int setBits, int associativity, int blockBits)
+        : setBits(setBits), blockBits(blockBits) {}
+
+    uint32_t index(uint32_t address) const {
+        return (address >> blockBits) & ((1u << setBits) - 1);
+    }
+    uint32_t tag(uint32_t address) const {
+        return address >> (setBits + blockBits);
+    }
+    uint32_t offset(uint32_t address) const {
+        return address & ((1u << blockBits) - 1);
+    }
+    CacheLine* findLine(CacheSet& set, uint32_t tag) const {
+        return set.findLine(tag);
+    }
+};
+
+// Geometry fixed at compile time
+template <int SetBits, int Ways, int BlockBits>
+struct FixedGeometry {
+    static constexpr uint32_t INDEX_MASK = (1u << SetBits) - 1;
+    static constexpr uint32_t OFFSET_MASK = (1u << BlockBits) - 1;
+    static constexpr int TAG_SHIFT = SetBits + BlockBits;
+
+    // Constructor (the configuration is already known to match)
+    FixedGeometry(int, int, int) {}
+
+    uint32_t index(uint32_t address) const {
+        return (address >> BlockBits) & INDEX_MASK;
+    }
+    uint32_t tag(uint32_t address) const {
+        return address >> TAG_SHIFT;
+    }
+    uint32_t offset(uint32_t address) const {
+        return address & OFFSET_MASK;
+    }
+    CacheLine* findLine(CacheSet& set, uint32_t tag) const {
+        return set.findLineFixed<Ways>(tag);
+    }
+};
+
+#endif // CACHE_GEOMETRY_H
@@ -1,176 +1,547 @@
-#include "CacheSet.h"
-#include <algorithm>
-#include <limits>
-#include <iostream>
-
-// Constructor - initialize an empty set with specified associativity and block size
-CacheSet::CacheSet(unsigned int associativity, int blockSize) 
-    : lruCounter(0), associativity(associativity) {
-    
-    // Create specified number of cache lines
-    lines.reserve(associativity);
-    for (unsigned int i = 0; i < associativity; i++) {
-        lines.emplace_back(blockSize);
-    }
-}
-
-// Find a cache line matching the specified tag
-CacheLine* CacheSet::findLine(uint32_t tag) {
-    for (auto& line : lines) {
-        if (line.isValid() && line.getTag() == tag) {
-            return &line;
-        }
-    }
-    return nullptr;
-}
-
-// Find a cache line matching the specified tag (const version)
-const CacheLine* CacheSet::findLine(uint32_t tag) const {
-    for (const auto& line : lines) {
-        if (line.isValid() && line.getTag() == tag) {
-            return &line;
-        }
-    }
-    return nullptr;
-}
-
-// Find a victim line for replacement using LRU policy
-CacheLine* CacheSet::findVictim() {
-    // First, try to find an invalid line
-    CacheLine* invalidLine = findInvalidLine();
-    if (invalidLine != nullptr) {
-        return invalidLine;
-    }
-    
-    // If all lines are valid, find the one with the lowest LRU counter
-    CacheLine* victim = &lines[0];
-    unsigned int lowestCounter = lines[0].getLRUCounter();
-    
-    for (auto& line : lines) {
-        if (line.getLRUCounter() < lowestCounter) {
-            lowestCounter = line.getLRUCounter();
-            victim = &line;
-        }
-    }
-    
-    return victim;
-}
-
-// Update LRU status of a line that was just accessed
-void CacheSet::updateLRU(CacheLine* line) {
-    // Increment global counter
-    lruCounter++;
-    
-    // Prevent potential overflow
-    if (lruCounter == std::numeric_limits<unsigned int>::max()) {
-        // Reset all counters while maintaining relative ordering
-        std::vector<std::pair<unsigned int, CacheLine*>> lineCounters;
-        lineCounters.reserve(lines.size());
-        
-        for (auto& cacheLine : lines) {
-            if (cacheLine.isValid()) {
-                lineCounters.emplace_back(cacheLine.getLRUCounter(), &cacheLine);
-            }
-        }
-        
-        // Sort by counter value (ascending)
-        std::sort(lineCounters.begin(), lineCounters.end(),
-                 [](const auto& a, const auto& b) { return a.first < b.first; });
-        
-        // Reassign counters starting from 0 with increments of 1
-        for (size_t i = 0; i < lineCounters.size(); i++) {
-            lineCounters[i].second->setLRUCounter(i);
-        }
-        
-        // Reset global counter
-        lruCounter = lineCounters.size();
-    }
-    
-    // Update the accessed line's counter to the current global counter
-    line->setLRUCounter(lruCounter);
-}
-
-// Check if set is full (no invalid lines)
-bool CacheSet::isFull() const {
-    for (const auto& line : lines) {
-        if (!line.isValid()) {
-            return false;
-        }
-    }
-    return true;
-}
-
-// Find an invalid line if one exists
-CacheLine* CacheSet::findInvalidLine() {
-    for (auto& line : lines) {
-        if (!line.isValid()) {
-            return &line;
-        }
-    }
-    return nullptr;
-}
-
-// Get vector of all cache lines in this set
-const std::vector<CacheLine>& CacheSet::getLines() const {
-    return lines;
-}
-
-// Get modifiable reference to lines (for coherence operations)
-std::vector<CacheLine>& CacheSet::getLinesModifiable() {
-    return lines;
-}
-
-// Get number of lines in this set (associativity)
-unsigned int CacheSet::getAssociativity() const {
-    return associativity;
-}
-
-// Get the current LRU counter value
-unsigned int CacheSet::getLRUCounter() const {
-    return lruCounter;
-}
-
-// Invalidate any line with the specified tag
-bool CacheSet::invalidateLine(uint32_t tag) {
-    for (auto& line : lines) {
-        if (line.isValid() && line.getTag() == tag) {
-            line.setMESIState(MESIState::INVALID);
-            return true;
-        }
-    }
-    return false;
-}
-
-// Change state of a line with matching tag to Shared
-bool CacheSet::changeToShared(uint32_t tag) {
-    for (auto& line : lines) {
-        if (line.isValid() && line.getTag() == tag) {
-            if (line.getMESIState() == MESIState::MODIFIED || 
-                line.getMESIState() == MESIState::EXCLUSIVE) {
-                line.setMESIState(MESIState::SHARED);
-                return true;
-            }
-        }
-    }
-    return false;
-}
-
-// Find any line in a specific MESI state
-CacheLine* CacheSet::findLineInState(uint32_t tag, MESIState state) {
-    for (auto& line : lines) {
-        if (line.isValid() && line.getTag() == tag && line.getMESIState() == state) {
-            return &line;
-        }
-    }
-    return nullptr;
-}
-
-// Check if any line has the tag in any valid state
-bool CacheSet::hasLineInAnyState(uint32_t tag) {
-    for (const auto& line : lines) {
-        if (line.isValid() && line.getTag() == tag) {
-            return true;
-        }
-    }
-    return false;
-}
\ No newline at end of file
+#include "CacheSet.h"
+#include "Checkpoint.h"
+#include <algorithm>
+#include <limits>
+#include <iostream>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Round a way count up to the SIMD padding granularity
+static unsigned int paddedWays(unsigned int associativity) {
+    return (associativity + CacheSet::SIMD_BLOCK - 1) / CacheSet::SIMD_BLOCK * CacheSet::SIMD_BLOCK;
+}
+
+// Bit mask selecting the real (non-padding) ways of the 16-way block starting at `base`
+static inline uint32_t blockLaneMask(unsigned int base, unsigned int associativity) {
+    unsigned int remaining = associativity - base;
+    return remaining >= CacheSet::SIMD_BLOCK ? 0xFFFFu : ((1u << remaining) - 1);
+}
+
+#if defined(__SSE2__)
+// One bit per way of a 16-way block whose state is INVALID
+static inline uint32_t invalidMask16(const MESIState* states) {
+    __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(states));
+    __m128i inv = _mm_set1_epi8(static_cast<char>(MESIState::INVALID));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(s, inv)));
+}
+
+// One bit per way of a 16-way block whose tag equals `tag`
+static inline uint32_t tagMask16(const uint32_t* tags, uint32_t tag) {
+#if defined(__AVX2__)
+    __m256i key = _mm256_set1_epi32(static_cast<int>(tag));
+    __m256i lo = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(tags)), key);
+    __m256i hi = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(tags + 8)), key);
+    return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(lo))) |
+           static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(hi))) << 8;
+#else
+    __m128i key = _mm_set1_epi32(static_cast<int>(tag));
+    uint32_t mask = 0;
+    for (int i = 0; i < 4; i++) {
+        __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags + 4 * i));
+        mask |= static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(t, key)))) << (4 * i);
+    }
+    return mask;
+#endif
+}
+#endif
+
+// Tree-PLRU leaves for an associativity: the next power of two
+static unsigned int plruLeafCount(unsigned int associativity) {
+    unsigned int leaves = 1;
+    while (leaves < associativity) leaves <<= 1;
+    return leaves;
+}
+
+// RRIP prediction values (2 bits): 0 = imminent ... 3 = distant
+static const uint8_t RRPV_DISTANT = 3;
+static const uint8_t RRPV_LONG = 2;
+
+// BRRIP inserts with a long (not distant) prediction once per this many fills
+static const uint32_t BRRIP_LONG_FILLS = 32;
+
+// Constructor - initialize an empty set with specified associativity, block size and policy
+CacheSet::CacheSet(unsigned int associativity, int blockSize, ReplacementPolicy policy) 
+    : lruCounter(0), associativity(associativity), policy(policy),
+      plruLeaves(plruLeafCount(associativity)), randomState(0x9E3779B9u) {
+    
+    // Padding ways are INVALID with the largest LRU counter, so they never
+    // match a tag, are never reported as free and never win victim selection
+    unsigned int padded = paddedWays(associativity);
+    tags.assign(padded, 0);
+    states.assign(padded, MESIState::INVALID);
+    
+    // Only the metadata of the chosen policy is kept
+    switch (policy) {
+      case ReplacementPolicy::LRU:
+      case ReplacementPolicy::TRUE_LRU:
+        lruCounters.assign(padded, std::numeric_limits<unsigned int>::max());
+        break;
+      case ReplacementPolicy::PLRU:
+        plruBits.assign((plruLeaves + 63) / 64, 0);
+        break;
+      case ReplacementPolicy::SRRIP:
+      case ReplacementPolicy::BRRIP:
+        rrpvs.assign(padded, 0); // Padding stays 0, so it never looks distant
+        break;
+      case ReplacementPolicy::RANDOM:
+        break;
+    }
+    
+    // Create specified number of cache lines
+    lines.reserve(associativity);
+    for (unsigned int i = 0; i < associativity; i++) {
+        lines.emplace_back(blockSize, &tags[i], &states[i], lruCounters.empty() ? nullptr : &lruCounters[i]);
+    }
+    if (!rrpvs.empty()) {
+        std::fill(rrpvs.begin(), rrpvs.begin() + associativity, RRPV_DISTANT);
+    }
+}
+
+// Copy constructor
+CacheSet::CacheSet(const CacheSet& other)
+    : tags(other.tags), states(other.states), lruCounters(other.lruCounters),
+      rrpvs(other.rrpvs), plruBits(other.plruBits),
+      lines(other.lines), lruCounter(other.lruCounter), associativity(other.associativity),
+      policy(other.policy), plruLeaves(other.plruLeaves), randomState(other.randomState) {
+    bindLines();
+}
+
+// Move constructor
+CacheSet::CacheSet(CacheSet&& other) noexcept
+    : tags(std::move(other.tags)), states(std::move(other.states)),
+      lruCounters(std::move(other.lruCounters)), rrpvs(std::move(other.rrpvs)),
+      plruBits(std::move(other.plruBits)), lines(std::move(other.lines)),
+      lruCounter(other.lruCounter), associativity(other.associativity),
+      policy(other.policy), plruLeaves(other.plruLeaves), randomState(other.randomState) {
+    bindLines();
+}
+
+// Copy assignment
+CacheSet& CacheSet::operator=(const CacheSet& other) {
+    if (this != &other) {
+        tags = other.tags;
+        states = other.states;
+        lruCounters = other.lruCounters;
+        rrpvs = other.rrpvs;
+        plruBits = other.plruBits;
+        lines = other.lines;
+        lruCounter = other.lruCounter;
+        associativity = other.associativity;
+        policy = other.policy;
+        plruLeaves = other.plruLeaves;
+        randomState = other.randomState;
+        bindLines();
+    }
+    return *this;
+}
+
+// Move assignment
+CacheSet& CacheSet::operator=(CacheSet&& other) noexcept {
+    if (this != &other) {
+        tags = std::move(other.tags);
+        states = std::move(other.states);
+        lruCounters = std::move(other.lruCounters);
+        rrpvs = std::move(other.rrpvs);
+        plruBits = std::move(other.plruBits);
+        lines = std::move(other.lines);
+        lruCounter = other.lruCounter;
+        associativity = other.associativity;
+        policy = other.policy;
+        plruLeaves = other.plruLeaves;
+        randomState = other.randomState;
+        bindLines();
+    }
+    return *this;
+}
+
+// Point every line's handle at this set's arrays
+void CacheSet::bindLines() {
+    for (unsigned int i = 0; i < lines.size(); i++) {
+        lines[i].bindMetadata(&tags[i], &states[i], lruCounters.empty() ? nullptr : &lruCounters[i]);
+    }
+}
+
+// Index of the valid way holding `tag`, or associativity if none
+unsigned int CacheSet::findWay(uint32_t tag) const {
+#if defined(__SSE2__)
+    for (unsigned int base = 0; base < associativity; base += SIMD_BLOCK) {
+        uint32_t match = tagMask16(&tags[base], tag) & ~invalidMask16(&states[base]) &
+                         blockLaneMask(base, associativity);
+        if (match) {
+            return base + __builtin_ctz(match);
+        }
+    }
+#else
+    for (unsigned int w = 0; w < associativity; w++) {
+        if (states[w] != MESIState::INVALID && tags[w] == tag) {
+            return w;
+        }
+    }
+#endif
+    return associativity;
+}
+
+// Index of the first invalid way still holding `tag`, or associativity if none
+unsigned int CacheSet::findStaleWay(uint32_t tag) const {
+#if defined(__SSE2__)
+    for (unsigned int base = 0; base < associativity; base += SIMD_BLOCK) {
+        uint32_t match = tagMask16(&tags[base], tag) & invalidMask16(&states[base]) &
+                         blockLaneMask(base, associativity);
+        if (match) {
+            return base + __builtin_ctz(match);
+        }
+    }
+#else
+    for (unsigned int w = 0; w < associativity; w++) {
+        if (states[w] == MESIState::INVALID && tags[w] == tag) {
+            return w;
+        }
+    }
+#endif
+    return associativity;
+}
+
+// Index of the first invalid way, or associativity if the set is full
+unsigned int CacheSet::findInvalidWay() const {
+#if defined(__SSE2__)
+    for (unsigned int base = 0; base < associativity; base += SIMD_BLOCK) {
+        uint32_t free = invalidMask16(&states[base]) & blockLaneMask(base, associativity);
+        if (free) {
+            return base + __builtin_ctz(free);
+        }
+    }
+#else
+    for (unsigned int w = 0; w < associativity; w++) {
+        if (states[w] == MESIState::INVALID) {
+            return w;
+        }
+    }
+#endif
+    return associativity;
+}
+
+// Index of the first way with the lowest LRU counter
+unsigned int CacheSet::findLRUWay() const {
+#if defined(__AVX2__)
+    // Vertical minimum over 8-way chunks; padding ways hold the maximum counter
+    __m256i best = _mm256_set1_epi32(-1);
+    for (unsigned int base = 0; base < associativity; base += 8) {
+        best = _mm256_min_epu32(best, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&lruCounters[base])));
+    }
+    __m128i m = _mm_min_epu32(_mm256_castsi256_si128(best), _mm256_extracti128_si256(best, 1));
+    m = _mm_min_epu32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_min_epu32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+    __m256i lowest = _mm256_broadcastd_epi32(m);
+    
+    // First way holding that minimum (stable with the scalar tie-breaking)
+    for (unsigned int base = 0; base < associativity; base += 8) {
+        __m256i eq = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&lruCounters[base])), lowest);
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(eq)));
+        if (mask) {
+            return base + __builtin_ctz(mask);
+        }
+    }
+    return 0;
+#else
+    unsigned int victim = 0;
+    unsigned int lowestCounter = lruCounters[0];
+    for (unsigned int w = 1; w < associativity; w++) {
+        if (lruCounters[w] < lowestCounter) {
+            lowestCounter = lruCounters[w];
+            victim = w;
+        }
+    }
+    return victim;
+#endif
+}
+
+// Find a cache line matching the specified tag
+CacheLine* CacheSet::findLine(uint32_t tag) {
+    unsigned int way = findWay(tag);
+    return way < associativity ? &lines[way] : nullptr;
+}
+
+// Find a cache line matching the specified tag (const version)
+const CacheLine* CacheSet::findLine(uint32_t tag) const {
+    unsigned int way = findWay(tag);
+    return way < associativity ? &lines[way] : nullptr;
+}
+
+// Index of the victim the tree points at. Each node bit names the colder
+// half (0 = left, 1 = right); a right half with no real ways is skipped.
+unsigned int CacheSet::findPLRUWay() const {
+    unsigned int node = 1;
+    unsigned int span = plruLeaves;   // Leaves under `node`
+    unsigned int first = 0;           // First leaf under `node`
+    while (node < plruLeaves) {
+        span >>= 1;
+        bool right = (plruBits[node >> 6] >> (node & 63)) & 1;
+        if (right && first + span >= associativity) {
+            right = false;
+        }
+        node = 2 * node + right;
+        if (right) first += span;
+    }
+    return first;
+}
+
+// Index of the first way predicted distant, ageing the set until one is
+unsigned int CacheSet::findRRIPWay() {
+#if defined(__SSE2__)
+    __m128i highest = _mm_setzero_si128();
+    for (unsigned int base = 0; base < associativity; base += SIMD_BLOCK) {
+        highest = _mm_max_epu8(highest, _mm_loadu_si128(reinterpret_cast<const __m128i*>(&rrpvs[base])));
+    }
+    highest = _mm_max_epu8(highest, _mm_srli_si128(highest, 8));
+    highest = _mm_max_epu8(highest, _mm_srli_si128(highest, 4));
+    highest = _mm_max_epu8(highest, _mm_srli_si128(highest, 2));
+    highest = _mm_max_epu8(highest, _mm_srli_si128(highest, 1));
+    uint8_t oldest = static_cast<uint8_t>(_mm_cvtsi128_si32(highest));
+#else
+    uint8_t oldest = 0;
+    for (unsigned int w = 0; w < associativity; w++) {
+        oldest = std::max(oldest, rrpvs[w]);
+    }
+#endif
+    
+    // Ageing every way by the same amount is the same as repeating the
+    // +1 sweep until some way reaches the distant value
+    if (oldest < RRPV_DISTANT) {
+        uint8_t age = RRPV_DISTANT - oldest;
+        for (unsigned int w = 0; w < associativity; w++) {
+            rrpvs[w] += age;
+        }
+    }
+    
+#if defined(__SSE2__)
+    __m128i distant = _mm_set1_epi8(static_cast<char>(RRPV_DISTANT));
+    for (unsigned int base = 0; base < associativity; base += SIMD_BLOCK) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&rrpvs[base]));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, distant)))
+                        & blockLaneMask(base, associativity);
+        if (mask) {
+            return base + __builtin_ctz(mask);
+        }
+    }
+#else
+    for (unsigned int w = 0; w < associativity; w++) {
+        if (rrpvs[w] == RRPV_DISTANT) {
+            return w;
+        }
+    }
+#endif
+    return 0;
+}
+
+// Index of a uniformly chosen way
+unsigned int CacheSet::findRandomWay() {
+    return nextRandom() % associativity;
+}
+
+// Next value of the set's xorshift32 generator
+uint32_t CacheSet::nextRandom() {
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+// Find a victim line for replacement
+CacheLine* CacheSet::findVictim() {
+    // First, try to find an invalid line
+    unsigned int way = findInvalidWay();
+    if (way < associativity) {
+        return &lines[way];
+    }
+    
+    // If all lines are valid, ask the policy
+    switch (policy) {
+      case ReplacementPolicy::LRU:
+      case ReplacementPolicy::TRUE_LRU: return &lines[findLRUWay()];
+      case ReplacementPolicy::PLRU:     return &lines[findPLRUWay()];
+      case ReplacementPolicy::SRRIP:
+      case ReplacementPolicy::BRRIP:    return &lines[findRRIPWay()];
+      case ReplacementPolicy::RANDOM:   return &lines[findRandomWay()];
+    }
+    return &lines[0];
+}
+
+// Stamp a way with the next value of the set's LRU counter
+void CacheSet::touchLRU(unsigned int way) {
+    // Increment global counter
+    lruCounter++;
+    
+    // Prevent potential overflow
+    if (lruCounter == std::numeric_limits<unsigned int>::max()) {
+        // Reset all counters while maintaining relative ordering
+        std::vector<std::pair<unsigned int, unsigned int>> wayCounters;
+        wayCounters.reserve(associativity);
+        
+        for (unsigned int w = 0; w < associativity; w++) {
+            if (states[w] != MESIState::INVALID) {
+                wayCounters.emplace_back(lruCounters[w], w);
+            }
+        }
+        
+        // Sort by counter value (ascending)
+        std::sort(wayCounters.begin(), wayCounters.end(),
+                 [](const auto& a, const auto& b) { return a.first < b.first; });
+        
+        // Reassign counters starting from 0 with increments of 1
+        for (size_t i = 0; i < wayCounters.size(); i++) {
+            lruCounters[wayCounters[i].second] = i;
+        }
+        
+        // Reset global counter
+        lruCounter = wayCounters.size();
+    }
+    
+    // Update the accessed line's counter to the current global counter
+    lruCounters[way] = lruCounter;
+}
+
+// Point every node on the way's path at the other half
+void CacheSet::touchPLRU(unsigned int way) {
+    unsigned int node = plruLeaves + way;
+    while (node > 1) {
+        unsigned int parent = node >> 1;
+        uint64_t bit = 1ull << (parent & 63);
+        if (node & 1) {
+            plruBits[parent >> 6] &= ~bit;  // Came from the right: left is colder
+        } else {
+            plruBits[parent >> 6] |= bit;
+        }
+        node = parent;
+    }
+}
+
+// Update replacement state of a line that was just accessed
+void CacheSet::updateLRU(CacheLine* line) {
+    unsigned int way = static_cast<unsigned int>(line - lines.data());
+    switch (policy) {
+      case ReplacementPolicy::LRU:
+      case ReplacementPolicy::TRUE_LRU: touchLRU(way); break;
+      case ReplacementPolicy::PLRU:     touchPLRU(way); break;
+      case ReplacementPolicy::SRRIP:
+      case ReplacementPolicy::BRRIP:    rrpvs[way] = 0; break;
+      case ReplacementPolicy::RANDOM:   break;
+    }
+}
+
+// Update replacement state of a line that was just filled
+void CacheSet::insertLine(CacheLine* line) {
+    unsigned int way = static_cast<unsigned int>(line - lines.data());
+    switch (policy) {
+      case ReplacementPolicy::LRU:      break; // Fills keep their old counter
+      case ReplacementPolicy::TRUE_LRU: touchLRU(way); break;
+      case ReplacementPolicy::PLRU:     touchPLRU(way); break;
+      case ReplacementPolicy::SRRIP:    rrpvs[way] = RRPV_LONG; break;
+      case ReplacementPolicy::BRRIP:
+        rrpvs[way] = nextRandom() % BRRIP_LONG_FILLS == 0 ? RRPV_LONG : RRPV_DISTANT;
+        break;
+      case ReplacementPolicy::RANDOM:   break;
+    }
+}
+
+// Get the set's replacement policy
+ReplacementPolicy CacheSet::getPolicy() const {
+    return policy;
+}
+
+// Check if set is full (no invalid lines)
+bool CacheSet::isFull() const {
+    return findInvalidWay() == associativity;
+}
+
+// Find an invalid line if one exists
+CacheLine* CacheSet::findInvalidLine() {
+    unsigned int way = findInvalidWay();
+    return way < associativity ? &lines[way] : nullptr;
+}
+
+// Get vector of all cache lines in this set
+const std::vector<CacheLine>& CacheSet::getLines() const {
+    return lines;
+}
+
+// Get modifiable reference to lines (for coherence operations)
+std::vector<CacheLine>& CacheSet::getLinesModifiable() {
+    return lines;
+}
+
+// Get number of lines in this set (associativity)
+unsigned int CacheSet::getAssociativity() const {
+    return associativity;
+}
+
+// Get the current LRU counter value
+unsigned int CacheSet::getLRUCounter() const {
+    return lruCounter;
+}
+
+// Invalidate any line with the specified tag
+bool CacheSet::invalidateLine(uint32_t tag) {
+    CacheLine* line = findLine(tag);
+    if (line) {
+        line->setMESIState(MESIState::INVALID);
+        return true;
+    }
+    return false;
+}
+
+// Change state of a line with matching tag to Shared
+bool CacheSet::changeToShared(uint32_t tag) {
+    CacheLine* line = findLine(tag);
+    if (line && (line->getMESIState() == MESIState::MODIFIED || 
+                 line->getMESIState() == MESIState::EXCLUSIVE)) {
+        line->setMESIState(MESIState::SHARED);
+        return true;
+    }
+    return false;
+}
+
+// Find any line in a specific MESI state
+CacheLine* CacheSet::findLineInState(uint32_t tag, MESIState state) {
+    CacheLine* line = findLine(tag);
+    return (line && line->getMESIState() == state) ? line : nullptr;
+}
+
+// Check if any line has the tag in any valid state
+bool CacheSet::hasLineInAnyState(uint32_t tag) {
+    return findWay(tag) < associativity;
+}
+
+// Check if an invalidated way still carries the tag
+bool CacheSet::hasStaleTag(uint32_t tag) const {
+    return findStaleWay(tag) < associativity;
+}
+
+// Checkpoint every way and the replacement state
+void CacheSet::saveState(CheckpointWriter& out) const {
+    out.putVector(tags);
+    out.putVector(states);
+    out.putVector(lruCounters);
+    out.putVector(rrpvs);
+    out.putVector(plruBits);
+    out.put(lruCounter);
+    out.put(randomState);
+    for (const auto& line : lines) {
+        line.saveState(out);
+    }
+}
+
+// Restore the ways in place, so the lines stay bound to the metadata arrays
+void CacheSet::loadState(CheckpointReader& in) {
+    in.getVectorInto(tags);
+    in.getVectorInto(states);
+    in.getVectorInto(lruCounters);
+    in.getVectorInto(rrpvs);
+    in.getVectorInto(plruBits);
+    lruCounter = in.get<unsigned int>();
+    randomState = in.get<uint32_t>();
+    for (auto& line : lines) {
+        line.loadState(in);
+    }
+}
@@ -1,67 +1,145 @@
-#ifndef CACHE_SET_H
-#define CACHE_SET_H
-
-#include <vector>
-#include "CacheLine.h"
-#include "Address.h"
-
-class CacheSet {
-private:
-    std::vector<CacheLine> lines;    // Cache lines in this set
-    unsigned int lruCounter;         // Global counter for LRU tracking
-    unsigned int associativity;      // Number of cache lines in this set (E)
-
-public:
-    // Constructor - initialize an empty set with specified associativity and block size
-    CacheSet(unsigned int associativity, int blockSize);
-    
-    // Find a cache line matching the specified tag
-    // Returns pointer to the line if found, nullptr if not found
-    CacheLine* findLine(uint32_t tag);
-    
-    // Find a cache line matching the specified tag (const version)
-    // Returns pointer to the line if found, nullptr if not found
-    const CacheLine* findLine(uint32_t tag) const;
-    
-    // Find a victim line for replacement
-    // Returns pointer to the LRU line
-    CacheLine* findVictim();
-    
-    // Update LRU status of a line that was just accessed
-    void updateLRU(CacheLine* line);
-    
-    // Check if set is full (no invalid lines)
-    bool isFull() const;
-    
-    // Find an invalid line if one exists
-    // Returns pointer to an invalid line, or nullptr if all lines are valid
-    CacheLine* findInvalidLine();
-    
-    // Get vector of all cache lines in this set
-    const std::vector<CacheLine>& getLines() const;
-    
-    // Get modifiable reference to lines (for coherence operations)
-    std::vector<CacheLine>& getLinesModifiable();
-    
-    // Get number of lines in this set (associativity)
-    unsigned int getAssociativity() const;
-    
-    // Get the current LRU counter value
-    unsigned int getLRUCounter() const;
-    
-    // New methods for coherence
-    
-    // Invalidate any line with the specified tag
-    bool invalidateLine(uint32_t tag);
-    
-    // Change state of a line with matching tag to Shared
-    bool changeToShared(uint32_t tag);
-    
-    // Find any line in a specific MESI state
-    CacheLine* findLineInState(uint32_t tag, MESIState state);
-    
-    // Check if any line has the tag in any valid state
-    bool hasLineInAnyState(uint32_t tag);
-};
-
+#ifndef CACHE_SET_H
+#define CACHE_SET_H
+
+#include <vector>
+#include "CacheLine.h"
+#include "Address.h"
+#include "ReplacementPolicy.h"
+
+class CacheSet {
+private:
+    // Per-way metadata, structure-of-arrays. Each array is padded up to a
+    // multiple of SIMD_BLOCK ways; padding ways stay INVALID and never match.
+    std::vector<uint32_t> tags;          // Tag of each way
+    std::vector<MESIState> states;       // MESI state of each way
+    std::vector<unsigned int> lruCounters; // LRU counter of each way (LRU policies only)
+    std::vector<uint8_t> rrpvs;          // Re-reference prediction value of each way (RRIP only)
+    std::vector<uint64_t> plruBits;      // Tree-PLRU node bits, node n at bit n (PLRU only)
+    
+    std::vector<CacheLine> lines;    // Cache lines in this set (handles onto the arrays above)
+    unsigned int lruCounter;         // Global counter for LRU tracking
+    unsigned int associativity;      // Number of cache lines in this set (E)
+    ReplacementPolicy policy;        // Victim selection policy
+    unsigned int plruLeaves;         // Tree-PLRU leaves (associativity rounded up to a power of two)
+    uint32_t randomState;            // xorshift32 state (RANDOM victims, BRRIP fills)
+    
+    // Point every line's handle at this set's arrays
+    void bindLines();
+    
+    // Way index helpers; return associativity when nothing matches
+    unsigned int findWay(uint32_t tag) const;
+    unsigned int findInvalidWay() const;
+    unsigned int findStaleWay(uint32_t tag) const;
+    unsigned int findLRUWay() const;
+    
+    // Policy-specific victim selection among valid ways
+    unsigned int findPLRUWay() const;
+    unsigned int findRRIPWay();
+    unsigned int findRandomWay();
+    
+    // Policy-specific recency updates
+    void touchLRU(unsigned int way);
+    void touchPLRU(unsigned int way);
+    
+    // Next value of the set's random generator
+    uint32_t nextRandom();
+
+public:
+    // Ways probed per SIMD step (arrays are padded to a multiple of this)
+    static const unsigned int SIMD_BLOCK = 16;
+    
+    // Constructor - initialize an empty set with specified associativity, block size
+    // and replacement policy
+    CacheSet(unsigned int associativity, int blockSize,
+             ReplacementPolicy policy = ReplacementPolicy::LRU);
+    
+    // Copy/move keep the line handles bound to their own set's arrays
+    CacheSet(const CacheSet& other);
+    CacheSet(CacheSet&& other) noexcept;
+    CacheSet& operator=(const CacheSet& other);
+    CacheSet& operator=(CacheSet&& other) noexcept;
+    
+    // Find a cache line matching the specified tag
+    // Returns pointer to the line if found, nullptr if not found
+    CacheLine* findLine(uint32_t tag);
+    
+    // Find a cache line matching the specified tag (const version)
+    // Returns pointer to the line if found, nullptr if not found
+    const CacheLine* findLine(uint32_t tag) const;
+    
+    // Find a cache line matching the specified tag, with the way count known
+    // at compile time (Ways must equal the set's associativity); the probe
+    // loop is unrolled instead of stepping through SIMD blocks
+    template <unsigned int Ways>
+    CacheLine* findLineFixed(uint32_t tag) {
+        for (unsigned int w = 0; w < Ways; w++) {
+            if (tags[w] == tag && states[w] != MESIState::INVALID) {
+                return &lines[w];
+            }
+        }
+        return nullptr;
+    }
+    
+    // Start loading this set's tags, states and LRU counters into the CPU
+    // caches ahead of an access to it (a hint; never faults)
+    void prefetchMetadata() const {
+        __builtin_prefetch(tags.data());
+        __builtin_prefetch(states.data());
+        if (!lruCounters.empty()) __builtin_prefetch(lruCounters.data());
+    }
+    
+    // Find a victim line for replacement
+    // Returns pointer to an invalid line if any, else the policy's choice
+    CacheLine* findVictim();
+    
+    // Update replacement state of a line that was just accessed (hit)
+    void updateLRU(CacheLine* line);
+    
+    // Update replacement state of a line that was just filled
+    void insertLine(CacheLine* line);
+    
+    // Get the set's replacement policy
+    ReplacementPolicy getPolicy() const;
+    
+    // Check if set is full (no invalid lines)
+    bool isFull() const;
+    
+    // Find an invalid line if one exists
+    // Returns pointer to an invalid line, or nullptr if all lines are valid
+    CacheLine* findInvalidLine();
+    
+    // Get vector of all cache lines in this set
+    const std::vector<CacheLine>& getLines() const;
+    
+    // Get modifiable reference to lines (for coherence operations)
+    std::vector<CacheLine>& getLinesModifiable();
+    
+    // Get number of lines in this set (associativity)
+    unsigned int getAssociativity() const;
+    
+    // Get the current LRU counter value
+    unsigned int getLRUCounter() const;
+    
+    // New methods for coherence
+    
+    // Invalidate any line with the specified tag
+    bool invalidateLine(uint32_t tag);
+    
+    // Change state of a line with matching tag to Shared
+    bool changeToShared(uint32_t tag);
+    
+    // Find any line in a specific MESI state
+    CacheLine* findLineInState(uint32_t tag, MESIState state);
+    
+    // Check if any line has the tag in any valid state
+    bool hasLineInAnyState(uint32_t tag);
+    
+    // Check if an invalidated way still carries the tag
+    bool hasStaleTag(uint32_t tag) const;
+    
+    // Checkpoint every way and the replacement state (same geometry and policy on load)
+    void saveState(CheckpointWriter& out) const;
+    void loadState(CheckpointReader& in);
+};
+
 #endif // CACHE_SET_H
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "Checkpoint.h"
+#include <iostream>
+
+const uint32_t CheckpointWriter::MAGIC;
+const uint16_t CheckpointWriter::VERSION;
+
+// Constructor - creates the file and writes the header
+CheckpointWriter::CheckpointWriter(const std::string& path)
+    : out(path, std::ios::binary | std::ios::trunc) {
+    if (!out.is_open()) {
+        std::cerr << "Error: Could not create checkpoint file: " << path << std::endl;
+        return;
+    }
+    put<uint32_t>(MAGIC);
+    put<uint16_t>(VERSION);
+    put<uint16_t>(0);
+}
+
+// Check the file opened and every write so far succeeded
+bool CheckpointWriter::good() const {
+    return out.is_open() && out.good();
+}
+
+// A string, with its length
+void CheckpointWriter::putString(const std::string& text) {
+    put<uint64_t>(text.size());
+    out.write(text.data(), text.size());
+}
+
+// Constructor - opens the file and checks the header
+CheckpointReader::CheckpointReader(const std::string& path)
+    : in(path, std::ios::binary), bad(false) {
+    if (!in.is_open()) {
+        std::cerr << "Error: Could not open checkpoint file: " << path << std::endl;
+        bad = true;
+        return;
+    }
+    uint32_t magic = get<uint32_t>();
+    uint16_t version = get<uint16_t>();
+    get<uint16_t>();
+    if (bad || magic != CheckpointWriter::MAGIC || version != CheckpointWriter::VERSION) {
+        std::cerr << "Error: Not a checkpoint file (or an unsupported version): " << path << std::endl;
+        bad = true;
+    }
+}
+
+// Check an earlier read failed
+bool CheckpointReader::failed() const {
+    return bad;
+}
+
+// Mark the checkpoint unusable
+void CheckpointReader::fail() {
+    bad = true;
+}
+
+// A string written by putString
+std::string CheckpointReader::getString() {
+    std::vector<char> chars = getVector<char>();
+    return std::string(chars.begin(), chars.end());
+}
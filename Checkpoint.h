@@ -0,0 +1,134 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <type_traits>
+
+// Binary checkpoint of a whole simulation (.l1ckpt, host byte order).
+//
+//   header     : uint32 magic "L1CK", uint16 version, uint16 0
+//   signature  : string describing the configuration the state belongs to
+//   components : Simulator counters, trace positions, main memory, bus, L2,
+//                then per core its cache and processor, each written by the
+//                component's own saveState() and read back by loadState()
+//
+// Values are written raw; vectors and strings are prefixed with a uint64
+// element count. A reader that hits the end of the file or a size that does
+// not match the receiving component marks itself failed, and every later
+// read returns zeros, so loadState() only has to check failed() once.
+class CheckpointWriter {
+public:
+    static const uint32_t MAGIC = 0x4B43314C;   // "L1CK"
+    static const uint16_t VERSION = 2;
+
+    // Constructor - creates the file and writes the header
+    explicit CheckpointWriter(const std::string& path);
+
+    // Check the file opened and every write so far succeeded
+    bool good() const;
+
+    // One trivially copyable value
+    template <class T>
+    void put(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "put() needs a plain value");
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    // A vector of trivially copyable values, with its length
+    template <class T>
+    void putVector(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable<T>::value, "putVector() needs plain values");
+        put<uint64_t>(values.size());
+        if (!values.empty()) {
+            out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+        }
+    }
+
+    // A raw array of trivially copyable values, in putVector's format
+    template <class T>
+    void putArray(const T* values, uint64_t count) {
+        static_assert(std::is_trivially_copyable<T>::value, "putArray() needs plain values");
+        put<uint64_t>(count);
+        if (count) {
+            out.write(reinterpret_cast<const char*>(values), count * sizeof(T));
+        }
+    }
+
+    // A string, with its length
+    void putString(const std::string& text);
+
+private:
+    std::ofstream out;
+};
+
+class CheckpointReader {
+public:
+    // Constructor - opens the file and checks the header
+    explicit CheckpointReader(const std::string& path);
+
+    // Check an earlier read failed (or the file is not a checkpoint)
+    bool failed() const;
+
+    // Mark the checkpoint unusable (e.g. a component's size does not match)
+    void fail();
+
+    // One trivially copyable value (zero once failed)
+    template <class T>
+    T get() {
+        static_assert(std::is_trivially_copyable<T>::value, "get() needs a plain value");
+        T value;
+        std::memset(&value, 0, sizeof(T));
+        if (!bad && !in.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+            bad = true;
+            std::memset(&value, 0, sizeof(T));
+        }
+        return value;
+    }
+
+    // A vector written by putVector; `expected` > 0 requires that length
+    template <class T>
+    std::vector<T> getVector(uint64_t expected = 0) {
+        static_assert(std::is_trivially_copyable<T>::value, "getVector() needs plain values");
+        uint64_t count = get<uint64_t>();
+        std::vector<T> values;
+        if (bad || (expected && count != expected) || count > MAX_ELEMENTS) {
+            bad = true;
+            return values;
+        }
+        values.resize(count);
+        if (count && !in.read(reinterpret_cast<char*>(values.data()), count * sizeof(T))) {
+            bad = true;
+            values.clear();
+        }
+        return values;
+    }
+
+    // Read a vector into an existing one of the same length (its storage,
+    // which other objects may point into, stays where it is)
+    template <class T>
+    void getVectorInto(std::vector<T>& values) {
+        std::vector<T> loaded = getVector<T>(values.size());
+        if (!bad && loaded.size() == values.size()) {
+            std::copy(loaded.begin(), loaded.end(), values.begin());
+        } else {
+            bad = true;
+        }
+    }
+
+    // A string written by putString
+    std::string getString();
+
+private:
+    // Sanity bound on a stored vector's length (guards against corrupt files)
+    static const uint64_t MAX_ELEMENTS = uint64_t(1) << 36;
+
+    std::ifstream in;
+    bool bad;
+};
+
+#endif // CHECKPOINT_H
@@ -1,33 +1,80 @@
-#ifndef COMMAND_LINE_H
-#define COMMAND_LINE_H
-
-#include <string>
-
-// Structure to hold simulation configuration parameters
-struct SimulationConfig {
-    std::string appName;  // Application name for trace files
-    int setBits;          // Number of set index bits (s)
-    int associativity;    // Associativity (E)
-    int blockBits;        // Number of block bits (b)
-    std::string outputFile; // Output file for logging
-    bool helpRequested;   // Whether help was requested
-    
-    // Constructor with default values
-    SimulationConfig() 
-        : appName(""), setBits(0), associativity(0), blockBits(0), 
-          outputFile(""), helpRequested(false) {}
-};
-
-class CommandLine {
-public:
-    // Parse command line arguments and return configuration
-    static SimulationConfig parseArguments(int argc, char* argv[]);
-    
-    // Print help message
-    static void printHelp(const char* programName);
-    
-    // Validate configuration
-    static bool validateConfig(const SimulationConfig& config);
-};
-
+#ifndef COMMAND_LINE_H
+#define COMMAND_LINE_H
+
+#include <string>
+#include <cstdint>
+
+// Structure to hold simulation configuration parameters
+struct SimulationConfig {
+    std::string appName;  // Application name for trace files
+    int setBits;          // Number of set index bits (s)
+    int associativity;    // Associativity (E)
+    int blockBits;        // Number of block bits (b)
+    std::string outputFile; // Output file for logging
+    bool helpRequested;   // Whether help was requested
+    bool eventDriven;     // Skip cycles in which no core can make progress
+    int stackDistanceWays; // >0: LRU stack-distance analysis up to this associativity instead of simulating
+    bool functionalOnly;  // Per-core miss counts from FunctionalCacheModel instead of simulating
+    bool tagOnly;         // Track tags/states only; lines and memory hold no data
+    bool snoopFilter;     // Snoop only the caches a sharer directory lists for the block
+    int numCores;         // Cores (one trace, cache and processor each)
+    int threads;          // >0: advance cores on this many threads in bounded-lag quanta
+    unsigned int quantum; // Parallel mode: max cycles a core may run ahead of the slowest
+    bool prefetchTraces;  // Decode text traces on a background thread
+    std::string statsFile;   // Per-interval statistics stream (empty = none)
+    std::string statsFormat; // "binary" (columnar chunks) or "csv"
+    unsigned int logInterval; // Cycles between log/statistics samples
+    std::string replacement; // Victim selection policy (see ReplacementPolicy.h)
+    std::string prefetcher;  // L1 prefetcher: "none", "next-line", "stride" or "stream"
+    unsigned int prefetchDegree; // Blocks each prefetcher trigger fetches ahead
+    unsigned int mshrs;      // Outstanding misses per cache (1 = blocking cache)
+    std::string bus;         // Bus timing: "atomic" (one transaction at a time) or "split"
+    unsigned int memoryBanks; // Split bus: independently busy memory banks
+    unsigned int writebackBuffer; // Write-back buffer entries per cache (0 = writebacks stall misses)
+    std::string protocol;    // Coherence protocol: "mesi", "moesi" or "mesif" (empty = MESI, no protocol report)
+    int l2SetBits;        // Shared L2 set index bits (0 = no L2)
+    int l2Associativity;  // Shared L2 associativity
+    int l2BlockBits;      // Shared L2 block bits (0 = same as the L1s)
+    unsigned int l2Latency; // Shared L2 hit latency in cycles
+    bool l2Inclusive;     // Back-invalidate L1 copies of evicted L2 blocks
+    std::string missProfileFile; // JSON miss-classification report (empty = none; needs INSTRUMENT=1)
+    unsigned int sharingTop; // Rank this many hottest shared blocks (0 = none; needs INSTRUMENT=1)
+    std::string checkpointFile; // Save the whole simulator state here (empty = none)
+    uint64_t checkpointAt;   // ... once the cores have executed this many instructions in total
+    std::string restoreFile; // Resume from a checkpoint of the same configuration (empty = none)
+    uint64_t sampleInterval; // >0: sampled simulation, one measurement window per this many instructions
+    uint64_t sampleWarmup;   // Sampled: detailed instructions before each window's measurement
+    uint64_t sampleSize;     // Sampled: instructions measured per window
+    std::string schedule;    // Time-slice these programs' traces over the cores, "app[:k],..." (empty = -t, one trace per core)
+    unsigned int timeSlice;  // Scheduled: cycles a stream runs before a waiting one takes its core (0 = to completion)
+    bool flushOnSwitch;      // Scheduled: invalidate a core's L1 (writing dirty lines back) on each switch
+    
+    // Constructor with default values
+    SimulationConfig() 
+        : appName(""), setBits(0), associativity(0), blockBits(0), 
+          outputFile(""), helpRequested(false), eventDriven(false),
+          stackDistanceWays(0), functionalOnly(false), tagOnly(false), snoopFilter(false), numCores(4),
+          threads(0), quantum(100), prefetchTraces(false),
+          statsFile(""), statsFormat("binary"), logInterval(1000),
+          replacement("lru"), prefetcher("none"), prefetchDegree(2),
+          mshrs(1), bus("atomic"), memoryBanks(8),
+          writebackBuffer(0), protocol(""), l2SetBits(0), l2Associativity(8), l2BlockBits(0),
+          l2Latency(20), l2Inclusive(true), missProfileFile(""), sharingTop(0),
+          checkpointFile(""), checkpointAt(0), restoreFile(""),
+          sampleInterval(0), sampleWarmup(2000), sampleSize(1000),
+          schedule(""), timeSlice(0), flushOnSwitch(false) {}
+};
+
+class CommandLine {
+public:
+    // Parse command line arguments and return configuration
+    static SimulationConfig parseArguments(int argc, char* argv[]);
+    
+    // Print help message
+    static void printHelp(const char* programName);
+    
+    // Validate configuration
+    static bool validateConfig(const SimulationConfig& config);
+};
+
 #endif // COMMAND_LINE_H
\ No newline at end of file
@@ -0,0 +1,226 @@
+#include "CompressedStream.h"
+#include <iostream>
+
+#ifdef L1SIM_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef L1SIM_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+// Decompressed bytes produced per refill of the stream buffer
+static const size_t DECODE_BLOCK = 1 << 20;
+
+// zlib's own read-ahead of compressed bytes
+static const unsigned int GZIP_BUFFER = 256 * 1024;
+
+// Check if a string ends with a suffix
+static bool endsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() &&
+           text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Constructor
+CompressedStreamBuf::CompressedStreamBuf()
+    : codec(Codec::NONE), gzipFile(nullptr), zstdStream(nullptr), zstdFile(nullptr),
+      zstdInputPos(0), zstdInputSize(0) {
+}
+
+// Destructor
+CompressedStreamBuf::~CompressedStreamBuf() {
+    close();
+}
+
+// Open a compressed file
+bool CompressedStreamBuf::open(const std::string& filePath, Codec fileCodec) {
+    close();
+    codec = fileCodec;
+    path = filePath;
+
+    switch (codec) {
+      case Codec::GZIP:
+#ifdef L1SIM_HAVE_ZLIB
+        gzipFile = gzopen(path.c_str(), "rb");
+        if (!gzipFile) return false;
+        gzbuffer(static_cast<gzFile>(gzipFile), GZIP_BUFFER);
+        break;
+#else
+        return false;
+#endif
+
+      case Codec::ZSTD:
+#ifdef L1SIM_HAVE_ZSTD
+        zstdFile = std::fopen(path.c_str(), "rb");
+        if (!zstdFile) return false;
+        zstdStream = ZSTD_createDStream();
+        ZSTD_initDStream(static_cast<ZSTD_DStream*>(zstdStream));
+        zstdInput.resize(ZSTD_DStreamInSize());
+        zstdInputPos = 0;
+        zstdInputSize = 0;
+        break;
+#else
+        return false;
+#endif
+
+      case Codec::NONE:
+        return false;
+    }
+
+    buffer.resize(DECODE_BLOCK);
+    setg(buffer.data(), buffer.data(), buffer.data()); // Empty until the first underflow
+    return true;
+}
+
+// Close the file and release the decoder
+void CompressedStreamBuf::close() {
+#ifdef L1SIM_HAVE_ZLIB
+    if (gzipFile) {
+        gzclose(static_cast<gzFile>(gzipFile));
+    }
+#endif
+#ifdef L1SIM_HAVE_ZSTD
+    if (zstdStream) {
+        ZSTD_freeDStream(static_cast<ZSTD_DStream*>(zstdStream));
+    }
+#endif
+    if (zstdFile) {
+        std::fclose(zstdFile);
+    }
+    gzipFile = nullptr;
+    zstdStream = nullptr;
+    zstdFile = nullptr;
+    setg(nullptr, nullptr, nullptr);
+}
+
+// Check if a file is open
+bool CompressedStreamBuf::isOpen() const {
+    return gzipFile != nullptr || zstdStream != nullptr;
+}
+
+// Restart decoding from the beginning of the file
+bool CompressedStreamBuf::rewind() {
+    if (!isOpen()) return false;
+#ifdef L1SIM_HAVE_ZLIB
+    if (gzipFile && gzrewind(static_cast<gzFile>(gzipFile)) != 0) return false;
+#endif
+#ifdef L1SIM_HAVE_ZSTD
+    if (zstdStream) {
+        if (std::fseek(zstdFile, 0, SEEK_SET) != 0) return false;
+        ZSTD_initDStream(static_cast<ZSTD_DStream*>(zstdStream));
+        zstdInputPos = 0;
+        zstdInputSize = 0;
+    }
+#endif
+    setg(buffer.data(), buffer.data(), buffer.data());
+    return true;
+}
+
+// Refill the get area with the next decompressed block
+CompressedStreamBuf::int_type CompressedStreamBuf::underflow() {
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+    size_t produced = isOpen() ? decode(buffer.data(), buffer.size()) : 0;
+    if (produced == 0) {
+        return traits_type::eof();
+    }
+    setg(buffer.data(), buffer.data(), buffer.data() + produced);
+    return traits_type::to_int_type(*gptr());
+}
+
+// Decompress up to `capacity` bytes
+size_t CompressedStreamBuf::decode(char* out, size_t capacity) {
+#ifdef L1SIM_HAVE_ZLIB
+    if (gzipFile) {
+        int produced = gzread(static_cast<gzFile>(gzipFile), out, static_cast<unsigned int>(capacity));
+        if (produced < 0) {
+            int code = 0;
+            std::cerr << "Error: Could not decompress " << path << ": "
+                      << gzerror(static_cast<gzFile>(gzipFile), &code) << std::endl;
+            return 0;
+        }
+        return static_cast<size_t>(produced);
+    }
+#endif
+#ifdef L1SIM_HAVE_ZSTD
+    if (zstdStream) {
+        ZSTD_outBuffer output = { out, capacity, 0 };
+        while (output.pos < output.size) {
+            if (zstdInputPos == zstdInputSize) {
+                zstdInputSize = std::fread(zstdInput.data(), 1, zstdInput.size(), zstdFile);
+                zstdInputPos = 0;
+                if (zstdInputSize == 0) break; // End of file
+            }
+            ZSTD_inBuffer input = { zstdInput.data(), zstdInputSize, zstdInputPos };
+            size_t result = ZSTD_decompressStream(static_cast<ZSTD_DStream*>(zstdStream), &output, &input);
+            zstdInputPos = input.pos;
+            if (ZSTD_isError(result)) {
+                std::cerr << "Error: Could not decompress " << path << ": "
+                          << ZSTD_getErrorName(result) << std::endl;
+                break;
+            }
+        }
+        return output.pos;
+    }
+#endif
+    return 0;
+}
+
+// Constructor
+CompressedStream::CompressedStream()
+    : std::istream(&buf) {
+}
+
+// Open a compressed file
+bool CompressedStream::open(const std::string& path, Codec codec) {
+    if (!buf.open(path, codec)) {
+        setstate(std::ios::failbit);
+        return false;
+    }
+    clear();
+    return true;
+}
+
+// Restart from the beginning of the file
+bool CompressedStream::rewind() {
+    if (!buf.rewind()) {
+        setstate(std::ios::failbit);
+        return false;
+    }
+    clear();
+    return true;
+}
+
+// Check if a file is open
+bool CompressedStream::isOpen() const {
+    return buf.isOpen();
+}
+
+// Codec implied by a file name's extension
+Codec CompressedStream::codecForPath(const std::string& path) {
+    if (endsWith(path, ".gz"))  return Codec::GZIP;
+    if (endsWith(path, ".zst")) return Codec::ZSTD;
+    return Codec::NONE;
+}
+
+// Check if support for a codec was compiled in
+bool CompressedStream::isCodecAvailable(Codec codec) {
+    switch (codec) {
+#ifdef L1SIM_HAVE_ZLIB
+      case Codec::GZIP: return true;
+#endif
+#ifdef L1SIM_HAVE_ZSTD
+      case Codec::ZSTD: return true;
+#endif
+      default: return false;
+    }
+}
+
+// Name of a codec for messages
+const char* CompressedStream::codecName(Codec codec) {
+    switch (codec) {
+      case Codec::GZIP: return "gzip";
+      case Codec::ZSTD: return "zstd";
+      default:          return "none";
+    }
+}
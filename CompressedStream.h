@@ -0,0 +1,86 @@
+#ifndef COMPRESSED_STREAM_H
+#define COMPRESSED_STREAM_H
+
+#include <istream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+// Compression formats a trace file may be stored in
+enum class Codec {
+    NONE,   // Not compressed
+    GZIP,   // .gz  (zlib, built with L1SIM_HAVE_ZLIB)
+    ZSTD    // .zst (libzstd, built with L1SIM_HAVE_ZSTD)
+};
+
+// Stream buffer that decompresses a file on the fly, one block at a time.
+// Nothing is ever written back to disk.
+class CompressedStreamBuf : public std::streambuf {
+public:
+    // Constructor
+    CompressedStreamBuf();
+
+    // Destructor
+    ~CompressedStreamBuf();
+
+    // Open a compressed file; returns false if it cannot be read
+    bool open(const std::string& path, Codec codec);
+
+    // Close the file and release the decoder
+    void close();
+
+    // Check if a file is open
+    bool isOpen() const;
+
+    // Restart decoding from the beginning of the file
+    bool rewind();
+
+protected:
+    // Refill the get area with the next decompressed block
+    int_type underflow() override;
+
+private:
+    // Decompress up to `capacity` bytes into `out`; returns bytes produced (0 = end)
+    size_t decode(char* out, size_t capacity);
+
+    Codec codec;
+    std::string path;
+    std::vector<char> buffer;   // Decompressed bytes handed to the stream
+    void* gzipFile;             // gzFile (zlib)
+    void* zstdStream;           // ZSTD_DStream* (libzstd)
+    FILE* zstdFile;             // Compressed input for zstd
+    std::vector<char> zstdInput;  // Compressed bytes read but not yet decoded
+    size_t zstdInputPos;
+    size_t zstdInputSize;
+};
+
+// Input stream over a compressed file
+class CompressedStream : public std::istream {
+public:
+    // Constructor
+    CompressedStream();
+
+    // Open a compressed file; returns false if it cannot be read
+    bool open(const std::string& path, Codec codec);
+
+    // Restart from the beginning of the file (clears EOF/error flags)
+    bool rewind();
+
+    // Check if a file is open
+    bool isOpen() const;
+
+    // Codec implied by a file name's extension (.gz / .zst)
+    static Codec codecForPath(const std::string& path);
+
+    // Check if support for a codec was compiled in
+    static bool isCodecAvailable(Codec codec);
+
+    // Name of a codec for messages
+    static const char* codecName(Codec codec);
+
+private:
+    CompressedStreamBuf buf;
+};
+
+#endif // COMPRESSED_STREAM_H
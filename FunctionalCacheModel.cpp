@@ -0,0 +1,168 @@
+#include "FunctionalCacheModel.h"
+
+// Add another run's counts
+FunctionalCounts& FunctionalCounts::operator+=(const FunctionalCounts& other) {
+    accesses += other.accesses;
+    reads += other.reads;
+    writes += other.writes;
+    hits += other.hits;
+    misses += other.misses;
+    evictions += other.evictions;
+    writebacks += other.writebacks;
+    return *this;
+}
+
+// Constructor
+FunctionalCacheModel::FunctionalCacheModel(int setBits, int associativity, int blockBits,
+                                           ReplacementPolicy policy)
+    : setBits(setBits), blockBits(blockBits), associativity(associativity), policy(policy) {
+    size_t numSets = size_t(1) << setBits;
+    if (policy == ReplacementPolicy::LRU || policy == ReplacementPolicy::TRUE_LRU) {
+        tags.assign(numSets * associativity, 0);
+        states.assign(numSets * associativity, WAY_INVALID);
+        stamps.assign(numSets * associativity, 0);
+        clocks.assign(numSets, 0);
+        return;
+    }
+    sets.reserve(numSets);
+    for (size_t i = 0; i < numSets; ++i) {
+        sets.emplace_back(associativity, 0, policy);   // No payload: tags and states only
+    }
+}
+
+// Process a batch back to back
+FunctionalCounts FunctionalCacheModel::run(const Instruction* instructions, size_t count) {
+    FunctionalCounts counts;
+    switch (policy) {
+      case ReplacementPolicy::LRU:      runLru<false>(instructions, count, counts); break;
+      case ReplacementPolicy::TRUE_LRU: runLru<true>(instructions, count, counts); break;
+      default:                          runSets(instructions, count, counts); break;
+    }
+    totals += counts;
+    return counts;
+}
+
+FunctionalCounts FunctionalCacheModel::run(const std::vector<Instruction>& instructions) {
+    return run(instructions.data(), instructions.size());
+}
+
+// LRU over the flat arrays, matching CacheSet: a hit stamps its way with the
+// set's next clock value, a fill keeps the way's old stamp unless StampFills
+// (TRUE_LRU), and the victim is the first invalid way, else the first way
+// with the lowest stamp. (CacheSet renumbers its 32-bit counters after 2^32
+// uses of one set; these stamps never wrap, which orders ways the same.)
+template <bool StampFills>
+void FunctionalCacheModel::runLru(const Instruction* instructions, size_t count,
+                                  FunctionalCounts& counts) {
+    const uint32_t indexMask = (1u << setBits) - 1;
+    const int tagShift = setBits + blockBits;
+    const unsigned int ways = associativity;
+
+    for (size_t i = 0; i < count; ++i) {
+        // Overlap the next access's set lookup with this one
+        if (i + 1 < count) {
+            size_t next = ((instructions[i + 1].address >> blockBits) & indexMask) * ways;
+            __builtin_prefetch(&tags[next]);
+            __builtin_prefetch(&states[next]);
+            __builtin_prefetch(&stamps[next]);
+        }
+        const Instruction& inst = instructions[i];
+        if (!inst.isValid()) continue;
+
+        bool isWrite = inst.type == Instruction::Type::WRITE;
+        counts.accesses++;
+        if (isWrite) counts.writes++;
+        else         counts.reads++;
+
+        uint32_t set = (inst.address >> blockBits) & indexMask;
+        uint32_t tag = inst.address >> tagShift;
+        size_t base = size_t(set) * ways;
+        unsigned int way = 0;
+        while (way < ways && (states[base + way] == WAY_INVALID || tags[base + way] != tag)) {
+            way++;
+        }
+        if (way < ways) {
+            counts.hits++;
+            stamps[base + way] = ++clocks[set];
+            if (isWrite) states[base + way] = WAY_DIRTY;
+            continue;
+        }
+
+        // Miss (write-allocate): first invalid way, else the least recently used
+        counts.misses++;
+        unsigned int victim = 0;
+        while (victim < ways && states[base + victim] != WAY_INVALID) {
+            victim++;
+        }
+        if (victim == ways) {
+            victim = 0;
+            for (unsigned int w = 1; w < ways; ++w) {
+                if (stamps[base + w] < stamps[base + victim]) victim = w;
+            }
+            counts.evictions++;
+            if (states[base + victim] == WAY_DIRTY) counts.writebacks++;
+        }
+        tags[base + victim] = tag;
+        states[base + victim] = isWrite ? WAY_DIRTY : WAY_CLEAN;
+        if (StampFills) stamps[base + victim] = ++clocks[set];
+    }
+}
+
+// Any policy, through CacheSet's own victim selection and replacement updates
+void FunctionalCacheModel::runSets(const Instruction* instructions, size_t count,
+                                   FunctionalCounts& counts) {
+    const uint32_t indexMask = (1u << setBits) - 1;
+    const int tagShift = setBits + blockBits;
+
+    for (size_t i = 0; i < count; ++i) {
+        if (i + 1 < count) {
+            sets[(instructions[i + 1].address >> blockBits) & indexMask].prefetchMetadata();
+        }
+        const Instruction& inst = instructions[i];
+        if (!inst.isValid()) continue;
+
+        bool isWrite = inst.type == Instruction::Type::WRITE;
+        counts.accesses++;
+        if (isWrite) counts.writes++;
+        else         counts.reads++;
+
+        CacheSet& set = sets[(inst.address >> blockBits) & indexMask];
+        uint32_t tag = inst.address >> tagShift;
+        CacheLine* line = set.findLine(tag);
+        if (line) {
+            counts.hits++;
+            set.updateLRU(line);
+            if (isWrite) line->setMESIState(MESIState::MODIFIED);
+            continue;
+        }
+
+        counts.misses++;
+        CacheLine* victim = set.findVictim();
+        if (victim->isValid()) {
+            counts.evictions++;
+            if (victim->isDirty()) counts.writebacks++;
+        }
+        victim->loadTag(tag, isWrite ? MESIState::MODIFIED : MESIState::EXCLUSIVE);
+        set.insertLine(victim);
+    }
+}
+
+// Feed every remaining instruction of one core's trace
+FunctionalCounts FunctionalCacheModel::consumeTrace(TraceReader& reader, int coreId) {
+    FunctionalCounts counts;
+    std::vector<Instruction> batch;
+    batch.reserve(TraceBatch::CAPACITY);
+    while (reader.hasMoreInstructions(coreId)) {
+        batch.clear();
+        while (batch.size() < TraceBatch::CAPACITY && reader.hasMoreInstructions(coreId)) {
+            batch.push_back(reader.getNextInstruction(coreId));
+        }
+        counts += run(batch);
+    }
+    return counts;
+}
+
+// Counts of every batch so far
+const FunctionalCounts& FunctionalCacheModel::getCounts() const {
+    return totals;
+}
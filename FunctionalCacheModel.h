@@ -0,0 +1,83 @@
+#ifndef FUNCTIONAL_CACHE_MODEL_H
+#define FUNCTIONAL_CACHE_MODEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "CacheSet.h"
+#include "ReplacementPolicy.h"
+#include "TraceReader.h"
+
+// Aggregate counts of a functional cache run
+struct FunctionalCounts {
+    uint64_t accesses = 0;
+    uint64_t reads = 0;
+    uint64_t writes = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t writebacks = 0;   // Dirty evictions
+
+    double missRate() const {
+        return accesses ? double(misses) / accesses : 0.0;
+    }
+    FunctionalCounts& operator+=(const FunctionalCounts& other);
+};
+
+// One private cache driven straight from decoded instructions, for miss-rate
+// studies where timing does not matter.
+//
+// It makes the same replacement decisions as Cache (write-allocate, a write
+// makes its line dirty, the same victim choice for every policy), but there
+// is no Processor, cycle loop, bus or Address object: a batch is decoded
+// with shifts and processed back to back, and while one access runs the
+// metadata of the next access's set is prefetched. Lines hold tags and
+// states only. Without peers to invalidate its lines, its counts equal a
+// single-core (-n 1) run of the timing simulator.
+//
+// The LRU policies run on flat per-way arrays of every set (tag, state,
+// last-use stamp); the others go through CacheSet, which keeps their
+// replacement state.
+class FunctionalCacheModel {
+public:
+    // Constructor - 2^setBits sets of `associativity` ways, 2^blockBits-byte blocks
+    FunctionalCacheModel(int setBits, int associativity, int blockBits,
+                         ReplacementPolicy policy = ReplacementPolicy::LRU);
+
+    // Process `count` instructions back to back (invalid ones are skipped);
+    // returns the counts of this batch
+    FunctionalCounts run(const Instruction* instructions, size_t count);
+    FunctionalCounts run(const std::vector<Instruction>& instructions);
+
+    // Feed every remaining instruction of one core's trace, a batch at a time
+    FunctionalCounts consumeTrace(TraceReader& reader, int coreId);
+
+    // Counts of every batch so far
+    const FunctionalCounts& getCounts() const;
+
+private:
+    // Batch loops: flat arrays (LRU, TRUE_LRU) or CacheSet (other policies)
+    template <bool StampFills>
+    void runLru(const Instruction* instructions, size_t count, FunctionalCounts& counts);
+    void runSets(const Instruction* instructions, size_t count, FunctionalCounts& counts);
+
+    // Way states in the flat arrays
+    enum : uint8_t { WAY_INVALID, WAY_CLEAN, WAY_DIRTY };
+
+    int setBits;
+    int blockBits;
+    unsigned int associativity;
+    ReplacementPolicy policy;
+    FunctionalCounts totals;
+
+    // LRU policies: way w of set s at s * associativity + w
+    std::vector<uint32_t> tags;
+    std::vector<uint8_t> states;
+    std::vector<uint64_t> stamps;   // Set clock at the way's last use (fills too under TRUE_LRU)
+    std::vector<uint64_t> clocks;   // Per set: uses so far
+
+    // Other policies
+    std::vector<CacheSet> sets;
+};
+
+#endif // FUNCTIONAL_CACHE_MODEL_H
@@ -0,0 +1,152 @@
+#include "L2Cache.h"
+#include "Checkpoint.h"
+#include "Cache.h"
+
+// Constructor
+L2Cache::L2Cache(int setBits, int associativity, int blockBits, unsigned int latency,
+                 bool inclusive, ReplacementPolicy policy)
+    : setBits(setBits), blockBits(blockBits), associativity(associativity),
+      latency(latency), inclusive(inclusive), upperCaches(nullptr),
+      upperBlockBits(blockBits) {
+    // Tag-only lines: no payload (see the class comment)
+    sets.reserve(1 << setBits);
+    for (int i = 0; i < (1 << setBits); ++i) {
+        sets.emplace_back(associativity, 0, policy);
+    }
+}
+
+// The L1s above and their block size
+void L2Cache::setUpperCaches(const std::vector<Cache*>* caches, int bits) {
+    upperCaches = caches;
+    upperBlockBits = bits;
+}
+
+// Look a block up; on a miss, evict a victim and allocate the block
+CacheLine* L2Cache::lookup(uint32_t blockAddr, bool& hit) {
+    Address addr(blockAddr, setBits, blockBits);
+    CacheSet& set = sets[addr.getIndex()];
+    CacheLine* line = set.findLine(addr.getTag());
+    hit = line != nullptr;
+    if (hit) {
+        set.updateLRU(line);
+        return line;
+    }
+
+    CacheLine* victim = set.findVictim();
+    if (victim->isValid()) {
+        stats.evictions++;
+        if (victim->isDirty()) {
+            stats.writebacks++;
+        }
+        if (inclusive && upperCaches) {
+            // Every L1 block inside the evicted L2 block loses its copy
+            uint32_t victimAddr = (victim->getTag() << (setBits + blockBits))
+                                | (addr.getIndex() << blockBits);
+            for (uint32_t sub = 0; sub < (1u << (blockBits - upperBlockBits)); ++sub) {
+                uint32_t l1Block = victimAddr + (sub << upperBlockBits);
+                for (Cache* cache : *upperCaches) {
+                    if (cache->backInvalidate(l1Block)) {
+                        stats.backInvalidations++;
+                    }
+                }
+            }
+        }
+    }
+    victim->loadTag(addr.getTag(), MESIState::EXCLUSIVE);
+    set.insertLine(victim);
+    return victim;
+}
+
+// L1 fill from below the bus
+unsigned int L2Cache::read(uint32_t blockAddr, bool& hit) {
+    stats.accesses++;
+    lookup(blockAddr, hit);
+    if (hit) {
+        stats.hits++;
+        return latency;
+    }
+    stats.misses++;
+    return latency + MEMORY_LATENCY;
+}
+
+// L1 writeback of a dirty block
+unsigned int L2Cache::write(uint32_t blockAddr) {
+    stats.accesses++;
+    bool hit = false;
+    CacheLine* line = lookup(blockAddr, hit);
+    if (hit) {
+        stats.hits++;
+    } else {
+        stats.misses++;   // Write-allocate: the block is not read from memory first
+    }
+    line->setMESIState(MESIState::MODIFIED);
+    return latency;
+}
+
+// Make sure a block an L1 received from a peer is present
+void L2Cache::insert(uint32_t blockAddr) {
+    bool hit = false;
+    lookup(blockAddr, hit);
+}
+
+// Check if the L2 holds a block
+bool L2Cache::contains(uint32_t blockAddr) const {
+    Address addr(blockAddr, setBits, blockBits);
+    return sets[addr.getIndex()].findLine(addr.getTag()) != nullptr;
+}
+
+// Note a bus transaction that needed no snoop
+void L2Cache::noteFilteredSnoop() {
+    stats.filteredSnoops++;
+}
+
+// Check if L1 contents are kept a subset of the L2
+bool L2Cache::isInclusive() const {
+    return inclusive;
+}
+
+// Get the hit latency
+unsigned int L2Cache::getLatency() const {
+    return latency;
+}
+
+// Get the number of block bits
+int L2Cache::getBlockBits() const {
+    return blockBits;
+}
+
+// Get the number of sets
+int L2Cache::getNumSets() const {
+    return 1 << setBits;
+}
+
+// Get the associativity
+int L2Cache::getAssociativity() const {
+    return associativity;
+}
+
+// Get the statistics
+const L2Stats& L2Cache::getStats() const {
+    return stats;
+}
+
+// Checkpoint the sets and statistics
+void L2Cache::saveState(CheckpointWriter& out) const {
+    out.put<uint64_t>(sets.size());
+    for (const auto& set : sets) {
+        set.saveState(out);
+    }
+    out.put(stats);
+}
+
+// Restore the sets and statistics
+void L2Cache::loadState(CheckpointReader& in) {
+    if (in.get<uint64_t>() != sets.size()) {
+        in.fail();
+        return;
+    }
+    for (auto& set : sets) {
+        set.loadState(in);
+    }
+    stats = in.get<L2Stats>();
+}
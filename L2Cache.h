@@ -0,0 +1,85 @@
+#ifndef L2_CACHE_H
+#define L2_CACHE_H
+
+#include <cstdint>
+#include <vector>
+#include "CacheSet.h"
+#include "Address.h"
+#include "Statistics.h"
+#include "ReplacementPolicy.h"
+
+class Cache;
+class CheckpointWriter;
+class CheckpointReader;
+
+// Shared second-level cache behind the private L1s.
+//
+// Built from the same CacheSet/CacheLine blocks as an L1, with its own sets,
+// associativity and block size (at least the L1 block size). Lines carry
+// tags and a clean/dirty state only: block data stays in MainMemory, which
+// every level already writes through functionally, so the L2 decides timing
+// and presence, not contents.
+//
+//   L1 fill no peer supplied : L2 hit costs `latency`, a miss `latency` + 100
+//                              (memory) and allocates the block
+//   L1 dirty writeback       : marks the L2 block dirty (allocating it if
+//                              absent) and costs `latency`
+//   L2 eviction              : a dirty block is written to memory; when
+//                              inclusive, every L1 copy of it is back-invalidated
+//
+// An inclusive L2 doubles as a snoop filter: a block it misses on is in no
+// L1, so the bus transaction for it is not snooped at all.
+class L2Cache {
+public:
+    // Latency of the memory behind the L2
+    static const unsigned int MEMORY_LATENCY = 100;
+
+    // Constructor
+    L2Cache(int setBits, int associativity, int blockBits, unsigned int latency,
+            bool inclusive, ReplacementPolicy policy = ReplacementPolicy::LRU);
+
+    // The L1s above (indexed by core id) and their block size, for back-invalidation
+    void setUpperCaches(const std::vector<Cache*>* caches, int upperBlockBits);
+
+    // L1 fill from below the bus; returns its latency and whether the L2 hit
+    unsigned int read(uint32_t blockAddr, bool& hit);
+
+    // L1 writeback of a dirty block; returns its latency
+    unsigned int write(uint32_t blockAddr);
+
+    // Make sure a block an L1 received from a peer is present (inclusion); no latency
+    void insert(uint32_t blockAddr);
+
+    // Check if the L2 holds a block
+    bool contains(uint32_t blockAddr) const;
+
+    // Note a bus transaction that needed no snoop because the block is in no L1
+    void noteFilteredSnoop();
+
+    bool isInclusive() const;
+    unsigned int getLatency() const;
+    int getBlockBits() const;
+    int getNumSets() const;
+    int getAssociativity() const;
+    const L2Stats& getStats() const;
+
+    // Checkpoint the sets and statistics (same geometry on load)
+    void saveState(CheckpointWriter& out) const;
+    void loadState(CheckpointReader& in);
+
+private:
+    // Look a block up; on a miss, evict a victim and allocate the block
+    CacheLine* lookup(uint32_t blockAddr, bool& hit);
+
+    std::vector<CacheSet> sets;
+    int setBits;
+    int blockBits;
+    int associativity;
+    unsigned int latency;
+    bool inclusive;
+    const std::vector<Cache*>* upperCaches;
+    int upperBlockBits;
+    L2Stats stats;
+};
+
+#endif // L2_CACHE_H
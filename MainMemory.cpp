@@ -1,61 +1,170 @@
-#include "MainMemory.h"
-#include <iostream>
-
-// Constructor
-MainMemory::MainMemory(unsigned int blockSize) 
-    : blockSize(blockSize), readCount(0), writeCount(0) {
-}
-
-// Read a block from memory
-std::vector<uint8_t> MainMemory::readBlock(uint32_t blockAddress) {
-    // Increment statistics
-    readCount++;
-    
-    // Check if this block exists in our sparse memory
-    auto it = memory.find(blockAddress);
-    
-    if (it != memory.end()) {
-        // Return existing block
-        return it->second;
-    } else {
-        // If block doesn't exist, create a new block filled with zeros
-        std::vector<uint8_t> newBlock(blockSize, 0);
-        
-        // Store it in memory (optional - could just return zeros without storing)
-        memory[blockAddress] = newBlock;
-        
-        return newBlock;
-    }
-}
-
-// Write a block to memory
-void MainMemory::writeBlock(uint32_t blockAddress, const std::vector<uint8_t>& data) {
-    // Increment statistics
-    writeCount++;
-    
-    // Validate data size
-    if (data.size() != blockSize) {
-        std::cerr << "Error: Attempt to write incorrect block size to memory." << std::endl;
-        std::cerr << "Expected: " << blockSize << " bytes, Got: " << data.size() << " bytes" << std::endl;
-        return;
-    }
-    
-    // Store block in memory
-    memory[blockAddress] = data;
-}
-
-// Get read count
-unsigned int MainMemory::getReadCount() const {
-    return readCount;
-}
-
-// Get write count
-unsigned int MainMemory::getWriteCount() const {
-    return writeCount;
-}
-
-// Reset statistics
-void MainMemory::resetStats() {
-    readCount = 0;
-    writeCount = 0;
-}
\ No newline at end of file
+#include "MainMemory.h"
+#include "Checkpoint.h"
+#include <cstring>
+#include <iostream>
+
+const uint32_t MainMemory::SLAB_BLOCKS;
+const uint32_t MainMemory::EMPTY;
+
+// Constructor
+MainMemory::MainMemory(unsigned int blockSize, bool storeData) 
+    : tableKeys(1024, 0), tableSlots(1024, EMPTY), tableBits(10), storedBlocks(0),
+      zeroBlock(blockSize, 0), blockSize(blockSize), storeData(storeData),
+      readCount(0), writeCount(0) {
+}
+
+// Table position of a block address (its entry, or the free slot it would take)
+uint32_t MainMemory::probe(uint32_t blockAddress) const {
+    // Fibonacci hash: the top bits of the product mix in every address bit,
+    // so the always-zero block offset bits do not cluster the entries
+    uint32_t mask = (1u << tableBits) - 1;
+    uint32_t pos = (blockAddress * 2654435769u) >> (32 - tableBits);
+    while (tableSlots[pos] != EMPTY && tableKeys[pos] != blockAddress) {
+        pos = (pos + 1) & mask;
+    }
+    return pos;
+}
+
+// Payload of a slot
+uint8_t* MainMemory::slotData(uint32_t slot) const {
+    return slabs[slot / SLAB_BLOCKS].get() + size_t(slot % SLAB_BLOCKS) * blockSize;
+}
+
+// Payload of a block, allocating a slot on first use
+uint8_t* MainMemory::allocateBlock(uint32_t blockAddress) {
+    uint32_t pos = probe(blockAddress);
+    if (tableSlots[pos] != EMPTY) {
+        return slotData(tableSlots[pos]);
+    }
+
+    // Keep the table at most half full so probe sequences stay short
+    if ((storedBlocks + 1) * 2 > tableSlots.size()) {
+        growTable();
+        pos = probe(blockAddress);
+    }
+
+    uint32_t slot = storedBlocks++;
+    if (slot / SLAB_BLOCKS >= slabs.size()) {
+        slabs.emplace_back(new uint8_t[size_t(SLAB_BLOCKS) * blockSize]);
+    }
+    tableKeys[pos] = blockAddress;
+    tableSlots[pos] = slot;
+    return slotData(slot);
+}
+
+// Double the table and re-insert every entry (payloads stay put)
+void MainMemory::growTable() {
+    std::vector<uint32_t> oldKeys;
+    std::vector<uint32_t> oldSlots;
+    oldKeys.swap(tableKeys);
+    oldSlots.swap(tableSlots);
+
+    tableBits++;
+    tableKeys.assign(size_t(1) << tableBits, 0);
+    tableSlots.assign(size_t(1) << tableBits, EMPTY);
+    for (size_t i = 0; i < oldSlots.size(); i++) {
+        if (oldSlots[i] != EMPTY) {
+            uint32_t pos = probe(oldKeys[i]);
+            tableKeys[pos] = oldKeys[i];
+            tableSlots[pos] = oldSlots[i];
+        }
+    }
+}
+
+// Read a block from memory
+const uint8_t* MainMemory::readBlock(uint32_t blockAddress) {
+    // Increment statistics
+    readCount++;
+    
+    // Tag-only mode: nothing to return
+    if (!storeData) {
+        return nullptr;
+    }
+    
+    // A block that was never written reads as zeros without being stored
+    uint32_t pos = probe(blockAddress);
+    if (tableSlots[pos] == EMPTY) {
+        return zeroBlock.data();
+    }
+    return slotData(tableSlots[pos]);
+}
+
+// Write a block to memory
+void MainMemory::writeBlock(uint32_t blockAddress, const std::vector<uint8_t>& data) {
+    // Increment statistics
+    writeCount++;
+    
+    // Tag-only mode: writebacks only count
+    if (!storeData) {
+        return;
+    }
+    
+    // Validate data size
+    if (data.size() != blockSize) {
+        std::cerr << "Error: Attempt to write incorrect block size to memory." << std::endl;
+        std::cerr << "Expected: " << blockSize << " bytes, Got: " << data.size() << " bytes" << std::endl;
+        return;
+    }
+    
+    // Store block in memory
+    std::memcpy(allocateBlock(blockAddress), data.data(), blockSize);
+}
+
+// Check whether block payloads are kept
+bool MainMemory::storesData() const {
+    return storeData;
+}
+
+// Number of blocks holding written data
+size_t MainMemory::getStoredBlockCount() const {
+    return storedBlocks;
+}
+
+// Get read count
+unsigned int MainMemory::getReadCount() const {
+    return readCount;
+}
+
+// Get write count
+unsigned int MainMemory::getWriteCount() const {
+    return writeCount;
+}
+
+// Reset statistics
+void MainMemory::resetStats() {
+    readCount = 0;
+    writeCount = 0;
+}
+
+// Checkpoint the stored blocks and counters
+void MainMemory::saveState(CheckpointWriter& out) const {
+    out.put<uint64_t>(storedBlocks);
+    for (size_t pos = 0; pos < tableSlots.size(); pos++) {
+        if (tableSlots[pos] != EMPTY) {
+            out.put(tableKeys[pos]);
+            out.putArray(slotData(tableSlots[pos]), blockSize);
+        }
+    }
+    out.put(readCount);
+    out.put(writeCount);
+}
+
+// Restore the stored blocks and counters
+void MainMemory::loadState(CheckpointReader& in) {
+    tableKeys.assign(1024, 0);
+    tableSlots.assign(1024, EMPTY);
+    tableBits = 10;
+    storedBlocks = 0;
+    slabs.clear();
+
+    uint64_t blocks = in.get<uint64_t>();
+    for (uint64_t i = 0; i < blocks && !in.failed(); i++) {
+        uint32_t blockAddress = in.get<uint32_t>();
+        std::vector<uint8_t> data = in.getVector<uint8_t>(blockSize);
+        if (!in.failed()) {
+            std::memcpy(allocateBlock(blockAddress), data.data(), blockSize);
+        }
+    }
+    readCount = in.get<unsigned int>();
+    writeCount = in.get<unsigned int>();
+}
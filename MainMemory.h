@@ -1,43 +1,96 @@
-#ifndef MAIN_MEMORY_H
-#define MAIN_MEMORY_H
-
-#include <cstdint>
-#include <unordered_map>
-#include <vector>
-#include "Address.h"
-
-class MainMemory {
-private:
-    // Using a sparse representation of memory (only store blocks that are accessed)
-    std::unordered_map<uint32_t, std::vector<uint8_t>> memory;
-    
-    // Block size in bytes
-    unsigned int blockSize;
-    
-    // Statistics
-    unsigned int readCount;
-    unsigned int writeCount;
-
-public:
-    // Constructor
-    MainMemory(unsigned int blockSize);
-    
-    // Read a block from memory
-    // blockAddress should be aligned to block boundaries
-    std::vector<uint8_t> readBlock(uint32_t blockAddress);
-    
-    // Write a block to memory
-    // blockAddress should be aligned to block boundaries
-    void writeBlock(uint32_t blockAddress, const std::vector<uint8_t>& data);
-    
-    // Get read count
-    unsigned int getReadCount() const;
-    
-    // Get write count
-    unsigned int getWriteCount() const;
-    
-    // Reset statistics
-    void resetStats();
-};
-
-#endif // MAIN_MEMORY_H
\ No newline at end of file
+#ifndef MAIN_MEMORY_H
+#define MAIN_MEMORY_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Address.h"
+
+class CheckpointWriter;
+class CheckpointReader;
+
+// Sparse block store for the 32-bit address space.
+//
+// Only blocks that were ever written are stored. Their payloads live in
+// slabs of SLAB_BLOCKS blocks that are allocated whole and never move, and
+// an open-addressing table (linear probing, kept at most half full) maps a
+// block address to its slot. A block that was never written reads as a
+// shared zero block and takes no storage, so a cold miss allocates nothing
+// and reads return a view into the store instead of a copy.
+class MainMemory {
+private:
+    // Blocks per slab
+    static const uint32_t SLAB_BLOCKS = 1024;
+    // Table slot holding no block
+    static const uint32_t EMPTY = 0xFFFFFFFF;
+
+    // Open-addressing table: block address and slot of each entry (EMPTY = free)
+    std::vector<uint32_t> tableKeys;
+    std::vector<uint32_t> tableSlots;
+    unsigned int tableBits;    // log2 of the table size
+    uint32_t storedBlocks;     // Slots handed out so far
+
+    // Block payloads, SLAB_BLOCKS slots per slab
+    std::vector<std::unique_ptr<uint8_t[]>> slabs;
+
+    // What a block that was never written reads as
+    std::vector<uint8_t> zeroBlock;
+
+    // Block size in bytes
+    unsigned int blockSize;
+
+    // False in tag-only mode: blocks are counted but never stored
+    bool storeData;
+
+    // Statistics
+    unsigned int readCount;
+    unsigned int writeCount;
+
+    // Table position of a block address (its entry, or the free slot it would take)
+    uint32_t probe(uint32_t blockAddress) const;
+
+    // Payload of a slot
+    uint8_t* slotData(uint32_t slot) const;
+
+    // Payload of a block, allocating a slot on first use
+    uint8_t* allocateBlock(uint32_t blockAddress);
+
+    // Double the table and re-insert every entry (payloads stay put)
+    void growTable();
+
+public:
+    // Constructor
+    MainMemory(unsigned int blockSize, bool storeData = true);
+
+    // Read a block from memory
+    // blockAddress should be aligned to block boundaries
+    // (returns a view of blockSize bytes, valid until the block is next
+    // written; nullptr when data is not stored)
+    const uint8_t* readBlock(uint32_t blockAddress);
+
+    // Write a block to memory
+    // blockAddress should be aligned to block boundaries
+    // (only counted when data is not stored)
+    void writeBlock(uint32_t blockAddress, const std::vector<uint8_t>& data);
+
+    // Check whether block payloads are kept
+    bool storesData() const;
+
+    // Number of blocks holding written data
+    size_t getStoredBlockCount() const;
+
+    // Get read count
+    unsigned int getReadCount() const;
+
+    // Get write count
+    unsigned int getWriteCount() const;
+
+    // Reset statistics
+    void resetStats();
+
+    // Checkpoint the stored blocks and counters
+    void saveState(CheckpointWriter& out) const;
+    void loadState(CheckpointReader& in);
+};
+
+#endif // MAIN_MEMORY_H
@@ -0,0 +1,136 @@
+#include "MissProfiler.h"
+
+// Constructor
+MissProfiler::MissProfiler(int numSets, int associativity)
+    : shadowCapacity(static_cast<size_t>(numSets) * associativity),
+      setAccesses(numSets, 0), setMisses(numSets, 0), setEvictions(numSets, 0),
+      missCounts{0, 0, 0, 0, 0}, merges(0) {
+}
+
+// Move a block to the front of the shadow store; true if it was there
+bool MissProfiler::touchShadow(uint32_t blockAddr) {
+    auto it = shadowIndex.find(blockAddr);
+    if (it != shadowIndex.end()) {
+        shadowOrder.splice(shadowOrder.begin(), shadowOrder, it->second);
+        return true;
+    }
+    if (shadowOrder.size() == shadowCapacity) {
+        shadowIndex.erase(shadowOrder.back());
+        shadowOrder.pop_back();
+    }
+    shadowOrder.push_front(blockAddr);
+    shadowIndex[blockAddr] = shadowOrder.begin();
+    return false;
+}
+
+// Demand access that hit
+void MissProfiler::recordHit(uint32_t setIndex, uint32_t blockAddr) {
+    setAccesses[setIndex]++;
+    touchShadow(blockAddr);
+    if (!invalidated.empty()) {
+        invalidated.erase(blockAddr);  // Back through a prefetch since it was lost
+    }
+}
+
+// Demand access merged into an in-flight fill of the block
+void MissProfiler::recordMerge(uint32_t setIndex, uint32_t blockAddr) {
+    setAccesses[setIndex]++;
+    setMisses[setIndex]++;
+    merges++;
+    touchShadow(blockAddr);
+}
+
+// Demand access that started a fill
+MissProfiler::MissKind MissProfiler::recordMiss(uint32_t setIndex, uint32_t blockAddr) {
+    setAccesses[setIndex]++;
+    setMisses[setIndex]++;
+    bool inShadow = touchShadow(blockAddr);
+
+    MissKind kind;
+    auto lost = invalidated.find(blockAddr);
+    if (lost != invalidated.end()) {
+        kind = lost->second ? MissKind::COHERENCE_UPGR : MissKind::COHERENCE_RDX;
+        invalidated.erase(lost);
+    } else if (seen.insert(blockAddr).second) {
+        kind = MissKind::COMPULSORY;
+    } else {
+        kind = inShadow ? MissKind::CONFLICT : MissKind::CAPACITY;
+    }
+    missCounts[static_cast<int>(kind)]++;
+    return kind;
+}
+
+// Valid line replaced in a set
+void MissProfiler::recordEviction(uint32_t setIndex) {
+    setEvictions[setIndex]++;
+}
+
+// Held block invalidated by a peer
+void MissProfiler::recordInvalidation(uint32_t blockAddr, bool byUpgrade) {
+    invalidated[blockAddr] = byUpgrade;
+}
+
+// Classified misses of one kind
+uint64_t MissProfiler::getMissCount(MissKind kind) const {
+    return missCounts[static_cast<int>(kind)];
+}
+
+// Misses merged into an in-flight fill
+uint64_t MissProfiler::getMergeCount() const {
+    return merges;
+}
+
+// Per-set accesses
+const std::vector<uint64_t>& MissProfiler::getSetAccesses() const {
+    return setAccesses;
+}
+
+// Per-set misses (merged ones included)
+const std::vector<uint64_t>& MissProfiler::getSetMisses() const {
+    return setMisses;
+}
+
+// Per-set evictions
+const std::vector<uint64_t>& MissProfiler::getSetEvictions() const {
+    return setEvictions;
+}
+
+// Write one histogram as a JSON array
+static void writeArray(std::ostream& out, const std::vector<uint64_t>& values) {
+    out << "[";
+    for (size_t i = 0; i < values.size(); i++) {
+        out << (i ? ", " : "") << values[i];
+    }
+    out << "]";
+}
+
+// This cache's entry of the JSON report
+void MissProfiler::writeJson(std::ostream& out, int coreId, const std::string& indent) const {
+    uint64_t accesses = 0;
+    for (uint64_t count : setAccesses) accesses += count;
+    uint64_t fills = 0;
+    for (uint64_t count : missCounts) fills += count;
+
+    out << indent << "{\n"
+        << indent << "  \"core\": " << coreId << ",\n"
+        << indent << "  \"accesses\": " << accesses << ",\n"
+        << indent << "  \"hits\": " << accesses - fills - merges << ",\n"
+        << indent << "  \"misses\": {\n"
+        << indent << "    \"total\": " << fills + merges << ",\n"
+        << indent << "    \"compulsory\": " << getMissCount(MissKind::COMPULSORY) << ",\n"
+        << indent << "    \"capacity\": " << getMissCount(MissKind::CAPACITY) << ",\n"
+        << indent << "    \"conflict\": " << getMissCount(MissKind::CONFLICT) << ",\n"
+        << indent << "    \"coherence_bus_rdx\": " << getMissCount(MissKind::COHERENCE_RDX) << ",\n"
+        << indent << "    \"coherence_bus_upgr\": " << getMissCount(MissKind::COHERENCE_UPGR) << ",\n"
+        << indent << "    \"mshr_merges\": " << merges << "\n"
+        << indent << "  },\n"
+        << indent << "  \"sets\": {\n"
+        << indent << "    \"accesses\": ";
+    writeArray(out, setAccesses);
+    out << ",\n" << indent << "    \"misses\": ";
+    writeArray(out, setMisses);
+    out << ",\n" << indent << "    \"evictions\": ";
+    writeArray(out, setEvictions);
+    out << "\n" << indent << "  }\n"
+        << indent << "}";
+}
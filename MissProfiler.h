@@ -0,0 +1,77 @@
+#ifndef MISS_PROFILER_H
+#define MISS_PROFILER_H
+
+#include <cstdint>
+#include <vector>
+#include <list>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+// Why one cache misses: per-set histograms and a 4C classification.
+//
+// Only built into the access path with `make INSTRUMENT=1` (L1SIM_INSTRUMENT);
+// a cache then feeds its profiler, when --miss-profile attached one, with
+// every demand access, eviction and snooped invalidation.
+//
+// Each miss that starts a fill is classified, in this order:
+//   coherence  : the block was last lost to a peer's BusRdX (or invalidate)
+//                or BusUpgr while it was held here
+//   compulsory : the block was never accessed by this cache before
+//   conflict   : a fully-associative LRU cache of the same capacity (the
+//                shadow tag store) would still hold it
+//   capacity   : everything else
+// Misses merged into an MSHR already fetching the block are counted apart.
+class MissProfiler {
+public:
+    enum class MissKind { COMPULSORY, CAPACITY, CONFLICT, COHERENCE_RDX, COHERENCE_UPGR };
+
+    // Constructor - geometry of the profiled cache
+    MissProfiler(int numSets, int associativity);
+
+    // Demand access that hit
+    void recordHit(uint32_t setIndex, uint32_t blockAddr);
+
+    // Demand access merged into an in-flight fill of the block
+    void recordMerge(uint32_t setIndex, uint32_t blockAddr);
+
+    // Demand access that started a fill; returns its classification
+    MissKind recordMiss(uint32_t setIndex, uint32_t blockAddr);
+
+    // Valid line replaced in a set
+    void recordEviction(uint32_t setIndex);
+
+    // Held block invalidated by a peer (byUpgrade: BusUpgr, else BusRdX/invalidate)
+    void recordInvalidation(uint32_t blockAddr, bool byUpgrade);
+
+    // Classified misses of one kind
+    uint64_t getMissCount(MissKind kind) const;
+    uint64_t getMergeCount() const;
+
+    // Per-set histograms
+    const std::vector<uint64_t>& getSetAccesses() const;
+    const std::vector<uint64_t>& getSetMisses() const;
+    const std::vector<uint64_t>& getSetEvictions() const;
+
+    // This cache's entry of the JSON report (one object, no trailing newline)
+    void writeJson(std::ostream& out, int coreId, const std::string& indent) const;
+
+private:
+    // Move a block to the front of the shadow store; true if it was there
+    bool touchShadow(uint32_t blockAddr);
+
+    size_t shadowCapacity;                  // numSets * associativity blocks
+    std::list<uint32_t> shadowOrder;        // Fully-associative LRU, most recent first
+    std::unordered_map<uint32_t, std::list<uint32_t>::iterator> shadowIndex;
+    std::unordered_set<uint32_t> seen;      // Blocks ever accessed
+    std::unordered_map<uint32_t, bool> invalidated;  // Lost to a peer -> by BusUpgr
+
+    std::vector<uint64_t> setAccesses;
+    std::vector<uint64_t> setMisses;
+    std::vector<uint64_t> setEvictions;
+    uint64_t missCounts[5];                 // Indexed by MissKind
+    uint64_t merges;
+};
+
+#endif // MISS_PROFILER_H
@@ -0,0 +1,166 @@
+#include "Prefetcher.h"
+#include <algorithm>
+
+// Stride table regions span 4 KiB
+static const int REGION_BITS = 12;
+
+// A trigger this many blocks or fewer from a stream's last one continues it
+static const int64_t STREAM_WINDOW = 4;
+
+// Triggers in one direction before a stream starts prefetching
+static const uint8_t STREAM_CONFIRM = 2;
+
+// Largest block number that still fits a 32-bit address
+static int64_t lastBlock(int blockBits) {
+    return (int64_t(1) << (32 - blockBits)) - 1;
+}
+
+// Constructor
+Prefetcher::Prefetcher(Kind kind, unsigned int degree, int blockBits)
+    : kind(kind), degree(degree), regionShift(std::max(0, REGION_BITS - blockBits)),
+      maxBlock(lastBlock(blockBits)), triggers(0) {
+    if (kind == Kind::STRIDE) strideTable.resize(STRIDE_ENTRIES);
+    if (kind == Kind::STREAM) streams.resize(STREAM_ENTRIES);
+}
+
+// Parse a prefetcher name
+bool Prefetcher::parseKind(const std::string& name, Kind& result) {
+    if (name == "none")      { result = Kind::NONE;      return true; }
+    if (name == "next-line") { result = Kind::NEXT_LINE; return true; }
+    if (name == "stride")    { result = Kind::STRIDE;    return true; }
+    if (name == "stream")    { result = Kind::STREAM;    return true; }
+    return false;
+}
+
+// Name of a prefetcher kind for messages
+const char* Prefetcher::kindName(Kind kind) {
+    switch (kind) {
+      case Kind::NEXT_LINE: return "next-line";
+      case Kind::STRIDE:    return "stride";
+      case Kind::STREAM:    return "stream";
+      default:              return "none";
+    }
+}
+
+// Train on a demand trigger and append the blocks to prefetch
+void Prefetcher::observe(uint32_t block, std::vector<uint32_t>& candidates) {
+    switch (kind) {
+      case Kind::NEXT_LINE:
+        for (unsigned int k = 1; k <= degree && block + int64_t(k) <= maxBlock; k++) {
+            candidates.push_back(block + k);
+        }
+        break;
+      case Kind::STRIDE:
+        observeStride(block, candidates);
+        break;
+      case Kind::STREAM:
+        observeStream(block, candidates);
+        break;
+      case Kind::NONE:
+        break;
+    }
+}
+
+// Stride table: one entry per region, confirmed after a repeated stride
+void Prefetcher::observeStride(uint32_t block, std::vector<uint32_t>& candidates) {
+    uint32_t region = block >> regionShift;
+    StrideEntry& entry = strideTable[region % STRIDE_ENTRIES];
+
+    if (!entry.valid || entry.region != region) {
+        entry.valid = true;
+        entry.region = region;
+        entry.lastBlock = block;
+        entry.stride = 0;
+        entry.confidence = 0;
+        return;
+    }
+
+    int32_t stride = static_cast<int32_t>(block - entry.lastBlock);
+    if (stride == 0) return;
+    if (stride == entry.stride) {
+        entry.confidence = std::min<uint8_t>(entry.confidence + 1, 3);
+    } else {
+        entry.stride = stride;
+        entry.confidence = 0;
+    }
+    entry.lastBlock = block;
+
+    if (entry.confidence == 0) return;
+    for (unsigned int k = 1; k <= degree; k++) {
+        int64_t target = int64_t(block) + int64_t(stride) * k;
+        if (target < 0 || target > maxBlock) break;
+        candidates.push_back(static_cast<uint32_t>(target));
+    }
+}
+
+// Stream tracker: extend a nearby stream or start tracking a new one
+void Prefetcher::observeStream(uint32_t block, std::vector<uint32_t>& candidates) {
+    triggers++;
+
+    StreamEntry* stream = nullptr;
+    for (auto& s : streams) {
+        if (!s.valid) continue;
+        int64_t distance = int64_t(block) - int64_t(s.lastBlock);
+        if (distance == 0) {
+            s.lastUse = triggers;
+            return;
+        }
+        if (distance >= -STREAM_WINDOW && distance <= STREAM_WINDOW) {
+            stream = &s;
+            break;
+        }
+    }
+
+    if (!stream) {
+        // Replace a free or the least recently used stream
+        StreamEntry* victim = &streams[0];
+        for (auto& s : streams) {
+            if (!s.valid) { victim = &s; break; }
+            if (s.lastUse < victim->lastUse) victim = &s;
+        }
+        *victim = StreamEntry();
+        victim->valid = true;
+        victim->lastBlock = block;
+        victim->frontier = block;
+        victim->lastUse = triggers;
+        return;
+    }
+
+    int32_t direction = block > stream->lastBlock ? 1 : -1;
+    if (direction == stream->direction) {
+        stream->confidence = std::min<uint8_t>(stream->confidence + 1, 3);
+    } else {
+        stream->direction = direction;
+        stream->confidence = 1;
+        stream->frontier = block;
+    }
+    stream->lastBlock = block;
+    stream->lastUse = triggers;
+
+    if (stream->confidence < STREAM_CONFIRM) return;
+
+    // Request only what lies between the old frontier and `degree` blocks ahead
+    int64_t target = int64_t(block) + int64_t(direction) * degree;
+    target = std::max<int64_t>(0, std::min(target, maxBlock));
+    int64_t next = int64_t(block) + direction;
+    int64_t ahead = (int64_t(stream->frontier) - int64_t(block)) * direction;
+    if (ahead > 0) {
+        next = int64_t(stream->frontier) + direction;
+    }
+    for (; (target - next) * direction >= 0; next += direction) {
+        candidates.push_back(static_cast<uint32_t>(next));
+    }
+    if ((target - int64_t(stream->frontier)) * direction > 0) {
+        stream->frontier = static_cast<uint32_t>(target);
+    }
+}
+
+// Get the prefetcher kind
+Prefetcher::Kind Prefetcher::getKind() const {
+    return kind;
+}
+
+// Get the prefetch degree
+unsigned int Prefetcher::getDegree() const {
+    return degree;
+}
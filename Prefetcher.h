@@ -0,0 +1,80 @@
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Hardware prefetch engine attached to one L1 cache.
+//
+// The cache trains it with the block number (address >> b) of every demand
+// miss and of the first demand access to each prefetched block, and the
+// engine answers with the block numbers to fetch ahead. Fetching, timing and
+// the useful/late/polluting accounting are the cache's job (Cache.cpp).
+//
+//   NEXT_LINE : the next `degree` blocks after the trigger
+//   STRIDE    : PC-less reference table indexed by 4 KiB region; once the
+//               same block stride is seen twice in a region, prefetch
+//               `degree` strides ahead
+//   STREAM    : stream tracker; a run of triggers within a small window
+//               moving in one direction confirms a stream, which is then
+//               kept `degree` blocks ahead of the last trigger
+class Prefetcher {
+public:
+    enum class Kind { NONE, NEXT_LINE, STRIDE, STREAM };
+
+    // Table sizes
+    static const unsigned int STRIDE_ENTRIES = 64;
+    static const unsigned int STREAM_ENTRIES = 16;
+
+    // Constructor - `blockBits` sizes the stride table's regions
+    Prefetcher(Kind kind, unsigned int degree, int blockBits);
+
+    // Parse "none", "next-line", "stride" or "stream"; returns false for anything else
+    static bool parseKind(const std::string& name, Kind& kind);
+
+    // Name of a prefetcher kind for messages
+    static const char* kindName(Kind kind);
+
+    // Train on a demand trigger and append the blocks to prefetch to `candidates`
+    void observe(uint32_t block, std::vector<uint32_t>& candidates);
+
+    // Get the prefetcher kind
+    Kind getKind() const;
+
+    // Get the prefetch degree
+    unsigned int getDegree() const;
+
+private:
+    // One region of the stride table
+    struct StrideEntry {
+        uint32_t region = 0;
+        uint32_t lastBlock = 0;
+        int32_t stride = 0;
+        uint8_t confidence = 0;   // Times in a row `stride` repeated (saturates at 3)
+        bool valid = false;
+    };
+
+    // One tracked stream
+    struct StreamEntry {
+        uint32_t lastBlock = 0;   // Most recent trigger
+        uint32_t frontier = 0;    // Furthest block already requested
+        int32_t direction = 0;    // +1 ascending, -1 descending, 0 not yet known
+        uint8_t confidence = 0;   // Triggers seen moving in `direction`
+        uint64_t lastUse = 0;     // For replacing the least recently used stream
+        bool valid = false;
+    };
+
+    void observeStride(uint32_t block, std::vector<uint32_t>& candidates);
+    void observeStream(uint32_t block, std::vector<uint32_t>& candidates);
+
+    Kind kind;
+    unsigned int degree;
+    int regionShift;              // log2(blocks per 4 KiB region)
+    int64_t maxBlock;             // Largest block number in the 32-bit address space
+    uint64_t triggers;            // Triggers seen (stream replacement clock)
+    std::vector<StrideEntry> strideTable;
+    std::vector<StreamEntry> streams;
+};
+
+#endif // PREFETCHER_H
@@ -1,98 +1,178 @@
-#include "Processor.h"
-#include <iostream>
-#include "Address.h"
-
-// Constructor
-Processor::Processor(int id, TraceReader& reader, Cache& cache)
-    : coreId(id), traceReader(reader), l1Cache(cache), 
-      blocked(false), cyclesBlocked(0), instructionsExecuted(0) {
-}
-
-// Execute the next instruction if possible
-bool Processor::executeNextInstruction() {
-    // If processor is blocked, can't execute instructions
-    if (blocked) {
-        cyclesBlocked++;
-        return false;
-    }
-    
-    // Check if there are more instructions to execute
-    if (!traceReader.hasMoreInstructions(coreId)) {
-        return false;
-    }
-    
-    // Get next instruction from trace
-    Instruction inst = traceReader.getNextInstruction(coreId);
-    
-    // Validate instruction
-    if (!inst.isValid()) {
-        cyclesBlocked++;
-        return false;
-    }
-    
-    // Create Address object from the instruction's address
-    // Cache configuration parameters taken from l1Cache
-    Address addr(inst.address, l1Cache.getSetBits(), l1Cache.getBlockBits());
-    
-    // Process based on instruction type
-    bool success = false;
-    if (inst.type == Instruction::Type::READ) {
-        // Attempt to read from cache
-        success = l1Cache.read(addr);
-    } else if (inst.type == Instruction::Type::WRITE) {
-        // Attempt to write to cache
-        success = l1Cache.write(addr);
-    }
-    
-    // If operation was not immediately successful (cache miss), block the processor
-    if (!success) {
-        blocked = true;
-    } else {
-        // If operation succeeded, increment executed instruction count
-        instructionsExecuted++;
-    }
-    
-    return success;
-}
-
-// Check if this processor is blocked
-bool Processor::isBlocked() const {
-    return blocked;
-}
-
-// Set blocked state
-void Processor::setBlocked(bool state) {
- 
-    if (blocked && !state) {
-        // If processor is being unblocked, count the instruction that caused blocking
-        instructionsExecuted++;
-    }
-    blocked = state;
-}
-
-// Get core ID
-int Processor::getCoreId() const {
-    return coreId;
-}
-
-// Check if processor has more instructions
-bool Processor::hasMoreInstructions() const {
-    return traceReader.hasMoreInstructions(coreId);
-}
-
-// Get cycles blocked
-unsigned int Processor::getCyclesBlocked() const {
-    return cyclesBlocked;
-}
-
-// Get instructions executed
-unsigned int Processor::getInstructionsExecuted() const {
-    return instructionsExecuted;
-}
-
-// Reset statistics
-void Processor::resetStats() {
-    cyclesBlocked = 0;
-    instructionsExecuted = 0;
-    blocked = false;
-}
\ No newline at end of file
+#include "Processor.h"
+#include "Checkpoint.h"
+#include "TraceScheduler.h"
+#include <iostream>
+#include "Address.h"
+
+// Constructor
+Processor::Processor(int id, TraceReader& reader, Cache& cache)
+    : coreId(id), traceReader(reader), scheduler(nullptr), l1Cache(cache), 
+      blocked(false), cyclesBlocked(0), instructionsExecuted(0),
+      retryPending(false), draining(false) {
+}
+
+// Fetch from the scheduler's streams instead of this core's trace
+void Processor::setScheduler(TraceScheduler* traceScheduler) {
+    scheduler = traceScheduler;
+}
+
+// Execute the next instruction if possible
+bool Processor::executeNextInstruction() {
+    // If processor is blocked, can't execute instructions
+    if (blocked) {
+        cyclesBlocked++;
+        return false;
+    }
+    
+    // Reissue an access the cache could not take earlier
+    if (retryPending) {
+        retryPending = false;
+        return executeInstruction(retryInstruction);
+    }
+    
+    // Check if there are more instructions to execute
+    if (!hasMoreInstructions()) {
+        return false;
+    }
+    
+    // A context switch may first flush the cache, stalling for its writebacks
+    if (scheduler && scheduler->schedule(coreId) && scheduler->flushesOnSwitch()) {
+        unsigned int dirty = 0;
+        unsigned int lines = l1Cache.flush(dirty);
+        scheduler->recordFlush(coreId, lines, dirty);
+        if (l1Cache.hasPendingMiss()) {
+            waitForDrain();
+            return false;
+        }
+    }
+    
+    // Get next instruction from trace
+    Instruction inst = scheduler ? scheduler->getNextInstruction(coreId)
+                                 : traceReader.getNextInstruction(coreId);
+    
+    // Validate instruction
+    if (!inst.isValid()) {
+        cyclesBlocked++;
+        return false;
+    }
+    
+    return executeInstruction(inst);
+}
+
+// Execute an instruction already fetched from the trace
+bool Processor::executeInstruction(const Instruction& inst) {
+    // Create Address object from the instruction's address
+    // Cache configuration parameters taken from l1Cache
+    Address addr(inst.address, l1Cache.getSetBits(), l1Cache.getBlockBits());
+    
+    // Process based on instruction type
+    bool success = false;
+    if (inst.type == Instruction::Type::READ) {
+        // Attempt to read from cache
+        success = l1Cache.read(addr);
+    } else if (inst.type == Instruction::Type::WRITE) {
+        // Attempt to write to cache
+        success = l1Cache.write(addr);
+    }
+    
+    // If operation was not immediately successful (cache miss), block the processor
+    if (!success) {
+        if (l1Cache.wasRejected()) {
+            // Not performed at all: issue it again once the cache can take it
+            retryPending = true;
+            retryInstruction = inst;
+        }
+        blocked = true;
+    } else {
+        // If operation succeeded, increment executed instruction count
+        instructionsExecuted++;
+    }
+    
+    return success;
+}
+
+// Check if this processor is blocked
+bool Processor::isBlocked() const {
+    return blocked;
+}
+
+// Set blocked state
+void Processor::setBlocked(bool state) {
+ 
+    if (blocked && !state && !retryPending && !draining) {
+        // If processor is being unblocked, count the instruction that caused blocking
+        instructionsExecuted++;
+    }
+    if (!state) {
+        draining = false;
+    }
+    blocked = state;
+}
+
+// Get core ID
+int Processor::getCoreId() const {
+    return coreId;
+}
+
+// Check if processor has more instructions
+bool Processor::hasMoreInstructions() const {
+    if (scheduler) {
+        return retryPending || scheduler->hasMoreInstructions(coreId);
+    }
+    return retryPending || traceReader.hasMoreInstructions(coreId);
+}
+
+// Take the instruction the cache refused, if any
+bool Processor::takeRetry(Instruction& inst) {
+    if (!retryPending) {
+        return false;
+    }
+    retryPending = false;
+    inst = retryInstruction;
+    return true;
+}
+
+// Block until the cache's outstanding misses return
+void Processor::waitForDrain() {
+    blocked = true;
+    draining = true;
+}
+
+// Get cycles blocked
+unsigned int Processor::getCyclesBlocked() const {
+    return cyclesBlocked;
+}
+
+// Get instructions executed
+unsigned int Processor::getInstructionsExecuted() const {
+    return instructionsExecuted;
+}
+
+// Reset statistics
+void Processor::resetStats() {
+    cyclesBlocked = 0;
+    instructionsExecuted = 0;
+    blocked = false;
+    retryPending = false;
+    draining = false;
+}
+
+// Checkpoint the execution state and counters
+void Processor::saveState(CheckpointWriter& out) const {
+    out.put<uint8_t>(blocked ? 1 : 0);
+    out.put(cyclesBlocked);
+    out.put(instructionsExecuted);
+    out.put<uint8_t>(retryPending ? 1 : 0);
+    out.put(retryInstruction);
+    out.put<uint8_t>(draining ? 1 : 0);
+}
+
+// Restore the execution state and counters
+void Processor::loadState(CheckpointReader& in) {
+    blocked = in.get<uint8_t>() != 0;
+    cyclesBlocked = in.get<unsigned int>();
+    instructionsExecuted = in.get<unsigned int>();
+    retryPending = in.get<uint8_t>() != 0;
+    retryInstruction = in.get<Instruction>();
+    draining = in.get<uint8_t>() != 0;
+}
@@ -1,45 +1,70 @@
-#ifndef PROCESSOR_H
-#define PROCESSOR_H
-
-#include "TraceReader.h"
-#include "Cache.h"
-#include <string>
-
-class Processor {
-private:
-    int coreId;                 // ID of this processor core
-    TraceReader& traceReader;   // Reference to the shared trace reader
-    Cache& l1Cache;             // Reference to this processor's L1 cache
-    
-    bool blocked;               // Whether this processor is blocked (on cache miss)
-    unsigned int cyclesBlocked; // Count of cycles spent blocked
-    unsigned int instructionsExecuted; // Count of instructions executed
-    
-public:
-    // Constructor
-    Processor(int id, TraceReader& reader, Cache& cache);
-    
-    // Execute the next instruction if possible (returns true if executed)
-    bool executeNextInstruction();
-    
-    // Check if this processor is blocked
-    bool isBlocked() const;
-    
-    // Set blocked state (when cache miss occurs)
-    void setBlocked(bool state);
-    
-    // Get core ID
-    int getCoreId() const;
-    
-    // Check if processor has more instructions
-    bool hasMoreInstructions() const;
-    void incrementCyclesBlocked() { cyclesBlocked++; }
-    // Get statistics
-    unsigned int getCyclesBlocked() const;
-    unsigned int getInstructionsExecuted() const;
-    
-    // Reset statistics
-    void resetStats();
-};
-
+#ifndef PROCESSOR_H
+#define PROCESSOR_H
+
+#include "TraceReader.h"
+#include "Cache.h"
+#include <string>
+
+class CheckpointWriter;
+class CheckpointReader;
+class TraceScheduler;
+
+class Processor {
+private:
+    int coreId;                 // ID of this processor core
+    TraceReader& traceReader;   // Reference to the shared trace reader
+    TraceScheduler* scheduler;  // Time-slices trace streams over the cores (nullptr = own trace)
+    Cache& l1Cache;             // Reference to this processor's L1 cache
+    
+    bool blocked;               // Whether this processor is blocked (on cache miss)
+    unsigned int cyclesBlocked; // Count of cycles spent blocked
+    unsigned int instructionsExecuted; // Count of instructions executed
+    bool retryPending;          // The cache refused `retryInstruction` (all MSHRs busy)
+    Instruction retryInstruction;
+    bool draining;              // Blocked only until outstanding misses return (trace done)
+    
+public:
+    // Constructor
+    Processor(int id, TraceReader& reader, Cache& cache);
+    
+    // Fetch from the scheduler's streams instead of this core's trace (nullptr = own trace)
+    void setScheduler(TraceScheduler* traceScheduler);
+    
+    // Execute the next instruction if possible (returns true if executed)
+    bool executeNextInstruction();
+    
+    // Execute an instruction already fetched from the trace (returns true on a hit)
+    bool executeInstruction(const Instruction& inst);
+    
+    // Check if this processor is blocked
+    bool isBlocked() const;
+    
+    // Set blocked state (when cache miss occurs)
+    void setBlocked(bool state);
+    
+    // Get core ID
+    int getCoreId() const;
+    
+    // Check if processor has more instructions (including one to reissue)
+    bool hasMoreInstructions() const;
+    
+    // Take the instruction the cache refused, if any (parallel loop)
+    bool takeRetry(Instruction& inst);
+    
+    // Block until the cache's outstanding misses return (not counted as an instruction)
+    void waitForDrain();
+    void incrementCyclesBlocked() { cyclesBlocked++; }
+    void addCyclesBlocked(unsigned int cycles) { cyclesBlocked += cycles; }
+    // Get statistics
+    unsigned int getCyclesBlocked() const;
+    unsigned int getInstructionsExecuted() const;
+    
+    // Reset statistics
+    void resetStats();
+    
+    // Checkpoint the execution state and counters
+    void saveState(CheckpointWriter& out) const;
+    void loadState(CheckpointReader& in);
+};
+
 #endif // PROCESSOR_H
\ No newline at end of file
@@ -0,0 +1,51 @@
+#ifndef REPLACEMENT_POLICY_H
+#define REPLACEMENT_POLICY_H
+
+#include <cstdint>
+#include <string>
+
+// Victim selection policy of a cache set.
+//
+// Every set dispatches on its policy with a plain switch into a routine
+// specialised for that policy (CacheSet.cpp), so the read/write path pays
+// one well-predicted branch and no virtual call. Per-way metadata:
+//   LRU, TRUE_LRU  32-bit access counter
+//   PLRU           one tree bit per way (ways - 1 node bits per set)
+//   SRRIP, BRRIP   one byte re-reference prediction value (2 bits used)
+//   RANDOM         none (one 32-bit generator per set)
+// An invalid way is always filled first, whatever the policy.
+enum class ReplacementPolicy : uint8_t {
+    LRU,       // Counter LRU updated on hits only (the original model)
+    TRUE_LRU,  // Counter LRU that also promotes a freshly filled line
+    PLRU,      // Tree pseudo-LRU
+    SRRIP,     // Static re-reference interval prediction, 2-bit
+    BRRIP,     // Bimodal RRIP: fills predicted distant except 1 in 32
+    RANDOM     // Uniformly random victim
+};
+
+// Parse a policy name ("lru", "true-lru", "plru", "srrip", "brrip", "random")
+// Returns false for anything else
+inline bool parseReplacementPolicy(const std::string& name, ReplacementPolicy& policy) {
+    if (name == "lru")      { policy = ReplacementPolicy::LRU;      return true; }
+    if (name == "true-lru") { policy = ReplacementPolicy::TRUE_LRU; return true; }
+    if (name == "plru")     { policy = ReplacementPolicy::PLRU;     return true; }
+    if (name == "srrip")    { policy = ReplacementPolicy::SRRIP;    return true; }
+    if (name == "brrip")    { policy = ReplacementPolicy::BRRIP;    return true; }
+    if (name == "random")   { policy = ReplacementPolicy::RANDOM;   return true; }
+    return false;
+}
+
+// Name of a policy for messages
+inline const char* replacementPolicyName(ReplacementPolicy policy) {
+    switch (policy) {
+      case ReplacementPolicy::LRU:      return "lru";
+      case ReplacementPolicy::TRUE_LRU: return "true-lru";
+      case ReplacementPolicy::PLRU:     return "plru";
+      case ReplacementPolicy::SRRIP:    return "srrip";
+      case ReplacementPolicy::BRRIP:    return "brrip";
+      case ReplacementPolicy::RANDOM:   return "random";
+    }
+    return "unknown";
+}
+
+#endif // REPLACEMENT_POLICY_H
@@ -0,0 +1,149 @@
+#include "SharingProfiler.h"
+#include <algorithm>
+#include <iomanip>
+
+// Constructor
+SharingProfiler::SharingProfiler(int numCores, int blockBits)
+    : numCores(numCores), blockBits(blockBits), current(numCores),
+      trueSharing(0), falseSharing(0) {
+}
+
+// Record of a block, created on first use
+SharingProfiler::Block& SharingProfiler::block(uint32_t blockAddr) {
+    Block& b = blocks[blockAddr];
+    if (b.cores.empty()) {
+        b.cores.resize(numCores);
+    }
+    return b;
+}
+
+// Demand access by a core
+void SharingProfiler::recordAccess(int core, uint32_t address, bool isWrite) {
+    uint32_t blockAddr = address & ~((1u << blockBits) - 1);
+    uint32_t wordIndex = ((address & ((1u << blockBits) - 1)) >> 2) & 63;
+    uint64_t word = uint64_t(1) << wordIndex;
+
+    CoreUse& use = block(blockAddr).cores[core];
+    if (isWrite) {
+        use.writeMask |= word;
+    } else {
+        use.readMask |= word;
+    }
+    use.sinceFill |= word;
+    current[core] = CurrentAccess{blockAddr, word, true};
+}
+
+// A block's data arrived in a core's cache
+void SharingProfiler::recordFill(int core, uint32_t blockAddr) {
+    // The access that missed is the first use of the new copy
+    const CurrentAccess& access = current[core];
+    block(blockAddr).cores[core].sinceFill =
+        access.valid && access.blockAddr == blockAddr ? access.word : 0;
+}
+
+// A core's copy invalidated by the requesting core's write
+void SharingProfiler::recordInvalidation(int core, int requestingCore, uint32_t blockAddr) {
+    Block& b = block(blockAddr);
+    const CurrentAccess& write = current[requestingCore];
+    uint64_t written = write.valid && write.blockAddr == blockAddr ? write.word : 0;
+
+    b.invalidations++;
+    if (b.cores[core].sinceFill & written) {
+        b.trueSharing++;
+        trueSharing++;
+    } else {
+        b.falseSharing++;
+        falseSharing++;
+    }
+    b.cores[core].sinceFill = 0;
+
+    if (b.lastInvalidator >= 0 && b.lastInvalidator != requestingCore) {
+        b.ownershipMoves++;
+    }
+    b.lastInvalidator = requestingCore;
+}
+
+// Bus bytes moved by a transaction for a block
+void SharingProfiler::recordTraffic(uint32_t blockAddr, uint64_t bytes) {
+    if (bytes) {
+        block(blockAddr).busBytes += bytes;
+    }
+}
+
+// Hottest blocks accessed by at least two cores
+std::vector<SharingProfiler::BlockReport> SharingProfiler::getTopBlocks(size_t count) const {
+    std::vector<BlockReport> shared;
+    for (const auto& entry : blocks) {
+        const Block& b = entry.second;
+        int users = 0;
+        for (const CoreUse& use : b.cores) {
+            if (use.readMask | use.writeMask) users++;
+        }
+        if (users < 2) continue;
+
+        BlockReport report;
+        report.blockAddr = entry.first;
+        report.invalidations = b.invalidations;
+        report.trueSharing = b.trueSharing;
+        report.falseSharing = b.falseSharing;
+        report.ownershipMoves = b.ownershipMoves;
+        report.busBytes = b.busBytes;
+        for (const CoreUse& use : b.cores) {
+            report.readMasks.push_back(use.readMask);
+            report.writeMasks.push_back(use.writeMask);
+        }
+        shared.push_back(std::move(report));
+    }
+
+    std::sort(shared.begin(), shared.end(), [](const BlockReport& a, const BlockReport& b) {
+        if (a.invalidations != b.invalidations) return a.invalidations > b.invalidations;
+        if (a.busBytes != b.busBytes) return a.busBytes > b.busBytes;
+        return a.blockAddr < b.blockAddr;
+    });
+    if (shared.size() > count) {
+        shared.resize(count);
+    }
+    return shared;
+}
+
+// True-sharing invalidations over all blocks
+uint64_t SharingProfiler::getTrueSharingCount() const {
+    return trueSharing;
+}
+
+// False-sharing invalidations over all blocks
+uint64_t SharingProfiler::getFalseSharingCount() const {
+    return falseSharing;
+}
+
+// Ranked table of the hottest shared blocks
+void SharingProfiler::printReport(std::ostream& out, size_t count) const {
+    uint64_t total = trueSharing + falseSharing;
+    out << "\n==== Top " << count << " Shared Blocks ====" << std::endl;
+    out << "Invalidations: " << total << " (" << trueSharing << " true sharing, "
+        << falseSharing << " false sharing";
+    if (total) {
+        out << ", " << std::fixed << std::setprecision(2)
+            << 100.0 * falseSharing / total << "% false";
+    }
+    out << ")" << std::endl;
+    out << "Masks: bit w = word w of the block (R = read, W = written), per core" << std::endl;
+    out << " Rank  Block       Inval   True  False  Moves  BusBytes  Masks" << std::endl;
+
+    size_t rank = 0;
+    for (const BlockReport& b : getTopBlocks(count)) {
+        out << std::setw(5) << ++rank << "  0x" << std::hex << std::setw(8) << std::setfill('0')
+            << b.blockAddr << std::dec << std::setfill(' ')
+            << std::setw(7) << b.invalidations
+            << std::setw(7) << b.trueSharing
+            << std::setw(7) << b.falseSharing
+            << std::setw(7) << b.ownershipMoves
+            << std::setw(10) << b.busBytes << " ";
+        for (int c = 0; c < numCores; c++) {
+            if (!(b.readMasks[c] | b.writeMasks[c])) continue;
+            out << " P" << c << " R=0x" << std::hex << b.readMasks[c]
+                << " W=0x" << b.writeMasks[c] << std::dec;
+        }
+        out << std::endl;
+    }
+}
@@ -0,0 +1,98 @@
+#ifndef SHARING_PROFILER_H
+#define SHARING_PROFILER_H
+
+#include <cstdint>
+#include <vector>
+#include <ostream>
+#include <unordered_map>
+
+// Per-block attribution of coherence traffic, shared by every cache.
+//
+// Only built into the access path with `make INSTRUMENT=1` (L1SIM_INSTRUMENT)
+// and enabled with --sharing-top. For each block it keeps, per core, a mask
+// of the words read and written (bit w = word w of the block; blocks above 64
+// words fold onto 64 bits) and the words used since that core's copy arrived.
+//
+// Every copy invalidated by a peer's write (BusRdX, BusUpgr or invalidate)
+// is classified when it happens:
+//   true sharing  : the invalidated core used the written word since its fill
+//   false sharing : it only used other words of the block
+// An ownership move is an invalidating write by a different core than the
+// block's previous invalidating writer (the ping-pong of a contended block).
+// Bus bytes are attributed to the block of each transaction, so they add up
+// to the simulator's bus traffic total.
+class SharingProfiler {
+public:
+    // One block's totals, as reported
+    struct BlockReport {
+        uint32_t blockAddr = 0;
+        uint64_t invalidations = 0;
+        uint64_t trueSharing = 0;
+        uint64_t falseSharing = 0;
+        uint64_t ownershipMoves = 0;
+        uint64_t busBytes = 0;
+        std::vector<uint64_t> readMasks;    // Per core
+        std::vector<uint64_t> writeMasks;   // Per core
+    };
+
+    // Constructor
+    SharingProfiler(int numCores, int blockBits);
+
+    // Demand access by a core (called before it issues any bus transaction)
+    void recordAccess(int core, uint32_t address, bool isWrite);
+
+    // A block's data arrived in a core's cache
+    void recordFill(int core, uint32_t blockAddr);
+
+    // A core's copy invalidated by the requesting core's write
+    void recordInvalidation(int core, int requestingCore, uint32_t blockAddr);
+
+    // Bus bytes moved by a transaction for a block
+    void recordTraffic(uint32_t blockAddr, uint64_t bytes);
+
+    // Blocks accessed by at least two cores, most invalidations first (ties:
+    // most bus bytes, then lowest address); at most `count` of them
+    std::vector<BlockReport> getTopBlocks(size_t count) const;
+
+    // Classified invalidations over all blocks
+    uint64_t getTrueSharingCount() const;
+    uint64_t getFalseSharingCount() const;
+
+    // Ranked table of the `count` hottest shared blocks
+    void printReport(std::ostream& out, size_t count) const;
+
+private:
+    // One core's use of one block
+    struct CoreUse {
+        uint64_t readMask = 0;
+        uint64_t writeMask = 0;
+        uint64_t sinceFill = 0;    // Words used since this core's copy arrived
+    };
+    struct Block {
+        std::vector<CoreUse> cores;
+        uint64_t invalidations = 0;
+        uint64_t trueSharing = 0;
+        uint64_t falseSharing = 0;
+        uint64_t ownershipMoves = 0;
+        uint64_t busBytes = 0;
+        int lastInvalidator = -1;
+    };
+    // The access each core is performing
+    struct CurrentAccess {
+        uint32_t blockAddr = 0;
+        uint64_t word = 0;          // Bit of the accessed word
+        bool valid = false;
+    };
+
+    // Record of a block, created on first use
+    Block& block(uint32_t blockAddr);
+
+    int numCores;
+    int blockBits;
+    std::unordered_map<uint32_t, Block> blocks;
+    std::vector<CurrentAccess> current;   // Per core
+    uint64_t trueSharing;
+    uint64_t falseSharing;
+};
+
+#endif // SHARING_PROFILER_H
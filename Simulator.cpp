@@ -1,280 +1,806 @@
-#include "Simulator.h"
-#include <iostream>
-#include <iomanip>
-#include <algorithm>
-#include "Cache.h"
-#include <vector>
-#include "Processor.h"
-std::vector<Cache*> allCaches; 
-// A single global bus‐reservation timestamp (file‐scope)
-// ensures we serialize all bus transactions.
-static unsigned int busBusyUntil = 0;
-
-// Constructor
-Simulator::Simulator(const SimulationConfig& config)
-  : config(config),
-    traceReader(config.appName, 4),  // 4 cores
-    mainMemory(1 << config.blockBits),
-    currentCycle(0),
-    totalInstructions(0),
-    totalCycles(0),
-    totalMemoryAccesses(0),
-    totalCacheHits(0),
-    totalCacheMisses(0),
-    cacheToCache(0),
-    busTrafficBytes(0),
-    invalidationCount(0)
-{ }
-
-// Destructor
-Simulator::~Simulator() {
-  if (logFile.is_open())
-    logFile.close();
-}
-
-// Initialize simulation
-bool Simulator::initialize() {
-  if (!traceReader.openTraceFiles()) {
-    std::cerr << "Error: Failed to open trace files.\n";
-    return false;
-  }
-
-  if (!config.outputFile.empty()) {
-    logFile.open(config.outputFile);
-    if (!logFile.is_open())
-      std::cerr << "Warning: Could not open output file: "
-                << config.outputFile << "\n";
-  }
-
-  initializeComponents();
-  return true;
-}
-
-// Initialize caches, processors, and coherence callbacks
-void Simulator::initializeComponents() {
-  int numSets   = 1 << config.setBits;
-  int blockSize = 1 << config.blockBits;
-
-  // 1) Create one Cache + Processor per core
-  
-  allCaches.clear();
-   for (int i = 0; i < 4; ++i) {
-        // 1) make each cache
-        caches.emplace_back(std::make_unique<Cache>(
-            i, numSets, config.associativity,
-            blockSize, config.setBits,
-            config.blockBits, mainMemory));
-
-        // 2) register its raw pointer
-        allCaches.push_back(caches.back().get());
-
-        // 3) make its processor
-        processors.emplace_back(std::make_unique<Processor>(
-            i, traceReader, *caches.back()));
-    }
-
-  // 2) Hook up coherence: every cache’s issueCoherenceRequest →
-  // we arbitrate and snoop here.
-  for (auto& cachePtr : caches) {
-    cachePtr->setCoherenceCallback(
-      [this, blockSize](BusTransaction t,
-                        const Address& addr,
-                        int requestingCore,
-                        bool& dataProvided,
-                        int& sourceCore)
-      {
-        // --- 1) Reserve the bus ---
-        // Determine bus‐transfer length (in cycles)
-        unsigned int numWords = blockSize / 4;
-        unsigned int length = 0;
-
-        switch(t) {
-  case BusTransaction::BUS_RD:
-  case BusTransaction::BUS_RDX: {
-    // for RDX we count sharers; bundle into its own block
-    if (t == BusTransaction::BUS_RDX) {
-      unsigned int setIdx = addr.getIndex();
-      uint32_t     tag    = addr.getTag();
-      unsigned int sharers = 0;
-      for (int c = 0; c < (int)caches.size(); ++c) {
-        if (c == requestingCore) continue;
-        auto& lines = caches[c]->getSets()[setIdx].getLines();
-        for (auto& L : lines) {
-          if (L.isValid() && L.getTag() == tag) {
-            sharers++;
-            break;
-          }
-        }
-      }
-      invalidationCount += sharers;
-      busTrafficBytes  += blockSize;
-    }
-    // BUS_RD or BUS_RDX both transfer the full block:
-    length = 2 * (blockSize / 4);
-    busTrafficBytes += (t == BusTransaction::BUS_RD ? blockSize : 0);  
-    break;
-  }
-
-  case BusTransaction::BUS_UPGR: {
-    // single invalidate packet
-    invalidationCount += 1;
-    length = 2;
-    break;
-  }
-
-  case BusTransaction::INVALIDATE: {
-    // same as an explicit invalidate
-    invalidationCount += 1;
-    length = 2;
-    break;
-  }
-
-  case BusTransaction::FLUSH: {
-    // writeback
-    length = 100;
-    busTrafficBytes += blockSize;
-    break;
-  }
-
-  default: {
-    length = 0;
-    break;
-  }
-}
-
-
-        // Bus arbitration: start when free
-        unsigned int startCycle = std::max(currentCycle, busBusyUntil);
-        busBusyUntil = startCycle + length;
-
-        // --- 2) Snooping: let every *other* cache react ---
-        for (int core = 0; core < (int)caches.size(); ++core) {
-          if (core == requestingCore) continue;
-
-          bool providedByPeer = false;
-          // ask that cache to handle the bus event
-          caches[core]->handleBusTransaction(
-            t, addr, requestingCore, providedByPeer);
-
-          // if it forwarded data & nobody else has yet, record it
-          if (providedByPeer && !dataProvided) {
-            dataProvided = true;
-            sourceCore   = core;
-            cacheToCache++;
-            
-          }
-        }
-      });
-  }
-}
-
-// Main simulation loop
-void Simulator::run() {
-  if (logFile.is_open())
-    logFile << "Cycle,P0,P1,P2,P3,MemAccesses,Hits,Misses\n";
-
-  // Continue until all traces done & no one is blocked
-  while (!traceReader.allTracesCompleted() ||
-         std::any_of(processors.begin(), processors.end(),
-                     [](auto& p){ return p->isBlocked(); }))
-  {
-    processNextCycle();
-    if (currentCycle % 1000 == 0)
-      logStatistics();
-  }
-
-  totalCycles = currentCycle;
-  totalInstructions = 0;
-  for (auto& p : processors)
-    totalInstructions += p->getInstructionsExecuted();
-
-  logStatistics();
-}
-
-// Advance one cycle
-bool Simulator::processNextCycle() {
-  ++currentCycle;
-  for (auto& c : caches)
-    c->setCycle(currentCycle);
-
-  // Let each core try its next instruction if not blocked
-  for (auto& p : processors) {
-    if (p->isBlocked()) 
-       p->incrementCyclesBlocked();
-    if (!p->isBlocked() && p->hasMoreInstructions())
-      p->executeNextInstruction();
-  }
-
-  // Unblock any cores whose miss has now resolved
-  for (size_t i = 0; i < caches.size(); ++i) {
-    if (caches[i]->checkMissResolved())
-      processors[i]->setBlocked(false);
-  }
-
-  // Update global stats
-  for (auto& c : caches) {
-    totalCacheHits   += c->getHitCount();
-    totalCacheMisses += c->getMissCount();
-    totalMemoryAccesses += c->getAccessCount();
-  }
-
-  return true;
-}
-
-void Simulator::logStatistics() {
-  if (!logFile.is_open()) return;
-  logFile << currentCycle << ",";
-  for (auto& p : processors) {
-    if (p->isBlocked())      logFile << "B,";
-    else if (p->hasMoreInstructions()) logFile << "A,";
-    else                     logFile << "C,";
-  }
-  logFile << totalMemoryAccesses << ","
-          << totalCacheHits       << ","
-          << totalCacheMisses     << "\n";
-}
-
-unsigned int   Simulator::getTotalInstructions()      const { return totalInstructions; }
-unsigned int   Simulator::getTotalCycles()            const { return totalCycles; }
-double         Simulator::getAverageMemoryAccessTime()const {
-  return totalMemoryAccesses==0 ? 0.0
-       : double(totalCycles)/totalMemoryAccesses;
-}
-unsigned int Simulator::getInvalidationCount() const {
-  return invalidationCount;
-}
-
-unsigned int Simulator::getBusTrafficBytes() const {
-  return busTrafficBytes;
-}
-
-void Simulator::printResults() const {
-  std::cout << "\n===== Simulation Results =====\n";
-  std::cout << "Total Instructions: " << totalInstructions << "\n";
-  std::cout << "Total Cycles:       " << totalCycles << "\n";
-  std::cout << "IPC:                "
-            << std::fixed << std::setprecision(3)
-            << double(totalInstructions)/totalCycles << "\n";
-
-  std::cout << "\n===== Memory System =====\n";
-  std::cout << "Mem Accesses:       " << totalMemoryAccesses << "\n";
-  std::cout << "Cache Hits:         " << totalCacheHits
-            << " (" << std::fixed<<std::setprecision(2)
-            << (100.0*totalCacheHits/totalMemoryAccesses)<<"%)\n";
-  std::cout << "Cache Misses:       " << totalCacheMisses
-            << " (" << std::fixed<<std::setprecision(2)
-            << (100.0*totalCacheMisses/totalMemoryAccesses)<<"%)\n";
-
-  std::cout << "\n===== Cache-to-Cache Transfers =====\n";
-  std::cout << "Transfers:          " << cacheToCache << "\n";
-
-  std::cout << "\n===== Per-Processor =====\n";
-  for (size_t i = 0; i < processors.size(); ++i) {
-    std::cout << "Core " << i
-              << "  Instr: " << processors[i]->getInstructionsExecuted()
-              << "  Stalls: " << processors[i]->getCyclesBlocked() << "\n";
-  }
-
-  if (!config.outputFile.empty())
-    std::cout << "\nLog written to: " << config.outputFile << "\n";
+#include "Simulator.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include "Cache.h"
+#include <vector>
+#include <limits>
+#include "Processor.h"
+#include "Barrier.h"
+#include "Checkpoint.h"
+#include <sstream>
+#include <thread>
+
+
+// Constructor
+Simulator::Simulator(const SimulationConfig& config)
+  : config(config),
+    traceReader(config.appName, config.numCores),
+    mainMemory(1 << config.blockBits, !config.tagOnly),
+    currentCycle(0),
+    totalInstructions(0),
+    totalCycles(0)
+{ }
+
+// Constructor over shared, pre-loaded traces
+Simulator::Simulator(const SimulationConfig& config, std::shared_ptr<const SharedTrace> traces)
+  : config(config),
+    traceReader(std::move(traces)),
+    mainMemory(1 << config.blockBits, !config.tagOnly),
+    currentCycle(0),
+    totalInstructions(0),
+    totalCycles(0)
+{ }
+
+// Destructor
+Simulator::~Simulator() {
+  if (logFile.is_open())
+    logFile.close();
+
+  // Close the last (partial) interval before the writer is flushed
+  if (statsSink) {
+    if (statsSample.cycle != currentCycle)
+      sampleStatistics();
+    statsSink->close();
+  }
+}
+
+// Initialize simulation
+bool Simulator::initialize() {
+  if (!config.schedule.empty()) {
+    // The scheduler reads every program's traces; traceReader stays closed
+    std::vector<ScheduleEntry> entries;
+    TraceScheduler::parseSchedule(config.schedule, config.numCores, entries);
+    scheduler = std::make_unique<TraceScheduler>(config.numCores, config.timeSlice, currentCycle);
+    scheduler->setFlushOnSwitch(config.flushOnSwitch);
+    if (!scheduler->open(entries))
+      return false;
+    if (config.prefetchTraces)
+      scheduler->startPrefetch();
+  } else {
+    if (!traceReader.openTraceFiles()) {
+      std::cerr << "Error: Failed to open trace files.\n";
+      return false;
+    }
+    if (config.prefetchTraces)
+      traceReader.startPrefetch();
+  }
+
+  if (!config.statsFile.empty()) {
+    StatsSink::Format format = StatsSink::Format::BINARY;
+    StatsSink::parseFormat(config.statsFormat, format);
+    statsSink = std::make_unique<StatsSink>(config.numCores, config.logInterval);
+    if (!statsSink->open(config.statsFile, format))
+      statsSink.reset();
+    nextSampleCycle = config.logInterval;
+  }
+
+  if (!config.outputFile.empty()) {
+    logFile.open(config.outputFile);
+    if (!logFile.is_open())
+      std::cerr << "Warning: Could not open output file: "
+                << config.outputFile << "\n";
+  }
+
+  initializeComponents();
+
+  if (!config.restoreFile.empty()) {
+    if (!restoreCheckpoint(config.restoreFile))
+      return false;
+    // The stream's first sample holds everything up to the checkpoint
+    if (statsSink)
+      sampleStatistics();
+  }
+  checkpointPending = !config.checkpointFile.empty();
+  return true;
+}
+
+// Initialize caches, processors, and the coherence bus
+void Simulator::initializeComponents() {
+  int numSets   = 1 << config.setBits;
+  int blockSize = 1 << config.blockBits;
+  ReplacementPolicy policy = ReplacementPolicy::LRU;
+  parseReplacementPolicy(config.replacement, policy);
+  Prefetcher::Kind prefetchKind = Prefetcher::Kind::NONE;
+  Prefetcher::parseKind(config.prefetcher, prefetchKind);
+  BusModel::Mode busMode = BusModel::Mode::ATOMIC;
+  BusModel::parseMode(config.bus, busMode);
+  bus = std::make_unique<BusModel>(busMode, blockSize, config.memoryBanks);
+  if (config.l2SetBits > 0) {
+    int l2BlockBits = config.l2BlockBits > 0 ? config.l2BlockBits : config.blockBits;
+    l2 = std::make_unique<L2Cache>(config.l2SetBits, config.l2Associativity, l2BlockBits,
+                                   config.l2Latency, config.l2Inclusive, policy);
+    l2->setUpperCaches(&cachePeers, config.blockBits);
+  }
+
+#ifdef L1SIM_INSTRUMENT
+  if (config.sharingTop > 0)
+    sharingProfiler = std::make_unique<SharingProfiler>(config.numCores, config.blockBits);
+#endif
+
+  // 1) Create one Cache + Processor per core
+  
+  cachePeers.clear();
+  finishCycles.assign(config.numCores, 0);
+  // Past four cores, probing every cache on each transaction stops scaling,
+  // so the sharer directory is used regardless of --snoop-filter
+  if (config.snoopFilter || config.numCores > 4)
+    snoopFilter = std::make_unique<SnoopFilter>(config.numCores);
+   for (int i = 0; i < config.numCores; ++i) {
+        // 1) make each cache
+        caches.emplace_back(std::make_unique<Cache>(
+            i, numSets, config.associativity,
+            blockSize, config.setBits,
+            config.blockBits, mainMemory, policy));
+
+        // 2) register its raw pointer
+        cachePeers.push_back(caches.back().get());
+        caches.back()->setPeerCaches(&cachePeers);
+        caches.back()->setSnoopFilter(snoopFilter.get());
+        caches.back()->setPrefetcher(prefetchKind, config.prefetchDegree);
+        caches.back()->setMshrCount(config.mshrs);
+        caches.back()->setBusModel(bus.get());
+        caches.back()->setWritebackBuffer(config.writebackBuffer);
+        caches.back()->setL2(l2.get());
+#ifdef L1SIM_INSTRUMENT
+        if (!config.missProfileFile.empty())
+          caches.back()->enableMissProfile();
+        caches.back()->setSharingProfiler(sharingProfiler.get());
+#endif
+
+        // 3) make its processor
+        processors.emplace_back(std::make_unique<Processor>(
+            i, traceReader, *caches.back()));
+        processors.back()->setScheduler(scheduler.get());
+    }
+
+  // 2) Hook up coherence: every cache's transactions go over one bus,
+  // which arbitrates and lets the other caches snoop
+  CoherenceProtocol protocol = CoherenceProtocol::MESI;
+  if (!config.protocol.empty())
+    Bus::parseProtocol(config.protocol, protocol);
+  coherenceBus = std::make_unique<Bus>(protocol, cachePeers, *bus, blockSize, currentCycle);
+  coherenceBus->setSnoopFilter(snoopFilter.get());
+  coherenceBus->setL2(l2.get());
+  coherenceBus->setWritebackBuffers(config.writebackBuffer > 0);
+#ifdef L1SIM_INSTRUMENT
+  coherenceBus->setSharingProfiler(sharingProfiler.get());
+#endif
+  for (auto& cachePtr : caches)
+    cachePtr->setBus(coherenceBus.get());
+}
+
+// Main simulation loop
+void Simulator::run() {
+  if (logFile.is_open()) {
+    logFile << "Cycle,";
+    for (int i = 0; i < config.numCores; ++i)
+      logFile << "P" << i << ",";
+    logFile << "MemAccesses,Hits,Misses\n";
+  }
+
+  // Continue until all traces done & no one is blocked
+  if (config.threads > 0)
+    runParallel();
+  else if (config.sampleInterval > 0)
+    runSampled();
+  else while (!allTracesCompleted() ||
+         std::any_of(processors.begin(), processors.end(),
+                     [](auto& p){ return p->isBlocked(); }))
+  {
+    processNextCycle();
+    if (currentCycle % config.logInterval == 0)
+      logStatistics();
+  }
+
+  totalCycles = currentCycle;
+  totalInstructions = 0;
+  for (auto& p : processors)
+    totalInstructions += p->getInstructionsExecuted();
+
+  logStatistics();
+  writeMissProfile();
+}
+
+// Write every cache's miss classification and per-set histograms as JSON
+void Simulator::writeMissProfile() const {
+#ifdef L1SIM_INSTRUMENT
+  if (config.missProfileFile.empty())
+    return;
+  std::ofstream out(config.missProfileFile);
+  if (!out.is_open()) {
+    std::cerr << "Warning: Could not open miss profile file: "
+              << config.missProfileFile << "\n";
+    return;
+  }
+  out << "{\n"
+      << "  \"geometry\": {\"sets\": " << (1 << config.setBits)
+      << ", \"ways\": " << config.associativity
+      << ", \"block_bytes\": " << (1 << config.blockBits) << "},\n"
+      << "  \"cores\": [\n";
+  for (size_t c = 0; c < caches.size(); ++c) {
+    caches[c]->getMissProfiler()->writeJson(out, static_cast<int>(c), "    ");
+    out << (c + 1 < caches.size() ? ",\n" : "\n");
+  }
+  out << "  ]\n"
+      << "}\n";
+#endif
+}
+
+// Advance one cycle
+bool Simulator::processNextCycle() {
+  if (config.eventDriven)
+    skipIdleCycles();
+
+  ++currentCycle;
+  for (auto& c : caches)
+    c->setCycle(currentCycle);
+
+  // Let each core try its next instruction if not blocked
+  for (size_t i = 0; i < processors.size(); ++i) {
+    auto& p = processors[i];
+    if (p->isBlocked()) 
+       p->incrementCyclesBlocked();
+    if (!p->isBlocked() && p->hasMoreInstructions()) {
+      if (functionalWarming && !takeWarmingTurn(i))
+        continue;
+      p->executeNextInstruction();
+      if (!p->hasMoreInstructions())
+        finishCore(i, currentCycle);
+    }
+  }
+
+  // Unblock any cores whose miss has now resolved
+  for (size_t i = 0; i < caches.size(); ++i) {
+    if (caches[i]->checkMissResolved()) {
+      processors[i]->setBlocked(false);
+      if (caches[i]->getMshrCount() > 1 && !processors[i]->hasMoreInstructions())
+        finishCore(i, currentCycle);
+    }
+  }
+
+  if (statsSink && currentCycle >= nextSampleCycle)
+    sampleStatistics();
+
+  if (checkpointPending)
+    checkCheckpoint();
+
+  return true;
+}
+
+// Fast-forward currentCycle while every core is blocked or finished.
+// Skipped cycles are accounted exactly as the stepped loop would have
+// accounted them, so final statistics are identical in both modes.
+void Simulator::skipIdleCycles() {
+  // A core that can still issue means the next cycle does real work
+  for (auto& p : processors) {
+    if (!p->isBlocked() && p->hasMoreInstructions())
+      return;
+  }
+
+  // Earliest future event: a pending miss resolving or the bus freeing up
+  unsigned int nextEvent = std::numeric_limits<unsigned int>::max();
+  for (auto& c : caches) {
+    if (c->hasPendingMiss())
+      nextEvent = std::min(nextEvent, c->getMissResolveTime());
+  }
+  if (bus->getBusyUntil() > currentCycle)
+    nextEvent = std::min(nextEvent, bus->getBusyUntil());
+  if (nextEvent == std::numeric_limits<unsigned int>::max())
+    return;  // Nothing scheduled, keep stepping
+
+  // The event cycle itself is simulated normally; stop early at the
+  // next log boundary so every logInterval cycles are still sampled.
+  unsigned int target  = nextEvent - 1;
+  unsigned int nextLog = (currentCycle / config.logInterval + 1) * config.logInterval;
+  target = std::min(target, nextLog - 1);
+  if (target <= currentCycle)
+    return;
+
+  unsigned int skipped = target - currentCycle;
+  for (auto& p : processors) {
+    if (p->isBlocked())
+      p->addCyclesBlocked(skipped);
+  }
+
+  currentCycle = target;
+}
+
+// Instructions the processors have executed between them
+uint64_t Simulator::executedInstructions() const {
+  uint64_t executed = 0;
+  for (auto& p : processors)
+    executed += p->getInstructionsExecuted();
+  return executed;
+}
+
+// Switch every cache and the bus accounting between functional and detailed
+void Simulator::setFunctionalWarming(bool enabled) {
+  functionalWarming = enabled;
+  coherenceBus->setFunctional(enabled);
+  for (auto& c : caches)
+    c->setFunctional(enabled);
+}
+
+// Functional warming runs each core at the relative speed it had in the
+// last detailed window, so the cores' distance in their traces (and with it
+// which blocks they contend for) stays what detailed simulation produces
+bool Simulator::takeWarmingTurn(int core) {
+  warmingCredit[core] += warmingRate[core];
+  if (warmingCredit[core] < 1.0)
+    return false;
+  warmingCredit[core] -= 1.0;
+  return true;
+}
+
+// The fastest core that still has instructions executes every functional cycle
+void Simulator::rescaleWarming() {
+  double fastest = 0.0;
+  for (size_t i = 0; i < processors.size(); ++i)
+    if (processors[i]->hasMoreInstructions())
+      fastest = std::max(fastest, warmingSpeed[i]);
+  for (size_t i = 0; i < processors.size(); ++i)
+    warmingRate[i] = fastest > 0.0 ? std::min(1.0, warmingSpeed[i] / fastest) : 1.0;
+}
+
+// Sampled main loop (systematic sampling, as in SMARTS). Window k starts
+// once the cores have executed k * sampleInterval instructions between them;
+// until then every access updates tags, states and the L2 functionally, one
+// instruction per cycle for the fastest core. A window then runs sampleWarmup
+// instructions in detail, so fills, the bus and the MSHRs reach a
+// representative state, and measures CPI and miss rate over the next
+// sampleSize. Since every window covers the same number of instructions,
+// the mean window CPI estimates the whole run's cycles per instruction.
+// Windows cut short by the end of the traces are dropped.
+void Simulator::runSampled() {
+  uint64_t interval = config.sampleInterval;
+  uint64_t windowStart = (executedInstructions() / interval + 1) * interval;
+  int numCores = (int)processors.size();
+  warmingSpeed.assign(numCores, 1.0);  // Until the first window: lockstep
+  warmingRate.assign(numCores, 1.0);
+  warmingCredit.assign(numCores, 0.0);
+  std::vector<unsigned int> coreStart(numCores);
+
+  while (!isSimulationComplete()) {
+    setFunctionalWarming(true);
+    while (!isSimulationComplete() && executedInstructions() < windowStart)
+      processNextCycle();
+    setFunctionalWarming(false);
+
+    uint64_t detailedStart = executedInstructions();
+    unsigned int detailedCycle = currentCycle;
+    for (int i = 0; i < numCores; ++i)
+      coreStart[i] = processors[i]->getInstructionsExecuted();
+    uint64_t measureStart = windowStart + config.sampleWarmup;
+    uint64_t measureEnd = measureStart + config.sampleSize;
+    while (!isSimulationComplete() && executedInstructions() < measureStart)
+      processNextCycle();
+
+    unsigned int cycleBefore = currentCycle;
+    uint64_t instrBefore = executedInstructions();
+    CacheStats before = getCacheTotals();
+    while (!isSimulationComplete() && executedInstructions() < measureEnd)
+      processNextCycle();
+    uint64_t instructions = executedInstructions() - instrBefore;
+    CacheStats window = getCacheTotals() - before;
+    if (instructions > 0 && executedInstructions() >= measureEnd) {
+      sampledCpi.add(double(currentCycle - cycleBefore) / instructions);
+      sampledMissRate.add(window.missRate());
+    }
+
+    detailedInstructions += executedInstructions() - detailedStart;
+
+    // Core speeds over the detailed part; a core that made no progress
+    // still creeps forward so it cannot stall the warming for good
+    if (currentCycle > detailedCycle) {
+      for (int i = 0; i < numCores; ++i)
+        warmingSpeed[i] = std::max(1.0 / 1024,
+            double(processors[i]->getInstructionsExecuted() - coreStart[i]));
+      rescaleWarming();
+    }
+    windowStart += interval;
+  }
+  setFunctionalWarming(false);
+}
+
+// Parallel main loop. Time advances in windows that end `quantum` cycles
+// after the slowest unfinished core. Inside a window every core runs on a
+// worker thread until the window ends or it reaches an access that needs
+// the bus (a miss or an upgrade); those touch only the core's own cache.
+// At the barrier the parked accesses run one at a time in (cycle, core)
+// order. A core may therefore have run up to a quantum past a transaction
+// that reaches it; such transactions are counted as lagged. Results are
+// deterministic and do not depend on the number of threads.
+void Simulator::runParallel() {
+  int numCores = (int)processors.size();
+  int numThreads = std::max(1, std::min(config.threads, numCores));
+  unsigned int quantum = std::max(1u, config.quantum);
+  coreClocks.assign(numCores, CoreClock());
+
+  Barrier barrier(numThreads);
+  unsigned int windowEnd = 0;
+  bool stopping = false;
+
+  // Thread t advances cores t, t+numThreads, ...
+  auto advanceShare = [&](int thread) {
+    for (int i = thread; i < numCores; i += numThreads)
+      advanceCore(i, windowEnd);
+  };
+  std::vector<std::thread> workers;
+  for (int t = 1; t < numThreads; ++t) {
+    workers.emplace_back([&, t] {
+      while (true) {
+        barrier.arriveAndWait();   // Window start
+        if (stopping) return;
+        advanceShare(t);
+        barrier.arriveAndWait();   // Window end
+      }
+    });
+  }
+
+  while (true) {
+    // The slowest core that still has work bounds how far anyone may run
+    unsigned int slowest = std::numeric_limits<unsigned int>::max();
+    for (int i = 0; i < numCores; ++i) {
+      if (processors[i]->isBlocked() || processors[i]->hasMoreInstructions())
+        slowest = std::min(slowest, coreClocks[i].next);
+    }
+    if (slowest == std::numeric_limits<unsigned int>::max())
+      break;
+
+    // Sample once every core has passed a sampling boundary
+    if (statsSink && slowest - 1 >= nextSampleCycle) {
+      currentCycle = slowest - 1;
+      sampleStatistics();
+    }
+
+    windowEnd = slowest + quantum;
+    if (numThreads > 1) barrier.arriveAndWait();
+    advanceShare(0);
+    if (numThreads > 1) barrier.arriveAndWait();
+
+    runParkedAccesses();
+  }
+
+  stopping = true;
+  if (numThreads > 1) barrier.arriveAndWait();
+  for (auto& w : workers)
+    w.join();
+
+  // The run ends on the last cycle any core simulated
+  currentCycle = 0;
+  for (auto& clock : coreClocks)
+    currentCycle = std::max(currentCycle, clock.next - 1);
+}
+
+// Advance one core up to (not including) windowEnd, stepping through
+// stalls and local hits exactly as the serial loop would
+void Simulator::advanceCore(int core, unsigned int windowEnd) {
+  CoreClock& clock = coreClocks[core];
+  Processor& proc  = *processors[core];
+  Cache& cache     = *caches[core];
+
+  while (clock.next < windowEnd) {
+    if (proc.isBlocked()) {
+      // Blocked through the resolve cycle, running again the cycle after
+      unsigned int resolve = cache.getMissResolveTime();
+      unsigned int last = std::min(resolve, windowEnd - 1);
+      if (last >= clock.next) {
+        proc.addCyclesBlocked(last - clock.next + 1);
+        clock.next = last + 1;
+      }
+      if (clock.next > resolve) {
+        cache.setCycle(resolve);
+        cache.checkMissResolved();
+        proc.setBlocked(false);
+        if (cache.getMshrCount() > 1 && !proc.hasMoreInstructions())
+          finishCore(core, resolve);
+      }
+      continue;
+    }
+    if (!proc.hasMoreInstructions())
+      return;
+
+    unsigned int cycle = clock.next;
+    Instruction inst;
+    if (!proc.takeRetry(inst))
+      inst = traceReader.getNextInstruction(core);
+    if (!inst.isValid()) {
+      // Same accounting as Processor::executeNextInstruction
+      proc.addCyclesBlocked(1);
+      clock.next++;
+      if (!proc.hasMoreInstructions())
+        finishCore(core, cycle);
+      continue;
+    }
+
+    Address addr(inst.address, config.setBits, config.blockBits);
+    if (!cache.canCompleteLocally(addr, inst.type == Instruction::Type::WRITE)) {
+      clock.parked = true;
+      clock.parkedAccess = inst;
+      return;
+    }
+    cache.setCycle(cycle);
+    proc.executeInstruction(inst);
+    clock.lastAccess = cycle;
+    clock.next++;
+    if (!proc.hasMoreInstructions())
+      finishCore(core, cycle);
+  }
+}
+
+// Run every parked access in (cycle, core) order on the calling thread
+void Simulator::runParkedAccesses() {
+  std::vector<int> order;
+  for (int i = 0; i < (int)coreClocks.size(); ++i) {
+    if (coreClocks[i].parked)
+      order.push_back(i);
+  }
+  std::sort(order.begin(), order.end(), [this](int a, int b) {
+    return coreClocks[a].next != coreClocks[b].next ? coreClocks[a].next < coreClocks[b].next
+                                                    : a < b;
+  });
+
+  for (int i : order) {
+    CoreClock& clock = coreClocks[i];
+    unsigned int cycle = clock.next;
+
+    // An earlier window may already have run a later transaction
+    transactionLagged = cycle < busCycle;
+    transactionLag = transactionLagged ? busCycle - cycle : 0;
+    busCycle = std::max(busCycle, cycle);
+
+    currentCycle = cycle;
+    caches[i]->setCycle(cycle);
+    coherenceBus->takeSnoopedHolders();
+    processors[i]->executeInstruction(clock.parkedAccess);
+    clock.parked = false;
+    clock.lastAccess = cycle;
+    clock.next = cycle + 1;
+    if (!processors[i]->hasMoreInstructions())
+      finishCore(i, cycle);
+    // Peers that held the blocks this access's transactions touched
+    for (uint64_t held = coherenceBus->takeSnoopedHolders(); held; held &= held - 1)
+      noteSnoopLag(__builtin_ctzll(held), i);
+
+    if (transactionLagged) {
+      laggedTransactions++;
+      maxLag = std::max(maxLag, transactionLag);
+    }
+  }
+}
+
+// A core has run out of instructions. With MSHRs it may still have misses
+// in flight; it then waits for them, and finishes again when they return.
+void Simulator::finishCore(int core, unsigned int cycle) {
+  finishCycles[core] = cycle;
+  if (functionalWarming)
+    rescaleWarming();   // The others may now run faster
+  if (!processors[core]->isBlocked() && caches[core]->drainMisses())
+    processors[core]->waitForDrain();
+}
+
+// A snooped peer that already ran accesses past this transaction's place
+// in serial order saw its block too late
+void Simulator::noteSnoopLag(int core, int requestingCore) {
+  unsigned int peerCycle = coreClocks[core].lastAccess;
+  if (peerCycle > currentCycle || (peerCycle == currentCycle && core > requestingCore)) {
+    transactionLagged = true;
+    transactionLag = std::max(transactionLag, peerCycle - currentCycle);
+  }
+}
+
+// Push the current cumulative counters to the statistics sink
+void Simulator::sampleStatistics() {
+  int numCores = (int)processors.size();
+  StatsSink::Sample& s = statsSample;
+  s.hits.resize(numCores);
+  s.misses.resize(numCores);
+  s.stalls.resize(numCores);
+  s.states.resize(numCores);
+
+  s.cycle = currentCycle;
+  for (int i = 0; i < numCores; ++i) {
+    const CacheStats& stats = caches[i]->getStats();
+    s.hits[i]   = stats.hits;
+    s.misses[i] = stats.misses;
+    s.stalls[i] = processors[i]->getCyclesBlocked();
+    s.states[i] = processors[i]->isBlocked()           ? StatsSink::STATE_BLOCKED
+                : processors[i]->hasMoreInstructions() ? StatsSink::STATE_ACTIVE
+                                                       : StatsSink::STATE_COMPLETE;
+  }
+  s.invalidations = coherenceBus->getInvalidationCount();
+  s.busBytes = coherenceBus->getTrafficBytes();
+  statsSink->record(s);
+
+  nextSampleCycle = (currentCycle / config.logInterval + 1) * config.logInterval;
+}
+
+// Save the checkpoint on the first cycle boundary at which the cores have
+// executed config.checkpointAt instructions between them
+void Simulator::checkCheckpoint() {
+  uint64_t executed = executedInstructions();
+  if (executed >= config.checkpointAt) {
+    checkpointPending = false;
+    if (saveCheckpoint(config.checkpointFile))
+      std::cout << "Checkpoint written to " << config.checkpointFile << " at cycle "
+                << currentCycle << " (" << executed << " instructions)\n";
+  } else if (isSimulationComplete()) {
+    checkpointPending = false;
+    std::cerr << "Warning: The traces ended after " << executed
+              << " instructions; no checkpoint written\n";
+  }
+}
+
+// Every setting that shapes the saved state; a checkpoint only restores
+// into a simulator whose signature is identical
+std::string Simulator::checkpointSignature() const {
+  std::ostringstream sig;
+  sig << config.appName << " n=" << config.numCores
+      << " s=" << config.setBits << " E=" << config.associativity
+      << " b=" << config.blockBits << " tag-only=" << config.tagOnly
+      << " replacement=" << config.replacement << " mshrs=" << config.mshrs
+      << " bus=" << config.bus << " banks=" << config.memoryBanks
+      << " wb=" << config.writebackBuffer;
+  if (!config.protocol.empty() && config.protocol != "mesi")
+    sig << " protocol=" << config.protocol;
+  if (config.l2SetBits > 0)
+    sig << " l2=" << config.l2SetBits << "," << config.l2Associativity << ","
+        << config.l2BlockBits << "," << config.l2Latency << "," << config.l2Inclusive;
+  return sig.str();
+}
+
+// Write the complete simulator state
+bool Simulator::saveCheckpoint(const std::string& path) const {
+  CheckpointWriter out(path);
+  out.putString(checkpointSignature());
+
+  out.put(currentCycle);
+  coherenceBus->saveState(out);
+  out.putVector(finishCycles);
+  for (int i = 0; i < config.numCores; ++i)
+    out.put(traceReader.getConsumedCount(i));
+
+  mainMemory.saveState(out);
+  bus->saveState(out);
+  out.put<uint8_t>(l2 ? 1 : 0);
+  if (l2)
+    l2->saveState(out);
+  for (int i = 0; i < config.numCores; ++i) {
+    caches[i]->saveState(out);
+    processors[i]->saveState(out);
+  }
+
+  if (!out.good()) {
+    std::cerr << "Error: Could not write checkpoint file: " << path << "\n";
+    return false;
+  }
+  return true;
+}
+
+// Load a checkpoint written by saveCheckpoint into the freshly built components
+bool Simulator::restoreCheckpoint(const std::string& path) {
+  CheckpointReader in(path);
+  if (in.failed())
+    return false;
+  std::string signature = in.getString();
+  if (signature != checkpointSignature()) {
+    std::cerr << "Error: Checkpoint " << path << " was saved for a different configuration\n"
+              << "  saved:   " << signature << "\n"
+              << "  current: " << checkpointSignature() << "\n";
+    return false;
+  }
+
+  currentCycle = in.get<unsigned int>();
+  coherenceBus->loadState(in);
+  in.getVectorInto(finishCycles);
+  for (int i = 0; i < config.numCores && !in.failed(); ++i) {
+    if (!traceReader.skipInstructions(i, in.get<uint64_t>())) {
+      std::cerr << "Error: Trace of core " << i << " is shorter than checkpoint " << path << "\n";
+      return false;
+    }
+  }
+
+  mainMemory.loadState(in);
+  bus->loadState(in);
+  if (in.get<uint8_t>() != (l2 ? 1 : 0))
+    in.fail();
+  else if (l2)
+    l2->loadState(in);
+  for (int i = 0; i < config.numCores && !in.failed(); ++i) {
+    caches[i]->loadState(in);
+    processors[i]->loadState(in);
+  }
+
+  if (in.failed()) {
+    std::cerr << "Error: Checkpoint file is truncated or damaged: " << path << "\n";
+    return false;
+  }
+  nextSampleCycle = (currentCycle / config.logInterval + 1) * config.logInterval;
+  return true;
+}
+
+// Sum the per-cache counters
+CacheStats Simulator::getCacheTotals() const {
+  CacheStats totals;
+  for (auto& c : caches)
+    totals += c->getStats();
+  return totals;
+}
+
+void Simulator::logStatistics() {
+  if (!logFile.is_open()) return;
+  CacheStats totals = getCacheTotals();
+  logFile << currentCycle << ",";
+  for (auto& p : processors) {
+    if (p->isBlocked())      logFile << "B,";
+    else if (p->hasMoreInstructions()) logFile << "A,";
+    else                     logFile << "C,";
+  }
+  logFile << totals.accesses << ","
+          << totals.hits     << ","
+          << totals.misses   << "\n";
+}
+
+uint64_t       Simulator::getTotalInstructions()      const { return totalInstructions; }
+unsigned int   Simulator::getTotalCycles()            const { return totalCycles; }
+double         Simulator::getAverageMemoryAccessTime()const {
+  uint64_t accesses = getCacheTotals().accesses;
+  return accesses==0 ? 0.0
+       : double(totalCycles)/accesses;
+}
+uint64_t Simulator::getInvalidationCount() const {
+  return coherenceBus->getInvalidationCount();
+}
+
+uint64_t Simulator::getBusTrafficBytes() const {
+  return coherenceBus->getTrafficBytes();
+}
+
+unsigned int Simulator::getFinishCycle(int core) const {
+  return finishCycles[core];
+}
+
+uint64_t Simulator::getLaggedTransactions() const {
+  return laggedTransactions;
+}
+
+unsigned int Simulator::getMaxLag() const {
+  return maxLag;
+}
+
+uint64_t Simulator::getCacheToCacheTransfers() const {
+  return coherenceBus->getCacheToCacheTransfers();
+}
+
+void Simulator::printResults() const {
+  std::cout << "\n===== Simulation Results =====\n";
+  std::cout << "Total Instructions: " << totalInstructions << "\n";
+  std::cout << "Total Cycles:       " << totalCycles << "\n";
+  std::cout << "IPC:                "
+            << std::fixed << std::setprecision(3)
+            << double(totalInstructions)/totalCycles << "\n";
+
+  CacheStats totals = getCacheTotals();
+  std::cout << "\n===== Memory System =====\n";
+  std::cout << "Mem Accesses:       " << totals.accesses << "\n";
+  std::cout << "Cache Hits:         " << totals.hits
+            << " (" << std::fixed<<std::setprecision(2)
+            << (100.0*totals.hitRate())<<"%)\n";
+  std::cout << "Cache Misses:       " << totals.misses
+            << " (" << std::fixed<<std::setprecision(2)
+            << (100.0*totals.missRate())<<"%)\n";
+
+  std::cout << "\n===== Cache-to-Cache Transfers =====\n";
+  std::cout << "Transfers:          " << coherenceBus->getCacheToCacheTransfers() << "\n";
+
+  std::cout << "\n===== Per-Processor =====\n";
+  for (size_t i = 0; i < processors.size(); ++i) {
+    std::cout << "Core " << i
+              << "  Instr: " << processors[i]->getInstructionsExecuted()
+              << "  Stalls: " << processors[i]->getCyclesBlocked() << "\n";
+  }
+
+  if (!config.outputFile.empty())
+    std::cout << "\nLog written to: " << config.outputFile << "\n";
 }
\ No newline at end of file
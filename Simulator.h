@@ -1,87 +1,182 @@
-#ifndef SIMULATOR_H
-#define SIMULATOR_H
-
-#include "CommandLine.h" // For SimulationConfig
-#include "TraceReader.h"
-#include "Cache.h"
-#include "Processor.h"
-#include "MainMemory.h"
-#include <vector>
-#include <memory>
-#include <fstream>
-#include <algorithm> // For std::none_of
-
-class Simulator {
-private:
-    // Statistics
-    unsigned int totalInstructions;
-    unsigned int totalCycles;
-    unsigned int totalMemoryAccesses;
-    unsigned int totalCacheHits;
-    unsigned int totalCacheMisses;
-    unsigned int invalidationCount = 0;
-    unsigned int busTrafficBytes = 0;
-    // Cache-to-cache transfers (for coherence)
-    unsigned int cacheToCache;
-    
-    // Private methods
-    void logStatistics();
-    void handleCacheMissResolution();
-    void initializeComponents(); // Added this declaration
-    
-protected: // Changed from private to protected for TestSimulator access
-    // Configuration
-    SimulationConfig config;
-    
-    // Main components
-    TraceReader traceReader;
-    MainMemory mainMemory;
-    std::vector<std::unique_ptr<Cache>> caches;
-    std::vector<std::unique_ptr<Processor>> processors;
-    
-    // Simulation state
-    unsigned int currentCycle;
-    std::ofstream logFile;
-    
-    // Protected methods for derived classes
-    virtual bool processNextCycle();
-    
-    // Add this method for TestSimulator
-    bool isSimulationComplete() {
-        return traceReader.allTracesCompleted() && 
-               std::none_of(processors.begin(), processors.end(), 
-                          [](const auto& p) { return p->isBlocked(); });
-    }
-    
-public:
-    // Constructor
-    Simulator(const SimulationConfig& config);
-    
-    // Destructor
-    ~Simulator();
-    
-    // Run the simulation
-    void run();
-    
-    // Initialize simulation
-    bool initialize();
-    // Expose the current cycle counter
-    unsigned int getCurrentCycle() const { return currentCycle; }
-
-    // Expose the cache and processor arrays
-    const std::vector<std::unique_ptr<Cache>>& getCaches() const { return caches; }
-    const std::vector<std::unique_ptr<Processor>>& getProcessors() const { return processors; }
-
-    // Expose the memory stats
-    const MainMemory& getMainMemory() const { return mainMemory; }
-    // Get statistics
-    unsigned int getTotalInstructions() const;
-    unsigned int getTotalCycles() const;
-    double getAverageMemoryAccessTime() const;
-    unsigned int getInvalidationCount() const;
-    unsigned int getBusTrafficBytes() const;
-    // Print results to console
-    void printResults() const;
-};
-
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include "CommandLine.h" // For SimulationConfig
+#include "TraceReader.h"
+#include "Cache.h"
+#include "Processor.h"
+#include "MainMemory.h"
+#include "Statistics.h"
+#include "SnoopFilter.h"
+#include "StatsSink.h"
+#include "BusModel.h"
+#include "Bus.h"
+#include "L2Cache.h"
+#include "SharingProfiler.h"
+#include "TraceScheduler.h"
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <algorithm> // For std::none_of
+
+class Simulator {
+private:
+    // Statistics
+    uint64_t totalInstructions;
+    unsigned int totalCycles;
+    // Parallel mode: transactions applied out of serial order, and by how much
+    uint64_t laggedTransactions = 0;
+    unsigned int maxLag = 0;
+    
+    // Private methods
+    void logStatistics();
+    void handleCacheMissResolution();
+    void initializeComponents(); // Added this declaration
+    void skipIdleCycles();       // Event-driven fast-forward over stalled cycles
+    void advanceCore(int core, unsigned int windowEnd); // Run one core's local accesses
+    void runParkedAccesses();    // Apply the accesses that need the bus, in serial order
+    void noteSnoopLag(int core, int requestingCore);
+    void finishCore(int core, unsigned int cycle); // Trace done: record the cycle, drain misses
+    void sampleStatistics();     // Push the current counters to statsSink
+    void checkCheckpoint();      // Save config.checkpointFile once checkpointAt is reached
+    void setFunctionalWarming(bool enabled);
+    bool takeWarmingTurn(int core);         // Functional warming: may this core execute now?
+    void rescaleWarming();                  // Recompute warmingRate from warmingSpeed
+    std::string checkpointSignature() const; // Settings a checkpoint is only valid for
+    
+protected: // Changed from private to protected for TestSimulator access
+    // Configuration
+    SimulationConfig config;
+    
+    // Main components
+    TraceReader traceReader;
+    MainMemory mainMemory;
+    std::vector<std::unique_ptr<Cache>> caches;
+    std::vector<Cache*> cachePeers;   // Raw view of caches, shared with each Cache
+    std::unique_ptr<SnoopFilter> snoopFilter; // Sharer directory (only with config.snoopFilter)
+    std::vector<std::unique_ptr<Processor>> processors;
+    
+    // Simulation state
+    unsigned int currentCycle;
+    std::unique_ptr<BusModel> bus;    // Bus timing: atomic reservation or split transactions
+    std::unique_ptr<Bus> coherenceBus; // Arbitration and snooping between the caches
+    std::unique_ptr<L2Cache> l2;      // Shared L2 (only with config.l2SetBits)
+    std::unique_ptr<SharingProfiler> sharingProfiler; // Per-block sharing (only with config.sharingTop)
+    std::unique_ptr<TraceScheduler> scheduler; // Time-sliced trace streams (only with config.schedule)
+    std::ofstream logFile;
+    std::vector<unsigned int> finishCycles; // Cycle each core fetched past its last instruction
+    std::unique_ptr<StatsSink> statsSink;   // Per-interval statistics (only with config.statsFile)
+    StatsSink::Sample statsSample;          // Reused for every sample
+    unsigned int nextSampleCycle = 0;
+    bool checkpointPending = false;         // config.checkpointFile not written yet
+    bool functionalWarming = false;         // Sampled run between windows: no bus accounting
+    std::vector<double> warmingSpeed;       // Per core: instructions in the last detailed window
+    std::vector<double> warmingRate;        // ... relative to the fastest unfinished core
+    std::vector<double> warmingCredit;      // ... accumulated, one instruction per whole unit
+    SampledMetric sampledCpi;               // Per measurement window (cycles per instruction)
+    SampledMetric sampledMissRate;
+    uint64_t detailedInstructions = 0;      // Instructions simulated with timing (sampled run)
+    
+    // Parallel mode: one core's own clock. Padded to a cache line since
+    // each is written by a different worker thread.
+    struct alignas(64) CoreClock {
+        unsigned int next = 1;       // Next cycle this core simulates
+        unsigned int lastAccess = 0; // Cycle of its latest executed access (0 = none)
+        bool parked = false;         // Waiting for the serial phase to run parkedAccess
+        Instruction parkedAccess;    // Access that needs a bus transaction
+    };
+    std::vector<CoreClock> coreClocks;    // Empty outside parallel mode
+    unsigned int busCycle = 0;            // Latest cycle any parked access ran at
+    unsigned int transactionLag = 0;      // Lag seen while running the current parked access
+    bool transactionLagged = false;
+    
+    // Protected methods for derived classes
+    virtual bool processNextCycle();
+    
+    // Bounded-lag multi-threaded loop (config.threads > 0); runs to completion
+    void runParallel();
+    
+    // Sampled loop (config.sampleInterval > 0); runs to completion. Between
+    // windows the caches are only functionally warmed; each window simulates
+    // sampleWarmup instructions in detail, then measures the next sampleSize
+    void runSampled();
+    
+    // Check if every trace (or scheduled stream) has been read to its end
+    bool allTracesCompleted() const {
+        return scheduler ? scheduler->allStreamsCompleted() : traceReader.allTracesCompleted();
+    }
+    
+    // Add this method for TestSimulator
+    bool isSimulationComplete() {
+        return allTracesCompleted() && 
+               std::none_of(processors.begin(), processors.end(), 
+                          [](const auto& p) { return p->isBlocked(); });
+    }
+    
+public:
+    // Constructor
+    Simulator(const SimulationConfig& config);
+    
+    // Constructor replaying traces already loaded into memory (shared between simulators)
+    Simulator(const SimulationConfig& config, std::shared_ptr<const SharedTrace> traces);
+    
+    // Destructor
+    ~Simulator();
+    
+    // Run the simulation
+    void run();
+    
+    // Initialize simulation
+    bool initialize();
+    // Expose the current cycle counter
+    unsigned int getCurrentCycle() const { return currentCycle; }
+
+    // Expose the cache and processor arrays
+    const std::vector<std::unique_ptr<Cache>>& getCaches() const { return caches; }
+    const std::vector<std::unique_ptr<Processor>>& getProcessors() const { return processors; }
+
+    // Expose the memory stats
+    const MainMemory& getMainMemory() const { return mainMemory; }
+    // Expose the shared L2 (nullptr when there is none)
+    const L2Cache* getL2() const { return l2.get(); }
+    // Expose the per-block sharing attribution (nullptr unless --sharing-top)
+    const SharingProfiler* getSharingProfiler() const { return sharingProfiler.get(); }
+    // Expose the trace scheduler (nullptr without --schedule)
+    const TraceScheduler* getScheduler() const { return scheduler.get(); }
+    // Expose the bus timing model (and its queueing statistics)
+    const BusModel& getBusModel() const { return *bus; }
+    // Expose the coherence bus (its protocol and transfer statistics)
+    const Bus& getCoherenceBus() const { return *coherenceBus; }
+    // Get statistics
+    uint64_t getTotalInstructions() const;
+    uint64_t executedInstructions() const; // So far, summed over the processors
+    unsigned int getTotalCycles() const;
+    double getAverageMemoryAccessTime() const;
+    uint64_t getInvalidationCount() const;
+    uint64_t getBusTrafficBytes() const;
+    uint64_t getCacheToCacheTransfers() const;
+    unsigned int getFinishCycle(int core) const;
+    uint64_t getLaggedTransactions() const;
+    unsigned int getMaxLag() const;
+    // Sampled run: per-window CPI and miss rate estimates
+    const SampledMetric& getSampledCpi() const { return sampledCpi; }
+    const SampledMetric& getSampledMissRate() const { return sampledMissRate; }
+    uint64_t getDetailedInstructions() const { return detailedInstructions; }
+    
+    // Sum the per-cache counters (computed on demand, not per cycle)
+    CacheStats getCacheTotals() const;
+    // Print results to console
+    void printResults() const;
+    // Write the --miss-profile JSON report (nothing without one; INSTRUMENT builds)
+    void writeMissProfile() const;
+    
+    // Save the complete state: caches, fills in flight, bus, L2, memory,
+    // processors and trace positions (see Checkpoint.h). Not supported with a
+    // prefetcher or in parallel mode; the profilers are not saved.
+    bool saveCheckpoint(const std::string& path) const;
+    // Resume from a checkpoint of the same configuration (after initialize's
+    // component setup); false if it does not match or is damaged
+    bool restoreCheckpoint(const std::string& path);
+};
+
 #endif // SIMULATOR_H
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include "SnoopFilter.h"
+
+// Constructor
+SnoopFilter::SnoopFilter(int numCores)
+    : numCores(numCores) {
+}
+
+// Record whether a core holds a block validly and/or as a stale tag
+void SnoopFilter::update(uint32_t blockAddress, int coreId, bool present, bool stale) {
+    uint64_t bit = uint64_t(1) << coreId;
+
+    auto it = entries.find(blockAddress);
+    if (it == entries.end()) {
+        if (!present && !stale) {
+            return; // Nothing to record
+        }
+        it = entries.emplace(blockAddress, Entry()).first;
+    }
+
+    Entry& entry = it->second;
+    entry.sharers = present ? (entry.sharers | bit) : (entry.sharers & ~bit);
+    entry.stale   = stale   ? (entry.stale | bit)   : (entry.stale & ~bit);
+
+    // Drop blocks no cache holds any more, keeping the table as small as the caches
+    if (entry.sharers == 0 && entry.stale == 0) {
+        entries.erase(it);
+    }
+}
+
+// Cores holding a valid copy of the block
+uint64_t SnoopFilter::getSharers(uint32_t blockAddress) const {
+    auto it = entries.find(blockAddress);
+    return it == entries.end() ? 0 : it->second.sharers;
+}
+
+// Cores holding an invalidated way that still carries the block's tag
+uint64_t SnoopFilter::getStaleHolders(uint32_t blockAddress) const {
+    auto it = entries.find(blockAddress);
+    return it == entries.end() ? 0 : it->second.stale;
+}
+
+// Number of blocks currently tracked
+size_t SnoopFilter::getEntryCount() const {
+    return entries.size();
+}
+
+// Number of cores covered by the bitmasks
+int SnoopFilter::getNumCores() const {
+    return numCores;
+}
@@ -0,0 +1,51 @@
+#ifndef SNOOP_FILTER_H
+#define SNOOP_FILTER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+
+// Sharer-bitmask directory keyed by block address.
+//
+// Caches report every change to which blocks they hold, so the bus can
+// ask "which cores have this block" in O(1) and snoop only those cores
+// instead of probing every cache.
+//
+// Besides valid copies, the filter also tracks "stale" holders: caches
+// with an INVALID way that still carries the block's tag (for example
+// after a BUS_RDX invalidation). Cache::write uses these on a write miss
+// to pick a cache-to-cache source.
+class SnoopFilter {
+public:
+    // Bitmasks hold one bit per core
+    static const int MAX_CORES = 64;
+
+    // Constructor
+    explicit SnoopFilter(int numCores);
+
+    // Record whether a core holds a block validly and/or as a stale tag
+    void update(uint32_t blockAddress, int coreId, bool present, bool stale);
+
+    // Cores holding a valid copy of the block (bit i = core i)
+    uint64_t getSharers(uint32_t blockAddress) const;
+
+    // Cores holding an invalidated way that still carries the block's tag
+    uint64_t getStaleHolders(uint32_t blockAddress) const;
+
+    // Number of blocks currently tracked
+    size_t getEntryCount() const;
+
+    // Number of cores covered by the bitmasks
+    int getNumCores() const;
+
+private:
+    struct Entry {
+        uint64_t sharers = 0;
+        uint64_t stale = 0;
+    };
+
+    int numCores;
+    std::unordered_map<uint32_t, Entry> entries;  // Only blocks some cache holds
+};
+
+#endif // SNOOP_FILTER_H
@@ -0,0 +1,73 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded lock-free single-producer/single-consumer ring buffer.
+//
+// Slots are filled and drained in place: the producer writes into
+// reserve() and publishes it with push(); the consumer reads front()
+// and hands the slot back with pop(). Exactly one thread may act as
+// producer and one as consumer at a time.
+template <typename T>
+class SpscQueue {
+public:
+    // Constructor - capacity is rounded up to a power of two
+    explicit SpscQueue(size_t capacity)
+        : head(0), tail(0), cachedHead(0), cachedTail(0) {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    // Producer: slot to fill next, or nullptr if the ring is full
+    T* reserve() {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cachedHead > mask) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t - cachedHead > mask) return nullptr;
+        }
+        return &slots[t & mask];
+    }
+
+    // Producer: publish the slot returned by reserve()
+    void push() {
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Consumer: oldest published slot, or nullptr if the ring is empty
+    T* front() {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h == cachedTail) return nullptr;
+        }
+        return &slots[h & mask];
+    }
+
+    // Consumer: release the slot returned by front()
+    void pop() {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Drop all entries (only while neither side is running)
+    void clear() {
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+        cachedHead = 0;
+        cachedTail = 0;
+    }
+
+private:
+    std::vector<T> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head;  // Next slot to consume (written by the consumer)
+    alignas(64) std::atomic<size_t> tail;  // Next slot to fill (written by the producer)
+    alignas(64) size_t cachedHead;         // Producer's last view of head
+    alignas(64) size_t cachedTail;         // Consumer's last view of tail
+};
+
+#endif // SPSC_QUEUE_H
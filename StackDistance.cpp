@@ -0,0 +1,87 @@
+#include "StackDistance.h"
+#include "Address.h"
+
+// Constructor - all set stacks start empty
+StackDistanceAnalyzer::StackDistanceAnalyzer(int setBits, int blockBits, int maxWays)
+    : setBits(setBits), blockBits(blockBits), maxWays(maxWays), accessCount(0) {
+    size_t numSets = size_t(1) << setBits;
+    stacks.resize(numSets * maxWays, 0);
+    depths.resize(numSets, 0);
+    distanceCounts.resize(maxWays, 0);
+}
+
+// Record one access: find its depth, then move it to the top of its set stack
+void StackDistanceAnalyzer::access(uint32_t address) {
+    Address addr(address, setBits, blockBits);
+    uint32_t setIndex = addr.getIndex();
+    uint32_t tag      = addr.getTag();
+
+    uint32_t* stack = &stacks[size_t(setIndex) * maxWays];
+    uint32_t depth  = depths[setIndex];
+    accessCount++;
+
+    // Locate the block; a block deeper than maxWays has already been dropped
+    uint32_t found = depth;
+    for (uint32_t d = 0; d < depth; d++) {
+        if (stack[d] == tag) {
+            found = d;
+            break;
+        }
+    }
+
+    if (found < depth) {
+        distanceCounts[found]++;
+    } else if (depth < static_cast<uint32_t>(maxWays)) {
+        // Miss with room left: the stack grows by one
+        found = depth;
+        depths[setIndex] = depth + 1;
+    } else {
+        // Miss on a full stack: the least recent entry falls off
+        found = depth - 1;
+    }
+
+    // Shift the more recent entries down one slot and put the block on top
+    for (uint32_t d = found; d > 0; d--) {
+        stack[d] = stack[d - 1];
+    }
+    stack[0] = tag;
+}
+
+// Feed every remaining instruction of one core's trace
+void StackDistanceAnalyzer::consumeTrace(TraceReader& reader, int coreId) {
+    while (reader.hasMoreInstructions(coreId)) {
+        Instruction inst = reader.getNextInstruction(coreId);
+        if (inst.isValid()) {
+            access(inst.address);
+        }
+    }
+}
+
+// Number of accesses seen so far
+uint64_t StackDistanceAnalyzer::getAccessCount() const {
+    return accessCount;
+}
+
+// Misses = accesses that did not hit within the top `associativity` entries
+uint64_t StackDistanceAnalyzer::getMissCount(int associativity) const {
+    uint64_t hits = 0;
+    for (int d = 0; d < associativity && d < maxWays; d++) {
+        hits += distanceCounts[d];
+    }
+    return accessCount - hits;
+}
+
+// Miss ratio of an LRU cache with the given associativity
+double StackDistanceAnalyzer::getMissRate(int associativity) const {
+    return accessCount ? double(getMissCount(associativity)) / accessCount : 0.0;
+}
+
+// Accesses that hit at exactly the given stack depth
+uint64_t StackDistanceAnalyzer::getDistanceCount(int depth) const {
+    return (depth >= 0 && depth < maxWays) ? distanceCounts[depth] : 0;
+}
+
+// Largest associativity covered by this analysis
+int StackDistanceAnalyzer::getMaxWays() const {
+    return maxWays;
+}
@@ -0,0 +1,50 @@
+#ifndef STACK_DISTANCE_H
+#define STACK_DISTANCE_H
+
+#include <cstdint>
+#include <vector>
+#include "TraceReader.h"
+
+// Single-pass LRU stack-distance (Mattson) analysis for one address stream.
+//
+// Each set keeps its blocks in recency order, truncated at maxWays entries.
+// An access whose block is found at depth d (0 = most recent) hits in every
+// LRU cache with the same set count and associativity E > d, so one pass
+// yields the miss count of every associativity 1..maxWays at once.
+class StackDistanceAnalyzer {
+public:
+    // Constructor - fixed set count 2^setBits, block size 2^blockBits
+    StackDistanceAnalyzer(int setBits, int blockBits, int maxWays);
+
+    // Record one access (reads and writes behave alike under write-allocate LRU)
+    void access(uint32_t address);
+
+    // Feed every remaining instruction of one core's trace
+    void consumeTrace(TraceReader& reader, int coreId);
+
+    // Number of accesses seen so far
+    uint64_t getAccessCount() const;
+
+    // Misses of an LRU cache with the given associativity (1..maxWays)
+    uint64_t getMissCount(int associativity) const;
+
+    // Miss ratio of an LRU cache with the given associativity
+    double getMissRate(int associativity) const;
+
+    // Accesses that hit at exactly the given stack depth (0-based)
+    uint64_t getDistanceCount(int depth) const;
+
+    // Largest associativity covered by this analysis
+    int getMaxWays() const;
+
+private:
+    int setBits;
+    int blockBits;
+    int maxWays;
+    std::vector<uint32_t> stacks;       // numSets * maxWays tags, most recent first
+    std::vector<uint32_t> depths;       // Valid entries per set stack
+    std::vector<uint64_t> distanceCounts; // Hits at each stack depth
+    uint64_t accessCount;
+};
+
+#endif // STACK_DISTANCE_H
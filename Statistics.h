@@ -0,0 +1,131 @@
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <cstdint>
+#include <cmath>
+
+// Event counters kept by each cache.
+// Caches only ever increment their own counters on the access path; the
+// simulator sums them across caches when it needs totals (log points and
+// the final report), so nothing is accumulated per cycle.
+struct CacheStats {
+    uint64_t accesses   = 0;  // Reads + writes issued to the cache
+    uint64_t hits       = 0;  // Accesses satisfied without a fill
+    uint64_t misses     = 0;  // Accesses that started a fill
+    uint64_t reads      = 0;  // Read accesses
+    uint64_t writes     = 0;  // Write accesses
+    uint64_t coherence  = 0;  // Bus transactions issued by this cache
+    uint64_t evictions  = 0;  // Valid lines replaced on a fill
+    uint64_t writebacks = 0;  // Dirty lines written back on eviction
+    uint64_t mshrMerges = 0;  // Misses merged into an MSHR already fetching the block
+    uint64_t mshrFull   = 0;  // Accesses refused (and retried) because every MSHR was busy
+    uint64_t writebackStall = 0;  // Cycles misses waited for their victim's writeback
+    uint64_t wbSnoopHits = 0; // Peer transactions served from the write-back buffer
+    uint64_t wbRefills  = 0;  // Own misses to a block still in the write-back buffer
+    uint64_t wbFull     = 0;  // Dirty evictions that found the write-back buffer full
+
+    // Accumulate another cache's counters
+    CacheStats& operator+=(const CacheStats& other) {
+        accesses   += other.accesses;
+        hits       += other.hits;
+        misses     += other.misses;
+        reads      += other.reads;
+        writes     += other.writes;
+        coherence  += other.coherence;
+        evictions  += other.evictions;
+        writebacks += other.writebacks;
+        mshrMerges += other.mshrMerges;
+        mshrFull   += other.mshrFull;
+        writebackStall += other.writebackStall;
+        wbSnoopHits += other.wbSnoopHits;
+        wbRefills  += other.wbRefills;
+        wbFull     += other.wbFull;
+        return *this;
+    }
+
+    // Counters accumulated since an earlier snapshot
+    CacheStats operator-(const CacheStats& earlier) const {
+        CacheStats delta;
+        delta.accesses   = accesses   - earlier.accesses;
+        delta.hits       = hits       - earlier.hits;
+        delta.misses     = misses     - earlier.misses;
+        delta.reads      = reads      - earlier.reads;
+        delta.writes     = writes     - earlier.writes;
+        delta.coherence  = coherence  - earlier.coherence;
+        delta.evictions  = evictions  - earlier.evictions;
+        delta.writebacks = writebacks - earlier.writebacks;
+        delta.mshrMerges = mshrMerges - earlier.mshrMerges;
+        delta.mshrFull   = mshrFull   - earlier.mshrFull;
+        delta.writebackStall = writebackStall - earlier.writebackStall;
+        delta.wbSnoopHits = wbSnoopHits - earlier.wbSnoopHits;
+        delta.wbRefills  = wbRefills  - earlier.wbRefills;
+        delta.wbFull     = wbFull     - earlier.wbFull;
+        return delta;
+    }
+
+    // Hit and miss ratios in [0, 1]; 0 when there were no accesses
+    double hitRate() const  { return accesses ? double(hits) / accesses : 0.0; }
+    double missRate() const { return accesses ? double(misses) / accesses : 0.0; }
+};
+
+// Prefetch outcome counters kept by each cache that has a prefetcher
+struct PrefetchStats {
+    uint64_t issued    = 0;  // Blocks fetched ahead of demand
+    uint64_t useful    = 0;  // Prefetched blocks later touched by a demand access
+    uint64_t late      = 0;  // Useful prefetches the demand access had to wait for
+    uint64_t polluting = 0;  // Prefetched blocks evicted or invalidated untouched
+
+    // Accumulate another cache's counters
+    PrefetchStats& operator+=(const PrefetchStats& other) {
+        issued    += other.issued;
+        useful    += other.useful;
+        late      += other.late;
+        polluting += other.polluting;
+        return *this;
+    }
+};
+
+// Counters of the shared L2
+struct L2Stats {
+    uint64_t accesses   = 0;  // L1 fills and writebacks that looked the L2 up
+    uint64_t hits       = 0;  // Lookups that found the block
+    uint64_t misses     = 0;  // Lookups that went on to memory
+    uint64_t evictions  = 0;  // Valid L2 blocks replaced
+    uint64_t writebacks = 0;  // Dirty L2 blocks written to memory on eviction
+    uint64_t backInvalidations = 0; // L1 copies dropped to keep the L2 inclusive
+    uint64_t filteredSnoops = 0;    // Bus transactions no L1 was snooped for (inclusive misses)
+
+    double missRate() const { return accesses ? double(misses) / accesses : 0.0; }
+};
+
+// One metric measured over the windows of a sampled run: its mean and the
+// confidence interval of the mean (normal approximation, as in SMARTS)
+struct SampledMetric {
+    uint64_t count      = 0;    // Windows measured
+    double   sum        = 0.0;
+    double   sumSquares = 0.0;
+
+    void add(double value) {
+        count++;
+        sum += value;
+        sumSquares += value * value;
+    }
+
+    double mean() const { return count ? sum / count : 0.0; }
+
+    // Sample standard deviation (0 below two windows)
+    double stddev() const {
+        if (count < 2) return 0.0;
+        double m = mean();
+        double variance = (sumSquares - count * m * m) / (count - 1);
+        return variance > 0.0 ? std::sqrt(variance) : 0.0;
+    }
+
+    // Coefficient of variation (stddev / mean)
+    double variation() const { return mean() != 0.0 ? stddev() / mean() : 0.0; }
+
+    // Half-width of the interval mean +/- z standard errors
+    double halfWidth(double z) const { return count ? z * stddev() / std::sqrt(double(count)) : 0.0; }
+};
+
+#endif // STATISTICS_H
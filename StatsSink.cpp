@@ -0,0 +1,203 @@
+#include "StatsSink.h"
+#include <iostream>
+
+// Chunks in flight: one being filled, one being written, one spare
+static const size_t POOL_CHUNKS = 3;
+
+// Constructor
+StatsSink::StatsSink(int numCores, unsigned int interval, size_t chunkRows)
+    : numCores(numCores), interval(interval), capacity(chunkRows), format(Format::BINARY),
+      sampleCount(0), active(nullptr), stopping(false) {
+    previous.hits.assign(numCores, 0);
+    previous.misses.assign(numCores, 0);
+    previous.stalls.assign(numCores, 0);
+
+    pool.resize(POOL_CHUNKS);
+    for (auto& chunk : pool) {
+        allocate(chunk);
+    }
+}
+
+// Destructor
+StatsSink::~StatsSink() {
+    close();
+}
+
+// Parse "binary" or "csv"
+bool StatsSink::parseFormat(const std::string& name, Format& result) {
+    if (name == "binary") { result = Format::BINARY; return true; }
+    if (name == "csv")    { result = Format::CSV;    return true; }
+    return false;
+}
+
+// Size every column of a chunk for `capacity` rows
+void StatsSink::allocate(Chunk& chunk) const {
+    chunk.rows = 0;
+    chunk.cycle.resize(capacity);
+    chunk.hits.resize(capacity * numCores);
+    chunk.misses.resize(capacity * numCores);
+    chunk.stalls.resize(capacity * numCores);
+    chunk.states.resize(capacity * numCores);
+    chunk.invalidations.resize(capacity);
+    chunk.busBytes.resize(capacity);
+}
+
+// Create the output file and start the writer thread
+bool StatsSink::open(const std::string& path, Format fileFormat) {
+    format = fileFormat;
+    out.open(path, format == Format::BINARY ? std::ios::binary | std::ios::trunc : std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Warning: Could not open statistics file: " << path << std::endl;
+        return false;
+    }
+
+    if (format == Format::BINARY) {
+        uint32_t magic = MAGIC;
+        uint16_t version = VERSION;
+        uint16_t cores = static_cast<uint16_t>(numCores);
+        out.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+        out.write(reinterpret_cast<const char*>(&version), sizeof(version));
+        out.write(reinterpret_cast<const char*>(&cores), sizeof(cores));
+        out.write(reinterpret_cast<const char*>(&interval), sizeof(interval));
+    } else {
+        out << "Cycle";
+        for (int c = 0; c < numCores; c++) {
+            out << ",P" << c << "Hits,P" << c << "Misses,P" << c << "Stalls,P" << c << "State";
+        }
+        out << ",Invalidations,BusBytes\n";
+    }
+
+    active = &pool[0];
+    for (size_t i = 1; i < pool.size(); i++) {
+        freeChunks.push_back(&pool[i]);
+    }
+    writer = std::thread(&StatsSink::writerLoop, this);
+    return true;
+}
+
+// Append one sample
+void StatsSink::record(const Sample& sample) {
+    if (!active) return;
+
+    Chunk& chunk = *active;
+    size_t row = chunk.rows;
+    chunk.cycle[row] = sample.cycle;
+    for (int c = 0; c < numCores; c++) {
+        size_t slot = c * capacity + row;
+        chunk.hits[slot]   = sample.hits[c] - previous.hits[c];
+        chunk.misses[slot] = sample.misses[c] - previous.misses[c];
+        chunk.stalls[slot] = sample.stalls[c] - previous.stalls[c];
+        chunk.states[slot] = sample.states[c];
+    }
+    chunk.invalidations[row] = sample.invalidations - previous.invalidations;
+    chunk.busBytes[row] = sample.busBytes - previous.busBytes;
+
+    previous.hits = sample.hits;
+    previous.misses = sample.misses;
+    previous.stalls = sample.stalls;
+    previous.invalidations = sample.invalidations;
+    previous.busBytes = sample.busBytes;
+    sampleCount++;
+
+    if (++chunk.rows == capacity) {
+        submit();
+    }
+}
+
+// Hand the active chunk to the writer and take a free one (waits if the writer is behind)
+void StatsSink::submit() {
+    std::unique_lock<std::mutex> lock(mutex);
+    fullChunks.push_back(active);
+    changed.notify_all();
+    changed.wait(lock, [this] { return !freeChunks.empty(); });
+    active = freeChunks.front();
+    freeChunks.pop_front();
+    active->rows = 0;
+}
+
+// Write out buffered samples and wait for the writer to finish
+void StatsSink::close() {
+    if (!writer.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (active->rows > 0) {
+            fullChunks.push_back(active);
+        }
+        active = nullptr;
+        stopping = true;
+    }
+    changed.notify_all();
+    writer.join();
+    out.close();
+}
+
+// Body of the writer thread
+void StatsSink::writerLoop() {
+    while (true) {
+        Chunk* chunk = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [this] { return stopping || !fullChunks.empty(); });
+            if (fullChunks.empty()) return; // Stopping with nothing left
+            chunk = fullChunks.front();
+            fullChunks.pop_front();
+        }
+
+        if (format == Format::BINARY) {
+            writeBinary(*chunk);
+        } else {
+            writeCsv(*chunk);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            freeChunks.push_back(chunk);
+        }
+        changed.notify_all();
+    }
+}
+
+// Write one chunk column by column
+void StatsSink::writeBinary(const Chunk& chunk) {
+    uint32_t rows = static_cast<uint32_t>(chunk.rows);
+    out.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+
+    auto column = [&](const uint64_t* values) {
+        out.write(reinterpret_cast<const char*>(values), rows * sizeof(uint64_t));
+    };
+    column(chunk.cycle.data());
+    for (int c = 0; c < numCores; c++) {
+        column(&chunk.hits[c * capacity]);
+        column(&chunk.misses[c * capacity]);
+        column(&chunk.stalls[c * capacity]);
+    }
+    for (int c = 0; c < numCores; c++) {
+        out.write(reinterpret_cast<const char*>(&chunk.states[c * capacity]), rows);
+    }
+    column(chunk.invalidations.data());
+    column(chunk.busBytes.data());
+}
+
+// Write one chunk as CSV rows
+void StatsSink::writeCsv(const Chunk& chunk) {
+    static const char STATE_LETTERS[] = { 'A', 'B', 'C' };
+    for (size_t row = 0; row < chunk.rows; row++) {
+        out << chunk.cycle[row];
+        for (int c = 0; c < numCores; c++) {
+            size_t slot = c * capacity + row;
+            out << ',' << chunk.hits[slot] << ',' << chunk.misses[slot] << ','
+                << chunk.stalls[slot] << ',' << STATE_LETTERS[chunk.states[slot]];
+        }
+        out << ',' << chunk.invalidations[row] << ',' << chunk.busBytes[row] << '\n';
+    }
+}
+
+// Sampling interval in cycles
+unsigned int StatsSink::getInterval() const {
+    return interval;
+}
+
+// Samples recorded so far
+uint64_t StatsSink::getSampleCount() const {
+    return sampleCount;
+}
@@ -0,0 +1,113 @@
+#ifndef STATS_SINK_H
+#define STATS_SINK_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Per-interval statistics stream.
+//
+// The simulator hands in cumulative counters at every sample point; the sink
+// stores the per-interval deltas in a preallocated columnar chunk and, once
+// the chunk is full, passes it to a writer thread, so no formatting or I/O
+// happens on the simulation thread.
+//
+// Binary layout (.l1stats, all little-endian):
+//   header : uint32 magic "L1ST", uint16 version, uint16 numCores, uint32 interval
+//   chunks : uint32 rows, then each column's `rows` values back to back:
+//            cycle, per core {hits, misses, stall cycles} (uint64),
+//            per core state (uint8: 0 active, 1 blocked, 2 complete),
+//            invalidations, bus bytes (uint64)
+class StatsSink {
+public:
+    enum class Format { BINARY, CSV };
+
+    // Header constants of the binary format
+    static const uint32_t MAGIC = 0x5453314C; // "L1ST"
+    static const uint16_t VERSION = 1;
+
+    // Core states recorded per sample
+    static const uint8_t STATE_ACTIVE = 0;
+    static const uint8_t STATE_BLOCKED = 1;
+    static const uint8_t STATE_COMPLETE = 2;
+
+    // One sample's cumulative counters, filled by the simulator
+    struct Sample {
+        uint64_t cycle = 0;
+        std::vector<uint64_t> hits;     // Per core
+        std::vector<uint64_t> misses;   // Per core
+        std::vector<uint64_t> stalls;   // Per core
+        std::vector<uint8_t> states;    // Per core
+        uint64_t invalidations = 0;
+        uint64_t busBytes = 0;
+    };
+
+    // Constructor - `chunkRows` samples are buffered before each write
+    StatsSink(int numCores, unsigned int interval, size_t chunkRows = 4096);
+
+    // Destructor - flushes and stops the writer
+    ~StatsSink();
+
+    // Parse "binary" or "csv"; returns false for anything else
+    static bool parseFormat(const std::string& name, Format& format);
+
+    // Create the output file and start the writer thread
+    bool open(const std::string& path, Format format);
+
+    // Append one sample (stored as deltas against the previous one)
+    void record(const Sample& sample);
+
+    // Write out buffered samples and wait for the writer to finish
+    void close();
+
+    // Sampling interval in cycles
+    unsigned int getInterval() const;
+
+    // Samples recorded so far
+    uint64_t getSampleCount() const;
+
+private:
+    // A block of samples stored column by column
+    struct Chunk {
+        size_t rows = 0;
+        std::vector<uint64_t> cycle;
+        std::vector<uint64_t> hits;        // [core * capacity + row]
+        std::vector<uint64_t> misses;
+        std::vector<uint64_t> stalls;
+        std::vector<uint8_t> states;
+        std::vector<uint64_t> invalidations;
+        std::vector<uint64_t> busBytes;
+    };
+
+    void allocate(Chunk& chunk) const;
+    void submit();                       // Hand the active chunk to the writer
+    void writerLoop();                   // Body of the writer thread
+    void writeBinary(const Chunk& chunk);
+    void writeCsv(const Chunk& chunk);
+
+    int numCores;
+    unsigned int interval;
+    size_t capacity;                     // Rows per chunk
+    Format format;
+    std::ofstream out;
+    uint64_t sampleCount;
+
+    Sample previous;                     // Last cumulative values, for deltas
+    Chunk* active;                       // Chunk being filled (owned by pool)
+    std::vector<Chunk> pool;             // All chunks, allocated once
+
+    // Hand-off between the simulation thread and the writer
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<Chunk*> fullChunks;       // Waiting to be written
+    std::deque<Chunk*> freeChunks;       // Ready to be filled
+    bool stopping;
+    std::thread writer;
+};
+
+#endif // STATS_SINK_H
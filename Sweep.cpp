@@ -0,0 +1,137 @@
+#include "Sweep.h"
+#include "Simulator.h"
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <thread>
+
+// Constructor
+SweepRunner::SweepRunner(const SimulationConfig& baseConfig,
+                         std::shared_ptr<const SharedTrace> traces,
+                         unsigned int numThreads)
+    : baseConfig(baseConfig), traces(std::move(traces)),
+      numThreads(numThreads == 0 ? 1 : numThreads) {
+    // Per-point simulators never write the cycle log
+    this->baseConfig.outputFile.clear();
+}
+
+// Simulate every point on the thread pool
+std::vector<SweepResult> SweepRunner::run(const std::vector<SweepPoint>& points) const {
+    std::vector<SweepResult> results(points.size());
+    std::atomic<size_t> nextPoint(0);
+
+    // Each worker claims the next unsimulated point until none are left
+    auto worker = [&]() {
+        for (size_t i = nextPoint++; i < points.size(); i = nextPoint++) {
+            results[i] = runPoint(points[i]);
+        }
+    };
+
+    unsigned int threadCount = std::min<size_t>(numThreads, points.size());
+    std::vector<std::thread> pool;
+    pool.reserve(threadCount);
+    for (unsigned int t = 0; t < threadCount; ++t) {
+        pool.emplace_back(worker);
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    return results;
+}
+
+// Run one independent simulation
+SweepResult SweepRunner::runPoint(const SweepPoint& point) const {
+    SweepResult result = {};
+    result.point = point;
+
+    SimulationConfig config = baseConfig;
+    config.setBits = point.setBits;
+    config.associativity = point.associativity;
+    config.blockBits = point.blockBits;
+
+    auto start = std::chrono::steady_clock::now();
+
+    Simulator sim(config, traces);
+    result.ok = sim.initialize();
+    if (result.ok) {
+        sim.run();
+
+        CacheStats totals = sim.getCacheTotals();
+        result.cycles = sim.getTotalCycles();
+        result.instructions = sim.getTotalInstructions();
+        result.accesses = totals.accesses;
+        result.hits = totals.hits;
+        result.misses = totals.misses;
+        result.evictions = totals.evictions;
+        result.writebacks = totals.writebacks;
+        result.invalidations = sim.getInvalidationCount();
+        result.busTrafficBytes = sim.getBusTrafficBytes();
+        result.cacheToCache = sim.getCacheToCacheTransfers();
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+// Cartesian product of the parameter lists
+std::vector<SweepPoint> SweepRunner::buildGrid(const std::vector<int>& setBits,
+                                               const std::vector<int>& associativities,
+                                               const std::vector<int>& blockBits) {
+    std::vector<SweepPoint> points;
+    points.reserve(setBits.size() * associativities.size() * blockBits.size());
+    for (int s : setBits) {
+        for (int E : associativities) {
+            for (int b : blockBits) {
+                points.push_back({s, E, b});
+            }
+        }
+    }
+    return points;
+}
+
+// Miss ratio of one result in [0, 1]
+static double missRate(const SweepResult& r) {
+    return r.accesses ? double(r.misses) / r.accesses : 0.0;
+}
+
+// One CSV row per configuration
+void SweepRunner::writeCsv(std::ostream& out, const std::vector<SweepResult>& results) {
+    out << "s,E,b,ok,cycles,instructions,accesses,hits,misses,miss_rate,"
+           "evictions,writebacks,invalidations,bus_traffic_bytes,cache_to_cache,seconds\n";
+    for (const auto& r : results) {
+        out << r.point.setBits << "," << r.point.associativity << "," << r.point.blockBits << ","
+            << (r.ok ? 1 : 0) << "," << r.cycles << "," << r.instructions << ","
+            << r.accesses << "," << r.hits << "," << r.misses << ","
+            << std::fixed << std::setprecision(6) << missRate(r) << ","
+            << r.evictions << "," << r.writebacks << "," << r.invalidations << ","
+            << r.busTrafficBytes << "," << r.cacheToCache << ","
+            << std::setprecision(3) << r.seconds << "\n";
+    }
+}
+
+// One JSON object per configuration, as an array
+void SweepRunner::writeJson(std::ostream& out, const std::vector<SweepResult>& results) {
+    out << "[\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        out << "  {\"s\": " << r.point.setBits
+            << ", \"E\": " << r.point.associativity
+            << ", \"b\": " << r.point.blockBits
+            << ", \"ok\": " << (r.ok ? "true" : "false")
+            << ", \"cycles\": " << r.cycles
+            << ", \"instructions\": " << r.instructions
+            << ", \"accesses\": " << r.accesses
+            << ", \"hits\": " << r.hits
+            << ", \"misses\": " << r.misses
+            << ", \"miss_rate\": " << std::fixed << std::setprecision(6) << missRate(r)
+            << ", \"evictions\": " << r.evictions
+            << ", \"writebacks\": " << r.writebacks
+            << ", \"invalidations\": " << r.invalidations
+            << ", \"bus_traffic_bytes\": " << r.busTrafficBytes
+            << ", \"cache_to_cache\": " << r.cacheToCache
+            << ", \"seconds\": " << std::setprecision(3) << r.seconds
+            << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+}
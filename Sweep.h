@@ -0,0 +1,64 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "CommandLine.h"
+#include "TraceReader.h"
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// One cache geometry in a parameter sweep
+struct SweepPoint {
+    int setBits;        // s
+    int associativity;  // E
+    int blockBits;      // b
+};
+
+// Aggregate results of simulating one SweepPoint
+struct SweepResult {
+    SweepPoint point;
+    bool ok;                       // False if the simulator failed to initialize
+    unsigned int cycles;           // Total simulated cycles
+    uint64_t instructions;
+    uint64_t accesses;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t writebacks;
+    uint64_t invalidations;
+    uint64_t busTrafficBytes;
+    uint64_t cacheToCache;
+    double seconds;                // Wall-clock time of this point
+};
+
+// Runs independent Simulator instances for a grid of geometries on a thread pool.
+// All simulators replay the same SharedTrace, so traces are decoded only once.
+class SweepRunner {
+public:
+    SweepRunner(const SimulationConfig& baseConfig,
+                std::shared_ptr<const SharedTrace> traces,
+                unsigned int numThreads);
+
+    // Simulate every point; results are returned in the order of `points`
+    std::vector<SweepResult> run(const std::vector<SweepPoint>& points) const;
+
+    // Cartesian product of the three parameter lists (s outermost, b innermost)
+    static std::vector<SweepPoint> buildGrid(const std::vector<int>& setBits,
+                                             const std::vector<int>& associativities,
+                                             const std::vector<int>& blockBits);
+
+    // Emit one row/object per configuration
+    static void writeCsv(std::ostream& out, const std::vector<SweepResult>& results);
+    static void writeJson(std::ostream& out, const std::vector<SweepResult>& results);
+
+private:
+    SweepResult runPoint(const SweepPoint& point) const;
+
+    SimulationConfig baseConfig;
+    std::shared_ptr<const SharedTrace> traces;
+    unsigned int numThreads;
+};
+
+#endif // SWEEP_H
@@ -0,0 +1,266 @@
+#include "Sweep.h"
+#include "TraceReader.h"
+#include "SnoopFilter.h"
+#include "ReplacementPolicy.h"
+#include "Prefetcher.h"
+#include "BusModel.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <getopt.h>
+
+// Codes for options that only have a long form
+enum LongOption {
+    OPT_EVENT_DRIVEN = 256,
+    OPT_TAG_ONLY,
+    OPT_SNOOP_FILTER,
+    OPT_REPLACEMENT,
+    OPT_PREFETCH,
+    OPT_PREFETCH_DEGREE,
+    OPT_MSHRS,
+    OPT_BUS,
+    OPT_MEM_BANKS,
+    OPT_WB_BUFFER,
+    OPT_L2_SETS,
+    OPT_L2_WAYS,
+    OPT_L2_BLOCK,
+    OPT_L2_LATENCY,
+    OPT_L2_NON_INCLUSIVE
+};
+
+// Sweep-specific command line
+struct SweepOptions {
+    SimulationConfig base;              // Shared (non-geometry) simulator settings
+    std::vector<int> setBits;
+    std::vector<int> associativities;
+    std::vector<int> blockBits;
+    unsigned int threads = std::thread::hardware_concurrency();
+    std::string format = "csv";
+    std::string outputFile;
+    bool valid = true;
+};
+
+// Parse "4,5,6", "4-8" or a mix such as "1,2,4-6" into a list of integers
+static bool parseIntList(const std::string& text, std::vector<int>& values) {
+    values.clear();
+    size_t pos = 0;
+    while (pos <= text.size()) {
+        size_t comma = text.find(',', pos);
+        std::string item = text.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        try {
+            size_t dash = item.find('-', 1);
+            if (dash == std::string::npos) {
+                values.push_back(std::stoi(item));
+            } else {
+                int first = std::stoi(item.substr(0, dash));
+                int last = std::stoi(item.substr(dash + 1));
+                for (int v = first; v <= last; ++v) {
+                    values.push_back(v);
+                }
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+        if (comma == std::string::npos) break;
+        pos = comma + 1;
+    }
+    return !values.empty();
+}
+
+// Print help message
+static void printHelp(const char* programName) {
+    std::cout << "Usage: " << programName << " -t <app> -s <list> -E <list> -b <list> [OPTIONS]\n";
+    std::cout << "Simulate every combination of cache parameters concurrently.\n\n";
+    std::cout << "Lists are comma-separated values and/or ranges, e.g. -s 4-8 -E 1,2,4,8.\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  -t <n>    : Name of parallel application (e.g. app1) whose traces (one per core) are to be used in simulation\n";
+    std::cout << "  -s <list> : Set index bits to sweep\n";
+    std::cout << "  -E <list> : Associativities to sweep\n";
+    std::cout << "  -b <list> : Block bits to sweep\n";
+    std::cout << "  -n <n>    : Number of cores per simulated system (default: 4)\n";
+    std::cout << "  -j <n>    : Worker threads (default: hardware concurrency)\n";
+    std::cout << "  -f <fmt>  : Output format, csv (default) or json\n";
+    std::cout << "  -o <file> : Write results to file instead of stdout\n";
+    std::cout << "  -h        : Prints this help\n";
+    std::cout << "  --event-driven : Run each point with the event-driven loop\n";
+    std::cout << "  --tag-only     : Run each point without data payloads\n";
+    std::cout << "  --snoop-filter : Run each point with the sharer directory\n";
+    std::cout << "  --replacement <p> : Victim policy for every point (lru, true-lru, plru, srrip, brrip, random)\n";
+    std::cout << "  --prefetch <p>    : L1 prefetcher for every point (none, next-line, stride, stream)\n";
+    std::cout << "  --prefetch-degree <n> : Blocks fetched ahead per prefetcher trigger (default: 2)\n";
+    std::cout << "  --mshrs <n>       : Outstanding misses per cache for every point (default: 1)\n";
+    std::cout << "  --bus <model>     : Bus timing for every point, atomic (default) or split\n";
+    std::cout << "  --mem-banks <n>   : Memory banks behind a split bus (default: 8)\n";
+    std::cout << "  --wb-buffer <n>   : Write-back buffer entries per cache for every point (default: 0)\n";
+    std::cout << "  --l2-sets, --l2-ways, --l2-block, --l2-latency, --l2-non-inclusive : Shared L2 for every point (see L1simulate -h)\n";
+}
+
+// Parse command line arguments
+static SweepOptions parseArguments(int argc, char* argv[]) {
+    SweepOptions options;
+    int opt;
+    const char* optString = "ht:s:E:b:j:f:o:n:";
+    static const struct option longOptions[] = {
+        {"help",         no_argument, nullptr, 'h'},
+        {"event-driven", no_argument, nullptr, OPT_EVENT_DRIVEN},
+        {"tag-only",     no_argument, nullptr, OPT_TAG_ONLY},
+        {"snoop-filter", no_argument, nullptr, OPT_SNOOP_FILTER},
+        {"replacement",  required_argument, nullptr, OPT_REPLACEMENT},
+        {"prefetch",     required_argument, nullptr, OPT_PREFETCH},
+        {"prefetch-degree", required_argument, nullptr, OPT_PREFETCH_DEGREE},
+        {"mshrs",        required_argument, nullptr, OPT_MSHRS},
+        {"bus",          required_argument, nullptr, OPT_BUS},
+        {"mem-banks",    required_argument, nullptr, OPT_MEM_BANKS},
+        {"wb-buffer",    required_argument, nullptr, OPT_WB_BUFFER},
+        {"l2-sets",      required_argument, nullptr, OPT_L2_SETS},
+        {"l2-ways",      required_argument, nullptr, OPT_L2_WAYS},
+        {"l2-block",     required_argument, nullptr, OPT_L2_BLOCK},
+        {"l2-latency",   required_argument, nullptr, OPT_L2_LATENCY},
+        {"l2-non-inclusive", no_argument,   nullptr, OPT_L2_NON_INCLUSIVE},
+        {nullptr,        0,           nullptr, 0}
+    };
+    while ((opt = getopt_long(argc, argv, optString, longOptions, nullptr)) != -1) {
+        switch (opt) {
+            case 'h': options.base.helpRequested = true; break;
+            case 't': options.base.appName = optarg; break;
+            case 's': options.valid &= parseIntList(optarg, options.setBits); break;
+            case 'E': options.valid &= parseIntList(optarg, options.associativities); break;
+            case 'b': options.valid &= parseIntList(optarg, options.blockBits); break;
+            case 'j': options.threads = std::stoi(optarg); break;
+            case 'f': options.format = optarg; break;
+            case 'o': options.outputFile = optarg; break;
+            case 'n': options.base.numCores = std::stoi(optarg); break;
+            case OPT_EVENT_DRIVEN: options.base.eventDriven = true; break;
+            case OPT_TAG_ONLY: options.base.tagOnly = true; break;
+            case OPT_SNOOP_FILTER: options.base.snoopFilter = true; break;
+            case OPT_REPLACEMENT: options.base.replacement = optarg; break;
+            case OPT_PREFETCH: options.base.prefetcher = optarg; break;
+            case OPT_PREFETCH_DEGREE: options.base.prefetchDegree = std::stoi(optarg); break;
+            case OPT_MSHRS: options.base.mshrs = std::stoi(optarg); break;
+            case OPT_BUS: options.base.bus = optarg; break;
+            case OPT_MEM_BANKS: options.base.memoryBanks = std::stoi(optarg); break;
+            case OPT_WB_BUFFER: options.base.writebackBuffer = std::stoi(optarg); break;
+            case OPT_L2_SETS: options.base.l2SetBits = std::stoi(optarg); break;
+            case OPT_L2_WAYS: options.base.l2Associativity = std::stoi(optarg); break;
+            case OPT_L2_BLOCK: options.base.l2BlockBits = std::stoi(optarg); break;
+            case OPT_L2_LATENCY: options.base.l2Latency = std::stoi(optarg); break;
+            case OPT_L2_NON_INCLUSIVE: options.base.l2Inclusive = false; break;
+            default:
+                options.valid = false;
+                break;
+        }
+    }
+
+    if (options.base.helpRequested) return options;
+
+    if (options.base.appName.empty()) {
+        std::cerr << "Error: Application name (-t) is required" << std::endl;
+        options.valid = false;
+    }
+    if (options.setBits.empty() || options.associativities.empty() || options.blockBits.empty()) {
+        std::cerr << "Error: -s, -E and -b lists are all required" << std::endl;
+        options.valid = false;
+    }
+    for (int s : options.setBits) {
+        if (s <= 0) { std::cerr << "Error: Number of set bits (-s) must be positive" << std::endl; options.valid = false; break; }
+    }
+    for (int E : options.associativities) {
+        if (E <= 0) { std::cerr << "Error: Associativity (-E) must be positive" << std::endl; options.valid = false; break; }
+    }
+    for (int b : options.blockBits) {
+        if (b <= 0) { std::cerr << "Error: Number of block bits (-b) must be positive" << std::endl; options.valid = false; break; }
+    }
+    if (options.base.numCores <= 0 || options.base.numCores > SnoopFilter::MAX_CORES) {
+        std::cerr << "Error: Number of cores (-n) must be between 1 and "
+                  << SnoopFilter::MAX_CORES << std::endl;
+        options.valid = false;
+    }
+    ReplacementPolicy policy;
+    if (!parseReplacementPolicy(options.base.replacement, policy)) {
+        std::cerr << "Error: Replacement policy (--replacement) must be lru, true-lru, plru, srrip, brrip or random" << std::endl;
+        options.valid = false;
+    }
+    Prefetcher::Kind prefetchKind;
+    if (!Prefetcher::parseKind(options.base.prefetcher, prefetchKind) || options.base.prefetchDegree == 0) {
+        std::cerr << "Error: Prefetcher (--prefetch) must be none, next-line, stride or stream"
+                  << " with a positive --prefetch-degree" << std::endl;
+        options.valid = false;
+    }
+    if (options.base.mshrs == 0 || options.base.mshrs > 64) {
+        std::cerr << "Error: MSHR count (--mshrs) must be between 1 and 64" << std::endl;
+        options.valid = false;
+    }
+    BusModel::Mode busMode;
+    if (!BusModel::parseMode(options.base.bus, busMode)
+        || options.base.memoryBanks == 0 || options.base.memoryBanks > 1024) {
+        std::cerr << "Error: Bus model (--bus) must be atomic or split"
+                  << " with 1 to 1024 --mem-banks" << std::endl;
+        options.valid = false;
+    }
+    if (options.base.writebackBuffer > 64) {
+        std::cerr << "Error: Write-back buffer entries (--wb-buffer) must be between 0 and 64" << std::endl;
+        options.valid = false;
+    }
+    if (options.base.l2SetBits < 0 || options.base.l2Associativity <= 0) {
+        std::cerr << "Error: L2 set bits (--l2-sets) must not be negative and its associativity (--l2-ways) must be positive" << std::endl;
+        options.valid = false;
+    }
+    for (int b : options.blockBits) {
+        if (options.base.l2BlockBits != 0 && options.base.l2BlockBits < b) {
+            std::cerr << "Error: L2 block bits (--l2-block) must be at least every -b value" << std::endl;
+            options.valid = false;
+            break;
+        }
+    }
+    if (options.format != "csv" && options.format != "json") {
+        std::cerr << "Error: Output format (-f) must be csv or json" << std::endl;
+        options.valid = false;
+    }
+    return options;
+}
+
+int main(int argc, char* argv[]) {
+    SweepOptions options = parseArguments(argc, argv);
+    if (options.base.helpRequested || !options.valid) {
+        printHelp(argv[0]);
+        return options.base.helpRequested ? 0 : 1;
+    }
+
+    // Decode the traces once; every simulator replays the same read-only copy
+    std::shared_ptr<const SharedTrace> traces = SharedTrace::load(options.base.appName, options.base.numCores);
+    if (!traces) {
+        std::cerr << "Error: Failed to load trace files." << std::endl;
+        return 1;
+    }
+
+    std::vector<SweepPoint> points =
+        SweepRunner::buildGrid(options.setBits, options.associativities, options.blockBits);
+    std::cerr << "Sweeping " << points.size() << " configurations on "
+              << options.threads << " threads...\n";
+
+    SweepRunner runner(options.base, traces, options.threads);
+    std::vector<SweepResult> results = runner.run(points);
+
+    std::ofstream file;
+    if (!options.outputFile.empty()) {
+        file.open(options.outputFile);
+        if (!file) {
+            std::cerr << "Error: Could not open output file " << options.outputFile << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = options.outputFile.empty() ? std::cout : file;
+
+    if (options.format == "json") {
+        SweepRunner::writeJson(out, results);
+    } else {
+        SweepRunner::writeCsv(out, results);
+    }
+
+    for (const auto& r : results) {
+        if (!r.ok) return 1;
+    }
+    return 0;
+}
@@ -1,235 +1,818 @@
-#include "Simulator.h"
-#include "Cache.h"
-#include "CacheSet.h"
-#include "CacheLine.h"
-#include "Address.h"
-#include "TraceReader.h"
-#include "MainMemory.h"
-#include "Processor.h"
-#include <iostream>
-#include <fstream>
-#include <iomanip>
-#include <vector>
-#include <string>
-#include <getopt.h>
-#include <algorithm>
-
-// Parse command line arguments and return configuration
-SimulationConfig parseCommandLineArguments(int argc, char* argv[]) {
-    SimulationConfig config;
-    int opt;
-    const char* optString = "ht:s:E:b:o:";
-    while ((opt = getopt(argc, argv, optString)) != -1) {
-        switch (opt) {
-            case 'h': config.helpRequested = true; break;
-            case 't': config.appName = optarg; break;
-            case 's': config.setBits = std::stoi(optarg); break;
-            case 'E': config.associativity = std::stoi(optarg); break;
-            case 'b': config.blockBits = std::stoi(optarg); break;
-            case 'o': config.outputFile = optarg; break;
-            default:
-                std::cerr << "Unknown option: " << static_cast<char>(optopt) << std::endl;
-                config.helpRequested = true;
-                break;
-        }
-    }
-    return config;
-}
-
-// Validate the configuration
-bool validateConfig(const SimulationConfig& config) {
-    if (config.helpRequested) return true;
-    bool valid = true;
-    if (config.appName.empty()) {
-        std::cerr << "Error: Application name (-t) is required" << std::endl;
-        valid = false;
-    }
-    if (config.setBits <= 0) {
-        std::cerr << "Error: Number of set bits (-s) must be positive" << std::endl;
-        valid = false;
-    }
-    if (config.associativity <= 0) {
-        std::cerr << "Error: Associativity (-E) must be positive" << std::endl;
-        valid = false;
-    }
-    if (config.blockBits <= 0) {
-        std::cerr << "Error: Number of block bits (-b) must be positive" << std::endl;
-        valid = false;
-    }
-    return valid;
-}
-
-// Print help message
-void printHelp(const char* programName) {
-    std::cout << "Usage: " << programName << " [OPTIONS]\n";
-    std::cout << "Simulate L1 cache with MESI coherence protocol.\n\n";
-    std::cout << "Options:\n";
-    std::cout << "  -t <n>    : Name of parallel application (e.g. app1) whose 4 traces are to be used in simulation\n";
-    std::cout << "  -s <bits> : Number of set index bits (S = 2^s)\n";
-    std::cout << "  -E <ways> : Associativity (number of lines per set)\n";
-    std::cout << "  -b <bits> : Number of block bits (B = 2^b)\n";
-    std::cout << "  -o <file> : Logs output in file for plotting etc.\n";
-    std::cout << "  -h        : Prints this help\n";
-}
-
-// Debugging print functions
-void printCacheLine(const CacheLine& line, int setIdx, int wayIdx) {
-    std::cout << "  [S" << setIdx << ",W" << wayIdx << "] ";
-    if (!line.isValid()) {
-        std::cout << "INVALID\n";
-        return;
-    }
-    std::cout << "Tag=0x" << std::hex << std::setw(8) << std::setfill('0')
-              << line.getTag() << std::dec
-              << ", State=" << line.getMESIStateString()
-              << ", LRU=" << line.getLRUCounter()
-              << (line.isDirty() ? ", Dirty" : ", Clean")
-              << "\n";
-}
-
-void printCacheSet(const CacheSet& set, int setIdx) {
-    for (unsigned int w = 0; w < set.getAssociativity(); ++w) {
-        printCacheLine(set.getLines()[w], setIdx, w);
-    }
-}
-
-void printCache(const Cache& c) {
-    int sets = 1 << c.getSetBits();
-    int ways = c.getAssociativity();
-    int bsz  = 1 << c.getBlockBits();
-
-    std::cout << "-- Cache Core" << c.getCoreId()
-              << " (" << sets << " sets, " << ways << " ways, "
-              << bsz << "B block) --\n";
-    std::cout << "   Acc=" << c.getAccessCount()
-              << " Ht="  << c.getHitCount()
-              << " Ms="  << c.getMissCount() << "\n";
-    for (int s = 0; s < sets; ++s) printCacheSet(c.getSets()[s], s);
-}
-
-void printProc(const Processor& p) {
-    std::cout << "Proc" << p.getCoreId()
-              << (p.isBlocked() ? "[Blk]" : "[Run]")
-              << " Exec="   << p.getInstructionsExecuted()
-              << " StallC=" << p.getCyclesBlocked()
-              << " More="   << (p.hasMoreInstructions() ? "Y" : "N")
-              << "\n";
-}
-
-//------------------------------------------------------------------------------
-// Test‐simulator subclass
-//------------------------------------------------------------------------------
-class TestSimulator : public Simulator {
-private:
-    unsigned int finishCycle[4] = {0,0,0,0};
-public:
-    using Simulator::Simulator;
-    using Simulator::isSimulationComplete;
-    using Simulator::getCurrentCycle;
-    using Simulator::getCaches;
-    using Simulator::getProcessors;
-    using Simulator::getMainMemory;
-
-    // override to capture finish cycle (without printing details)
-    bool processNextCycle() override {
-        bool cont = Simulator::processNextCycle();
-        for (auto& pp : getProcessors()) {
-            const auto& p = *pp;
-            int cid = p.getCoreId();
-            if (!finishCycle[cid] && !p.hasMoreInstructions()) {
-                finishCycle[cid] = getCurrentCycle();
-            }
-        }
-        return cont;
-    }
-
-    // after completion, print all eight metrics
-    void printAllStats() const {
-        std::cout << "\n==== Final Statistics ====" << std::endl;
-        for (int c = 0; c < 4; ++c) {
-            const auto& cache = *getCaches()[c];
-            const auto& proc  = *getProcessors()[c];
-
-            unsigned reads     = cache.getReadCount();
-            unsigned writes    = cache.getWriteCount();
-            unsigned accesses  = cache.getAccessCount();
-            unsigned misses    = cache.getMissCount();
-            unsigned evicts    = cache.getEvictionCount();
-            unsigned wbacks    = cache.getWritebackCount();
-            unsigned idleCycles= proc.getCyclesBlocked();
-            unsigned execCycles = getCurrentCycle() - idleCycles;
-            double   missRate  = accesses ? double(misses)/accesses : 0.0;
-            unsigned maxexectime = std::max({finishCycle[0], finishCycle[1], finishCycle[2], finishCycle[3]});
-
-            std::cout << "Core " << c << ":\n";
-            std::cout << "  1) #reads         = " << reads << "\n";
-            std::cout << "     #writes        = " << writes << "\n";
-            std::cout << "  2) exec cycles    = " << execCycles << "\n";
-            std::cout << "  3) idle cycles    = " << idleCycles << "\n";
-            std::cout << "  4) miss rate      = " << std::fixed << std::setprecision(2)
-                      << (missRate * 100) << "%\n";
-            std::cout << "  5) evictions      = " << evicts << "\n";
-            std::cout << "  6) writebacks     = " << wbacks << "\n\n";
-            std::cout << " Maximum execution time = " << maxexectime << "\n";
-        }
-        std::cout << "  7) bus invalidations = " << getInvalidationCount() << "\n";
-        std::cout << "  8) bus traffic bytes = " << getBusTrafficBytes() << "\n";
-    }
-};
-
-//------------------------------------------------------------------------------
-// main()
-//------------------------------------------------------------------------------
-int main(int argc, char* argv[]) {
-    // Parse command line arguments
-    SimulationConfig config = parseCommandLineArguments(argc, argv);
-    
-    // If help was requested or invalid arguments, print help and exit
-    if (config.helpRequested || !validateConfig(config)) {
-        printHelp(argv[0]);
-        return config.helpRequested ? 0 : 1;
-    }
-    
-    // Create simulator with the configuration
-    TestSimulator sim(config);
-    
-    // Initialize simulator
-    if (!sim.initialize()) {
-        std::cerr << "Failed to initialize simulator. Exiting." << std::endl;
-        return 1;
-    }
-    
-    // Display simulation parameters
-    std::cout << "===== Simulation Configuration =====\n";
-    std::cout << "Application: " << config.appName << std::endl;
-    std::cout << "Cache Configuration:\n";
-    std::cout << "  Sets: " << (1 << config.setBits) << " (2^" << config.setBits << ")" << std::endl;
-    std::cout << "  Associativity: " << config.associativity << std::endl;
-    std::cout << "  Block Size: " << (1 << config.blockBits) << " bytes (2^" << config.blockBits << ")" << std::endl;
-    std::cout << "Output File: " << (config.outputFile.empty() ? "None" : config.outputFile) << std::endl;
-    std::cout << "=====================================\n\n";
-    
-    // Run simulation
-    std::cout << "Running simulation...\n";
-    while (!sim.isSimulationComplete()) {
-        sim.processNextCycle();
-    }
-    std::cout << "Simulation completed.\n";
-    
-    // Write statistics either to the specified output file or to stdout
-    if (!config.outputFile.empty()) {
-        std::ofstream ofs(config.outputFile);
-        if (!ofs) {
-            std::cerr << "Error: Could not open output file " << config.outputFile << std::endl;
-            return 1;
-        }
-        auto* origBuf = std::cout.rdbuf();
-        std::cout.rdbuf(ofs.rdbuf());
-        sim.printAllStats();
-        std::cout.rdbuf(origBuf);
-    } else {
-        sim.printAllStats();
-    }
-    
-    return 0;
-}
+#include "Simulator.h"
+#include "Cache.h"
+#include "CacheSet.h"
+#include "CacheLine.h"
+#include "Address.h"
+#include "TraceReader.h"
+#include "MainMemory.h"
+#include "Processor.h"
+#include "StackDistance.h"
+#include "FunctionalCacheModel.h"
+#include "ReplacementPolicy.h"
+#include "BusModel.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <getopt.h>
+#include <algorithm>
+#include <cmath>
+
+// Codes for options that only have a long form
+enum LongOption {
+    OPT_EVENT_DRIVEN = 256,
+    OPT_STACK_DISTANCE,
+    OPT_FUNCTIONAL,
+    OPT_TAG_ONLY,
+    OPT_SNOOP_FILTER,
+    OPT_THREADS,
+    OPT_QUANTUM,
+    OPT_PREFETCH_TRACES,
+    OPT_STATS,
+    OPT_STATS_FORMAT,
+    OPT_LOG_INTERVAL,
+    OPT_REPLACEMENT,
+    OPT_PREFETCH,
+    OPT_PREFETCH_DEGREE,
+    OPT_MSHRS,
+    OPT_BUS,
+    OPT_MEM_BANKS,
+    OPT_WB_BUFFER,
+    OPT_L2_SETS,
+    OPT_L2_WAYS,
+    OPT_L2_BLOCK,
+    OPT_L2_LATENCY,
+    OPT_L2_NON_INCLUSIVE,
+    OPT_MISS_PROFILE,
+    OPT_SHARING_TOP,
+    OPT_CHECKPOINT,
+    OPT_CHECKPOINT_AT,
+    OPT_RESTORE,
+    OPT_SAMPLE,
+    OPT_SAMPLE_WARMUP,
+    OPT_SAMPLE_SIZE,
+    OPT_PROTOCOL,
+    OPT_SCHEDULE,
+    OPT_TIME_SLICE,
+    OPT_FLUSH_ON_SWITCH
+};
+
+// Parse command line arguments and return configuration
+SimulationConfig parseCommandLineArguments(int argc, char* argv[]) {
+    SimulationConfig config;
+    int opt;
+    const char* optString = "ht:s:E:b:o:n:";
+    static const struct option longOptions[] = {
+        {"help",         no_argument, nullptr, 'h'},
+        {"event-driven",   no_argument,       nullptr, OPT_EVENT_DRIVEN},
+        {"stack-distance", required_argument, nullptr, OPT_STACK_DISTANCE},
+        {"functional",     no_argument,       nullptr, OPT_FUNCTIONAL},
+        {"tag-only",       no_argument,       nullptr, OPT_TAG_ONLY},
+        {"snoop-filter",   no_argument,       nullptr, OPT_SNOOP_FILTER},
+        {"threads",        required_argument, nullptr, OPT_THREADS},
+        {"quantum",        required_argument, nullptr, OPT_QUANTUM},
+        {"prefetch-traces", no_argument,      nullptr, OPT_PREFETCH_TRACES},
+        {"stats",          required_argument, nullptr, OPT_STATS},
+        {"stats-format",   required_argument, nullptr, OPT_STATS_FORMAT},
+        {"log-interval",   required_argument, nullptr, OPT_LOG_INTERVAL},
+        {"replacement",    required_argument, nullptr, OPT_REPLACEMENT},
+        {"prefetch",       required_argument, nullptr, OPT_PREFETCH},
+        {"prefetch-degree", required_argument, nullptr, OPT_PREFETCH_DEGREE},
+        {"mshrs",          required_argument, nullptr, OPT_MSHRS},
+        {"bus",            required_argument, nullptr, OPT_BUS},
+        {"mem-banks",      required_argument, nullptr, OPT_MEM_BANKS},
+        {"wb-buffer",      required_argument, nullptr, OPT_WB_BUFFER},
+        {"protocol",       required_argument, nullptr, OPT_PROTOCOL},
+        {"l2-sets",        required_argument, nullptr, OPT_L2_SETS},
+        {"l2-ways",        required_argument, nullptr, OPT_L2_WAYS},
+        {"l2-block",       required_argument, nullptr, OPT_L2_BLOCK},
+        {"l2-latency",     required_argument, nullptr, OPT_L2_LATENCY},
+        {"l2-non-inclusive", no_argument,     nullptr, OPT_L2_NON_INCLUSIVE},
+        {"miss-profile",   required_argument, nullptr, OPT_MISS_PROFILE},
+        {"sharing-top",    required_argument, nullptr, OPT_SHARING_TOP},
+        {"checkpoint",     required_argument, nullptr, OPT_CHECKPOINT},
+        {"checkpoint-at",  required_argument, nullptr, OPT_CHECKPOINT_AT},
+        {"restore",        required_argument, nullptr, OPT_RESTORE},
+        {"sample",         required_argument, nullptr, OPT_SAMPLE},
+        {"sample-warmup",  required_argument, nullptr, OPT_SAMPLE_WARMUP},
+        {"sample-size",    required_argument, nullptr, OPT_SAMPLE_SIZE},
+        {"schedule",       required_argument, nullptr, OPT_SCHEDULE},
+        {"time-slice",     required_argument, nullptr, OPT_TIME_SLICE},
+        {"flush-on-switch", no_argument,      nullptr, OPT_FLUSH_ON_SWITCH},
+        {nullptr,          0,                 nullptr, 0}
+    };
+    while ((opt = getopt_long(argc, argv, optString, longOptions, nullptr)) != -1) {
+        switch (opt) {
+            case 'h': config.helpRequested = true; break;
+            case 't': config.appName = optarg; break;
+            case 's': config.setBits = std::stoi(optarg); break;
+            case 'E': config.associativity = std::stoi(optarg); break;
+            case 'b': config.blockBits = std::stoi(optarg); break;
+            case 'o': config.outputFile = optarg; break;
+            case 'n': config.numCores = std::stoi(optarg); break;
+            case OPT_EVENT_DRIVEN: config.eventDriven = true; break;
+            case OPT_STACK_DISTANCE: config.stackDistanceWays = std::stoi(optarg); break;
+            case OPT_FUNCTIONAL: config.functionalOnly = true; break;
+            case OPT_TAG_ONLY: config.tagOnly = true; break;
+            case OPT_SNOOP_FILTER: config.snoopFilter = true; break;
+            case OPT_THREADS: config.threads = std::stoi(optarg); break;
+            case OPT_QUANTUM: config.quantum = std::stoi(optarg); break;
+            case OPT_PREFETCH_TRACES: config.prefetchTraces = true; break;
+            case OPT_STATS: config.statsFile = optarg; break;
+            case OPT_STATS_FORMAT: config.statsFormat = optarg; break;
+            case OPT_LOG_INTERVAL: config.logInterval = std::stoi(optarg); break;
+            case OPT_REPLACEMENT: config.replacement = optarg; break;
+            case OPT_PREFETCH: config.prefetcher = optarg; break;
+            case OPT_PREFETCH_DEGREE: config.prefetchDegree = std::stoi(optarg); break;
+            case OPT_MSHRS: config.mshrs = std::stoi(optarg); break;
+            case OPT_BUS: config.bus = optarg; break;
+            case OPT_MEM_BANKS: config.memoryBanks = std::stoi(optarg); break;
+            case OPT_WB_BUFFER: config.writebackBuffer = std::stoi(optarg); break;
+            case OPT_PROTOCOL: config.protocol = optarg; break;
+            case OPT_L2_SETS: config.l2SetBits = std::stoi(optarg); break;
+            case OPT_L2_WAYS: config.l2Associativity = std::stoi(optarg); break;
+            case OPT_L2_BLOCK: config.l2BlockBits = std::stoi(optarg); break;
+            case OPT_L2_LATENCY: config.l2Latency = std::stoi(optarg); break;
+            case OPT_L2_NON_INCLUSIVE: config.l2Inclusive = false; break;
+            case OPT_MISS_PROFILE: config.missProfileFile = optarg; break;
+            case OPT_SHARING_TOP: config.sharingTop = std::stoi(optarg); break;
+            case OPT_CHECKPOINT: config.checkpointFile = optarg; break;
+            case OPT_CHECKPOINT_AT: config.checkpointAt = std::stoull(optarg); break;
+            case OPT_RESTORE: config.restoreFile = optarg; break;
+            case OPT_SAMPLE: config.sampleInterval = std::stoull(optarg); break;
+            case OPT_SAMPLE_WARMUP: config.sampleWarmup = std::stoull(optarg); break;
+            case OPT_SAMPLE_SIZE: config.sampleSize = std::stoull(optarg); break;
+            case OPT_SCHEDULE: config.schedule = optarg; break;
+            case OPT_TIME_SLICE: config.timeSlice = std::stoul(optarg); break;
+            case OPT_FLUSH_ON_SWITCH: config.flushOnSwitch = true; break;
+            default:
+                std::cerr << "Unknown option: " << static_cast<char>(optopt) << std::endl;
+                config.helpRequested = true;
+                break;
+        }
+    }
+    return config;
+}
+
+// Validate the configuration
+bool validateConfig(const SimulationConfig& config) {
+    if (config.helpRequested) return true;
+    bool valid = true;
+    if (config.appName.empty() == config.schedule.empty()) {
+        std::cerr << "Error: Either an application name (-t) or a schedule (--schedule) is required" << std::endl;
+        valid = false;
+    }
+    if (config.setBits <= 0) {
+        std::cerr << "Error: Number of set bits (-s) must be positive" << std::endl;
+        valid = false;
+    }
+    if (config.associativity <= 0 && config.stackDistanceWays == 0) {
+        std::cerr << "Error: Associativity (-E) must be positive" << std::endl;
+        valid = false;
+    }
+    if (config.stackDistanceWays < 0) {
+        std::cerr << "Error: --stack-distance associativity must be positive" << std::endl;
+        valid = false;
+    }
+    if (config.blockBits <= 0) {
+        std::cerr << "Error: Number of block bits (-b) must be positive" << std::endl;
+        valid = false;
+    }
+    if (config.numCores <= 0 || config.numCores > SnoopFilter::MAX_CORES) {
+        std::cerr << "Error: Number of cores (-n) must be between 1 and "
+                  << SnoopFilter::MAX_CORES << std::endl;
+        valid = false;
+    }
+    if (config.threads < 0) {
+        std::cerr << "Error: Number of threads (--threads) must not be negative" << std::endl;
+        valid = false;
+    }
+    if (config.quantum == 0) {
+        std::cerr << "Error: Quantum (--quantum) must be positive" << std::endl;
+        valid = false;
+    }
+    StatsSink::Format statsFormat;
+    if (!StatsSink::parseFormat(config.statsFormat, statsFormat)) {
+        std::cerr << "Error: Statistics format (--stats-format) must be binary or csv" << std::endl;
+        valid = false;
+    }
+    if (config.logInterval == 0) {
+        std::cerr << "Error: Log interval (--log-interval) must be positive" << std::endl;
+        valid = false;
+    }
+    ReplacementPolicy policy;
+    if (!parseReplacementPolicy(config.replacement, policy)) {
+        std::cerr << "Error: Replacement policy (--replacement) must be lru, true-lru, plru, srrip, brrip or random" << std::endl;
+        valid = false;
+    }
+    Prefetcher::Kind prefetchKind;
+    if (!Prefetcher::parseKind(config.prefetcher, prefetchKind)) {
+        std::cerr << "Error: Prefetcher (--prefetch) must be none, next-line, stride or stream" << std::endl;
+        valid = false;
+    }
+    if (config.prefetchDegree == 0) {
+        std::cerr << "Error: Prefetch degree (--prefetch-degree) must be positive" << std::endl;
+        valid = false;
+    }
+    if (config.mshrs == 0 || config.mshrs > 64) {
+        std::cerr << "Error: MSHR count (--mshrs) must be between 1 and 64" << std::endl;
+        valid = false;
+    }
+    BusModel::Mode busMode;
+    if (!BusModel::parseMode(config.bus, busMode)) {
+        std::cerr << "Error: Bus model (--bus) must be atomic or split" << std::endl;
+        valid = false;
+    }
+    if (config.memoryBanks == 0 || config.memoryBanks > 1024) {
+        std::cerr << "Error: Memory banks (--mem-banks) must be between 1 and 1024" << std::endl;
+        valid = false;
+    }
+    if (config.writebackBuffer > 64) {
+        std::cerr << "Error: Write-back buffer entries (--wb-buffer) must be between 0 and 64" << std::endl;
+        valid = false;
+    }
+    CoherenceProtocol protocol;
+    if (!config.protocol.empty() && !Bus::parseProtocol(config.protocol, protocol)) {
+        std::cerr << "Error: Coherence protocol (--protocol) must be mesi, moesi or mesif" << std::endl;
+        valid = false;
+    }
+    if (config.l2SetBits < 0 || config.l2Associativity <= 0) {
+        std::cerr << "Error: L2 set bits (--l2-sets) must not be negative and its associativity (--l2-ways) must be positive" << std::endl;
+        valid = false;
+    }
+    if (config.l2BlockBits != 0 && config.l2BlockBits < config.blockBits) {
+        std::cerr << "Error: L2 block bits (--l2-block) must be at least the L1 block bits (-b)" << std::endl;
+        valid = false;
+    }
+    if (config.checkpointFile.empty() != (config.checkpointAt == 0)) {
+        std::cerr << "Error: --checkpoint <file> and --checkpoint-at <n> (positive) go together" << std::endl;
+        valid = false;
+    }
+    if (!config.checkpointFile.empty() || !config.restoreFile.empty()) {
+        // Prefetcher state and the parallel loop's core clocks are not saved
+        if (config.prefetcher != "none" || config.threads > 0 || config.stackDistanceWays > 0 ||
+            config.functionalOnly || !config.schedule.empty()) {
+            std::cerr << "Error: Checkpoints (--checkpoint, --restore) only work without --prefetch, --threads, --stack-distance, --functional and --schedule" << std::endl;
+            valid = false;
+        }
+    }
+    if (config.sampleInterval > 0) {
+        if (config.sampleSize == 0 || config.sampleInterval < config.sampleWarmup + config.sampleSize) {
+            std::cerr << "Error: Sample interval (--sample) must cover --sample-warmup plus a positive --sample-size" << std::endl;
+            valid = false;
+        }
+        if (config.threads > 0) {
+            std::cerr << "Error: Sampled simulation (--sample) does not run with --threads" << std::endl;
+            valid = false;
+        }
+    }
+    if (!config.schedule.empty()) {
+        std::vector<ScheduleEntry> entries;
+        if (!TraceScheduler::parseSchedule(config.schedule, config.numCores, entries)) {
+            std::cerr << "Error: Schedule (--schedule) must be a comma-separated list of app or app:traces" << std::endl;
+            valid = false;
+        }
+        if (config.threads > 0 || config.stackDistanceWays > 0 || config.functionalOnly) {
+            std::cerr << "Error: Scheduled traces (--schedule) do not run with --threads, --stack-distance or --functional" << std::endl;
+            valid = false;
+        }
+    } else if (config.timeSlice > 0 || config.flushOnSwitch) {
+        std::cerr << "Error: --time-slice and --flush-on-switch need --schedule" << std::endl;
+        valid = false;
+    }
+#ifndef L1SIM_INSTRUMENT
+    if (!config.missProfileFile.empty()) {
+        std::cerr << "Error: Miss profiling (--miss-profile) needs a build with make INSTRUMENT=1" << std::endl;
+        valid = false;
+    }
+    if (config.sharingTop > 0) {
+        std::cerr << "Error: Sharing attribution (--sharing-top) needs a build with make INSTRUMENT=1" << std::endl;
+        valid = false;
+    }
+#endif
+    return valid;
+}
+
+// Print help message
+void printHelp(const char* programName) {
+    std::cout << "Usage: " << programName << " [OPTIONS]\n";
+    std::cout << "Simulate L1 cache with MESI coherence protocol.\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  -t <n>    : Name of parallel application (e.g. app1) whose traces (one per core) are to be used in simulation\n";
+    std::cout << "  -s <bits> : Number of set index bits (S = 2^s)\n";
+    std::cout << "  -E <ways> : Associativity (number of lines per set)\n";
+    std::cout << "  -b <bits> : Number of block bits (B = 2^b)\n";
+    std::cout << "  -o <file> : Logs output in file for plotting etc.\n";
+    std::cout << "  -n <n>    : Number of cores, reading <app>_proc0..n-1 traces (default: 4)\n";
+    std::cout << "  -h        : Prints this help\n";
+    std::cout << "\nSimulation modes:\n";
+    std::cout << "  --event-driven : Skip straight to the next miss resolution while every core is stalled\n";
+    std::cout << "  --tag-only     : Keep no data payloads in caches or memory (statistics are unchanged)\n";
+    std::cout << "  --snoop-filter : Snoop only the caches a sharer directory lists for each block\n";
+    std::cout << "  --threads <n>  : Advance cores on n threads in bounded-lag quanta (reports lagged bus transactions)\n";
+    std::cout << "  --quantum <c>  : Cycles a core may run ahead of the slowest one in --threads mode (default: 100)\n";
+    std::cout << "  --prefetch-traces : Decode text traces on a background thread ahead of the simulation\n";
+    std::cout << "  --replacement <p> : Victim policy: lru (default, hits only), true-lru, plru, srrip, brrip, random\n";
+    std::cout << "  --prefetch <p>    : L1 prefetcher: none (default), next-line, stride, stream\n";
+    std::cout << "  --prefetch-degree <n> : Blocks fetched ahead per prefetcher trigger (default: 2)\n";
+    std::cout << "  --mshrs <n>       : Misses each cache keeps in flight; above 1 the core runs on past misses (default: 1)\n";
+    std::cout << "  --bus <model>     : atomic (default, one transaction holds the bus) or split (request, memory and data phases overlap)\n";
+    std::cout << "  --mem-banks <n>   : Memory banks behind a split bus, interleaved by block (default: 8)\n";
+    std::cout << "  --wb-buffer <n>   : Dirty victims each cache buffers and writes back in the background (default: 0)\n";
+    std::cout << "  --protocol <p>    : Coherence protocol: mesi (default), moesi or mesif; also reports fills,\n";
+    std::cout << "                      data responses and snoop writebacks\n";
+    std::cout << "\nShared L2:\n";
+    std::cout << "  --l2-sets <bits>  : Set index bits of a shared L2 behind the L1s (default: 0, no L2)\n";
+    std::cout << "  --l2-ways <ways>  : L2 associativity (default: 8)\n";
+    std::cout << "  --l2-block <bits> : L2 block bits, at least -b (default: same as -b)\n";
+    std::cout << "  --l2-latency <c>  : L2 hit latency; a miss adds the 100-cycle memory access (default: 20)\n";
+    std::cout << "  --l2-non-inclusive : Do not back-invalidate L1 copies of evicted L2 blocks\n";
+    std::cout << "\nStatistics stream:\n";
+    std::cout << "  --stats <file>        : Record per-interval hits, misses, stalls, bus invalidations and bytes\n";
+    std::cout << "  --stats-format <fmt>  : binary (columnar chunks, default) or csv\n";
+    std::cout << "  --log-interval <c>    : Cycles per sample (default: 1000)\n";
+    std::cout << "\nAnalysis modes:\n";
+    std::cout << "  --stack-distance <E> : Per-core LRU miss curve for associativities 1..E at 2^s sets (no timing, -E unused)\n";
+    std::cout << "  --functional          : Per-core hits/misses/evictions of private caches from one batch pass over each\n";
+    std::cout << "                          trace (no timing or coherence; honours -s/-E/-b and --replacement)\n";
+    std::cout << "  --miss-profile <file> : JSON report of per-set accesses/misses/evictions and compulsory/capacity/\n";
+    std::cout << "                          conflict/coherence misses (builds with make INSTRUMENT=1 only)\n";
+    std::cout << "  --sharing-top <n>     : Rank the n blocks with the most peer invalidations, split into true and\n";
+    std::cout << "                          false sharing, with per-core word masks (builds with make INSTRUMENT=1 only)\n";
+    std::cout << "\nSampled simulation:\n";
+    std::cout << "  --sample <n>          : Simulate one window per n instructions (all cores) in detail, warming the\n";
+    std::cout << "                          caches functionally in between; reports IPC and miss rate with 95% intervals\n";
+    std::cout << "  --sample-warmup <n>   : Detailed instructions before each window is measured (default: 2000)\n";
+    std::cout << "  --sample-size <n>     : Instructions measured per window (default: 1000)\n";
+    std::cout << "\nMulti-programmed runs:\n";
+    std::cout << "  --schedule <list>     : Time-slice the traces of several programs over the cores instead of -t,\n";
+    std::cout << "                          e.g. app1,app2 or app1:2,app2:6 (traces per program; default: -n)\n";
+    std::cout << "  --time-slice <c>      : Cycles a trace keeps its core while others wait (default: 0, run to completion)\n";
+    std::cout << "  --flush-on-switch     : Invalidate a core's L1, writing dirty lines back, on every context switch\n";
+    std::cout << "\nCheckpoints:\n";
+    std::cout << "  --checkpoint <file>   : Save the whole simulator state to file ...\n";
+    std::cout << "  --checkpoint-at <n>   : ... once the cores have executed n instructions in total (the run goes on)\n";
+    std::cout << "  --restore <file>      : Resume from a checkpoint saved with the same trace and cache settings\n";
+}
+
+// Debugging print functions
+void printCacheLine(const CacheLine& line, int setIdx, int wayIdx) {
+    std::cout << "  [S" << setIdx << ",W" << wayIdx << "] ";
+    if (!line.isValid()) {
+        std::cout << "INVALID\n";
+        return;
+    }
+    std::cout << "Tag=0x" << std::hex << std::setw(8) << std::setfill('0')
+              << line.getTag() << std::dec
+              << ", State=" << line.getMESIStateString()
+              << ", LRU=" << line.getLRUCounter()
+              << (line.isDirty() ? ", Dirty" : ", Clean")
+              << "\n";
+}
+
+void printCacheSet(const CacheSet& set, int setIdx) {
+    for (unsigned int w = 0; w < set.getAssociativity(); ++w) {
+        printCacheLine(set.getLines()[w], setIdx, w);
+    }
+}
+
+void printCache(const Cache& c) {
+    int sets = 1 << c.getSetBits();
+    int ways = c.getAssociativity();
+    int bsz  = 1 << c.getBlockBits();
+
+    std::cout << "-- Cache Core" << c.getCoreId()
+              << " (" << sets << " sets, " << ways << " ways, "
+              << bsz << "B block) --\n";
+    std::cout << "   Acc=" << c.getAccessCount()
+              << " Ht="  << c.getHitCount()
+              << " Ms="  << c.getMissCount() << "\n";
+    for (int s = 0; s < sets; ++s) printCacheSet(c.getSets()[s], s);
+}
+
+void printProc(const Processor& p) {
+    std::cout << "Proc" << p.getCoreId()
+              << (p.isBlocked() ? "[Blk]" : "[Run]")
+              << " Exec="   << p.getInstructionsExecuted()
+              << " StallC=" << p.getCyclesBlocked()
+              << " More="   << (p.hasMoreInstructions() ? "Y" : "N")
+              << "\n";
+}
+
+//------------------------------------------------------------------------------
+// Test‐simulator subclass
+//------------------------------------------------------------------------------
+class TestSimulator : public Simulator {
+private:
+public:
+    using Simulator::Simulator;
+    using Simulator::processNextCycle;
+    using Simulator::runParallel;
+    using Simulator::runSampled;
+    using Simulator::isSimulationComplete;
+    using Simulator::getCurrentCycle;
+    using Simulator::getCaches;
+    using Simulator::getProcessors;
+    using Simulator::getMainMemory;
+
+    // after completion, print all eight metrics
+    void printAllStats() const {
+        std::cout << "\n==== Final Statistics ====" << std::endl;
+        for (int c = 0; c < (int)getCaches().size(); ++c) {
+            const auto& cache = *getCaches()[c];
+            const auto& proc  = *getProcessors()[c];
+
+            uint64_t reads     = cache.getReadCount();
+            uint64_t writes    = cache.getWriteCount();
+            uint64_t accesses  = cache.getAccessCount();
+            uint64_t misses    = cache.getMissCount();
+            uint64_t evicts    = cache.getEvictionCount();
+            uint64_t wbacks    = cache.getWritebackCount();
+            unsigned idleCycles= proc.getCyclesBlocked();
+            unsigned execCycles = getCurrentCycle() - idleCycles;
+            double   missRate  = accesses ? double(misses)/accesses : 0.0;
+            unsigned maxexectime = 0;
+            for (int k = 0; k < (int)getCaches().size(); ++k) {
+                maxexectime = std::max(maxexectime, getFinishCycle(k));
+            }
+
+            std::cout << "Core " << c << ":\n";
+            std::cout << "  1) #reads         = " << reads << "\n";
+            std::cout << "     #writes        = " << writes << "\n";
+            std::cout << "  2) exec cycles    = " << execCycles << "\n";
+            std::cout << "  3) idle cycles    = " << idleCycles << "\n";
+            std::cout << "  4) miss rate      = " << std::fixed << std::setprecision(2)
+                      << (missRate * 100) << "%\n";
+            std::cout << "  5) evictions      = " << evicts << "\n";
+            std::cout << "  6) writebacks     = " << wbacks << "\n";
+            if (cache.hasPrefetcher()) {
+                const PrefetchStats& pf = cache.getPrefetchStats();
+                std::cout << "     prefetches     = " << pf.issued << " (useful " << pf.useful
+                          << ", late " << pf.late << ", polluting " << pf.polluting << ")\n";
+            }
+            if (cache.getMshrCount() > 1) {
+                const CacheStats& stats = cache.getStats();
+                std::cout << "     mshr merges    = " << stats.mshrMerges
+                          << " (mshr-full stalls " << stats.mshrFull << ")\n";
+            }
+            if (cache.getWritebackBufferSize() > 0) {
+                const CacheStats& stats = cache.getStats();
+                std::cout << "     wb buffer      = " << stats.wbSnoopHits << " snoop hits, "
+                          << stats.wbRefills << " refills, " << stats.wbFull << " full"
+                          << " (writeback stall cycles " << stats.writebackStall << ")\n";
+            }
+            std::cout << "\n";
+            std::cout << " Maximum execution time = " << maxexectime << "\n";
+        }
+        std::cout << "  7) bus invalidations = " << getInvalidationCount() << "\n";
+        std::cout << "  8) bus traffic bytes = " << getBusTrafficBytes() << "\n";
+        if (getBusModel().isSplit()) {
+            const BusModel& bus = getBusModel();
+            uint64_t count = bus.getTransactionCount();
+            std::cout << "  9) bus queueing      = " << bus.getQueueCycles() << " cycles over "
+                      << count << " transactions (avg "
+                      << std::fixed << std::setprecision(2)
+                      << (count ? double(bus.getQueueCycles()) / count : 0.0)
+                      << ", max " << bus.getMaxQueueDelay() << ")\n";
+        }
+        if (getL2()) {
+            const L2Stats& l2 = getL2()->getStats();
+            std::cout << "\nL2 (shared, " << (getL2()->isInclusive() ? "inclusive" : "non-inclusive") << "):\n";
+            std::cout << "  1) accesses       = " << l2.accesses << "\n";
+            std::cout << "  2) hits           = " << l2.hits << "\n";
+            std::cout << "  3) misses         = " << l2.misses << "\n";
+            std::cout << "  4) miss rate      = " << std::fixed << std::setprecision(2)
+                      << (l2.missRate() * 100) << "%\n";
+            std::cout << "  5) evictions      = " << l2.evictions << "\n";
+            std::cout << "  6) writebacks     = " << l2.writebacks << "\n";
+            std::cout << "  7) back-invalidations = " << l2.backInvalidations << "\n";
+            std::cout << "  8) filtered snoops    = " << l2.filteredSnoops << "\n";
+        }
+        if (!config.protocol.empty()) {
+            printProtocolReport();
+        }
+        if (config.threads > 0) {
+            std::cout << "  lagged transactions  = " << getLaggedTransactions()
+                      << " (max lag " << getMaxLag() << " cycles)\n";
+        }
+        if (getSharingProfiler()) {
+            getSharingProfiler()->printReport(std::cout, config.sharingTop);
+        }
+        if (config.sampleInterval > 0) {
+            printSampledEstimates();
+        }
+        if (getScheduler()) {
+            printScheduleReport();
+        }
+    }
+
+    // Scheduled run: how far each trace got, and what its switches cost
+    void printScheduleReport() const {
+        const TraceScheduler& scheduler = *getScheduler();
+        std::cout << "\nSchedule (time slice ";
+        if (scheduler.getTimeSlice() > 0) std::cout << scheduler.getTimeSlice() << " cycles";
+        else                              std::cout << "none";
+        std::cout << ", L1 " << (scheduler.flushesOnSwitch() ? "flushed" : "kept") << " on switch):\n";
+        for (const auto& stream : scheduler.getStreams()) {
+            std::cout << "  " << stream.name << ": " << stream.instructions << " instructions, "
+                      << stream.preemptions << " preemptions, ";
+            if (stream.finishCycle > 0) std::cout << "finished at cycle " << stream.finishCycle;
+            else                        std::cout << "unfinished";
+            std::cout << " (last on core " << stream.core << ")\n";
+        }
+        const auto& cores = scheduler.getCoreSwitches();
+        for (size_t c = 0; c < cores.size(); ++c) {
+            std::cout << "  Core " << c << ": " << cores[c].switches << " context switches";
+            if (scheduler.flushesOnSwitch()) {
+                std::cout << ", " << cores[c].flushedLines << " lines flushed ("
+                          << cores[c].flushedDirty << " written back)";
+            }
+            std::cout << "\n";
+        }
+    }
+
+    // Coherence protocol report: where demand misses got their data and what
+    // the snooping cost, for comparing protocols on the same traces
+    void printProtocolReport() const {
+        const Bus& bus = getCoherenceBus();
+        uint64_t cacheFills = bus.getCacheFills();
+        uint64_t memoryFills = bus.getMemoryFills();
+        uint64_t responses = bus.getDataResponses();
+        uint64_t writebackBytes = bus.getSnoopWritebacks() * bus.getBlockSize();
+        std::cout << "\nCoherence (" << Bus::protocolName(bus.getProtocol()) << "):\n";
+        std::cout << "  1) fills from caches  = " << cacheFills << " (avg " << std::fixed
+                  << std::setprecision(2)
+                  << (cacheFills ? double(bus.getCacheFillCycles()) / cacheFills : 0.0)
+                  << " cycles)\n";
+        std::cout << "  2) fills from memory  = " << memoryFills << " (avg "
+                  << (memoryFills ? double(bus.getMemoryFillCycles()) / memoryFills : 0.0)
+                  << " cycles)\n";
+        std::cout << "  3) data responses     = " << responses << " ("
+                  << responses - bus.getCacheToCacheTransfers() << " redundant)\n";
+        std::cout << "  4) snoop writebacks   = " << bus.getSnoopWritebacks() << " ("
+                  << writebackBytes << " bytes)\n";
+        std::cout << "  5) traffic incl. snoop writebacks = "
+                  << bus.getTrafficBytes() + writebackBytes << " bytes\n";
+    }
+
+    // Sampled run: window means with 95% confidence intervals. The counters
+    // above include the functionally warmed accesses; cycles and bus figures
+    // cover only the detailed windows.
+    void printSampledEstimates() const {
+        const SampledMetric& cpi = getSampledCpi();
+        const SampledMetric& missRate = getSampledMissRate();
+        const double z = 1.96;
+        std::cout << "\n==== Sampled Estimates ====" << std::endl;
+        std::cout << "  windows            = " << cpi.count << " (" << getDetailedInstructions()
+                  << " of " << executedInstructions() << " instructions in detail)\n";
+        if (cpi.count == 0) {
+            std::cout << "  (no complete window: lower --sample or --sample-warmup)\n";
+            return;
+        }
+        // Windows have equal instruction counts, so IPC is the inverse of the
+        // mean CPI and its interval the inverse of the CPI interval
+        double mean = cpi.mean();
+        double half = cpi.halfWidth(z);
+        std::cout << std::fixed << std::setprecision(4);
+        std::cout << "  CPI                = " << mean << " +/- " << half << " (95%, +/- "
+                  << std::setprecision(2) << (100.0 * half / mean) << "%)\n";
+        std::cout << std::setprecision(4);
+        std::cout << "  IPC                = " << (1.0 / mean) << " (95%: " << (1.0 / (mean + half))
+                  << " .. ";
+        if (half < mean) std::cout << (1.0 / (mean - half));
+        else             std::cout << "inf";
+        std::cout << ")\n";
+        std::cout << std::setprecision(2);
+        std::cout << "  miss rate          = " << (100 * missRate.mean()) << "% +/- "
+                  << (100 * missRate.halfWidth(z)) << "% (95%)\n";
+        // SMARTS: windows needed for +/-3% at 99.7% confidence is (3 * V / 0.03)^2
+        double needed = std::ceil(std::pow(3.0 * cpi.variation() / 0.03, 2));
+        std::cout << "  CPI variation      = " << std::setprecision(3) << cpi.variation()
+                  << " (" << static_cast<uint64_t>(needed) << " windows give +/-3% at 99.7%)\n";
+    }
+};
+
+//------------------------------------------------------------------------------
+// Stack-distance analysis mode
+//------------------------------------------------------------------------------
+int runStackDistance(const SimulationConfig& config) {
+    TraceReader reader(config.appName, config.numCores);
+    if (!reader.openTraceFiles()) {
+        std::cerr << "Error: Failed to open trace files." << std::endl;
+        return 1;
+    }
+    if (config.prefetchTraces) {
+        reader.startPrefetch();
+    }
+
+    std::ofstream csv;
+    if (!config.outputFile.empty()) {
+        csv.open(config.outputFile);
+        if (!csv) {
+            std::cerr << "Error: Could not open output file " << config.outputFile << std::endl;
+            return 1;
+        }
+        csv << "core,E,accesses,misses,miss_rate\n";
+    }
+
+    std::cout << "===== Stack-Distance Analysis =====\n";
+    std::cout << "Application: " << config.appName << std::endl;
+    std::cout << "  Sets: " << (1 << config.setBits) << " (2^" << config.setBits << ")" << std::endl;
+    std::cout << "  Block Size: " << (1 << config.blockBits) << " bytes (2^" << config.blockBits << ")" << std::endl;
+    std::cout << "  LRU associativities: 1.." << config.stackDistanceWays << std::endl;
+    std::cout << "=====================================\n";
+
+    for (int core = 0; core < config.numCores; ++core) {
+        StackDistanceAnalyzer analyzer(config.setBits, config.blockBits, config.stackDistanceWays);
+        analyzer.consumeTrace(reader, core);
+
+        std::cout << "\nCore " << core << " (" << analyzer.getAccessCount() << " accesses):\n";
+        std::cout << "     E       misses  miss rate\n";
+        for (int E = 1; E <= config.stackDistanceWays; ++E) {
+            std::cout << std::setw(6) << E << std::setw(13) << analyzer.getMissCount(E) << "  "
+                      << std::fixed << std::setprecision(2) << std::setw(8)
+                      << (analyzer.getMissRate(E) * 100) << "%\n";
+            if (csv.is_open()) {
+                csv << core << "," << E << "," << analyzer.getAccessCount() << ","
+                    << analyzer.getMissCount(E) << "," << std::setprecision(6)
+                    << analyzer.getMissRate(E) << "\n";
+            }
+        }
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// Functional miss-rate mode
+//------------------------------------------------------------------------------
+int runFunctional(const SimulationConfig& config) {
+    std::shared_ptr<const SharedTrace> traces = SharedTrace::load(config.appName, config.numCores);
+    if (!traces) {
+        std::cerr << "Error: Failed to open trace files." << std::endl;
+        return 1;
+    }
+
+    std::ofstream csv;
+    if (!config.outputFile.empty()) {
+        csv.open(config.outputFile);
+        if (!csv) {
+            std::cerr << "Error: Could not open output file " << config.outputFile << std::endl;
+            return 1;
+        }
+        csv << "core,accesses,reads,writes,hits,misses,evictions,writebacks,miss_rate\n";
+    }
+
+    std::cout << "===== Functional Cache Model =====\n";
+    std::cout << "Application: " << config.appName << std::endl;
+    std::cout << "  Sets: " << (1 << config.setBits) << " (2^" << config.setBits << ")" << std::endl;
+    std::cout << "  Associativity: " << config.associativity << std::endl;
+    std::cout << "  Block Size: " << (1 << config.blockBits) << " bytes (2^" << config.blockBits << ")" << std::endl;
+    if (config.replacement != "lru") {
+        std::cout << "  Replacement: " << config.replacement << std::endl;
+    }
+    std::cout << "=====================================\n";
+
+    ReplacementPolicy policy = ReplacementPolicy::LRU;
+    parseReplacementPolicy(config.replacement, policy);
+    FunctionalCounts total;
+    for (int core = 0; core < config.numCores; ++core) {
+        FunctionalCacheModel model(config.setBits, config.associativity, config.blockBits, policy);
+        FunctionalCounts counts = model.run(traces->cores[core]);
+        total += counts;
+
+        std::cout << "\nCore " << core << ":\n";
+        std::cout << "  #reads         = " << counts.reads << "\n";
+        std::cout << "  #writes        = " << counts.writes << "\n";
+        std::cout << "  hits           = " << counts.hits << "\n";
+        std::cout << "  misses         = " << counts.misses << "\n";
+        std::cout << "  miss rate      = " << std::fixed << std::setprecision(2)
+                  << (counts.missRate() * 100) << "%\n";
+        std::cout << "  evictions      = " << counts.evictions << "\n";
+        std::cout << "  writebacks     = " << counts.writebacks << "\n";
+        if (csv.is_open()) {
+            csv << core << "," << counts.accesses << "," << counts.reads << "," << counts.writes
+                << "," << counts.hits << "," << counts.misses << "," << counts.evictions << ","
+                << counts.writebacks << "," << std::setprecision(6) << counts.missRate() << "\n";
+        }
+    }
+    std::cout << "\nAll cores: " << total.misses << " misses in " << total.accesses
+              << " accesses (" << std::setprecision(2) << (total.missRate() * 100) << "%)\n";
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// main()
+//------------------------------------------------------------------------------
+int main(int argc, char* argv[]) {
+    // Parse command line arguments
+    SimulationConfig config = parseCommandLineArguments(argc, argv);
+    
+    // If help was requested or invalid arguments, print help and exit
+    if (config.helpRequested || !validateConfig(config)) {
+        printHelp(argv[0]);
+        return config.helpRequested ? 0 : 1;
+    }
+    
+    // Analysis modes that do not run the timing simulator
+    if (config.stackDistanceWays > 0) {
+        return runStackDistance(config);
+    }
+    if (config.functionalOnly) {
+        return runFunctional(config);
+    }
+    
+    // Create simulator with the configuration
+    TestSimulator sim(config);
+    
+    // Initialize simulator
+    if (!sim.initialize()) {
+        std::cerr << "Failed to initialize simulator. Exiting." << std::endl;
+        return 1;
+    }
+    
+    // Display simulation parameters
+    std::cout << "===== Simulation Configuration =====\n";
+    if (config.schedule.empty()) {
+        std::cout << "Application: " << config.appName << std::endl;
+    } else {
+        std::cout << "Schedule: " << config.schedule << std::endl;
+    }
+    std::cout << "Cache Configuration:\n";
+    std::cout << "  Sets: " << (1 << config.setBits) << " (2^" << config.setBits << ")" << std::endl;
+    std::cout << "  Associativity: " << config.associativity << std::endl;
+    std::cout << "  Block Size: " << (1 << config.blockBits) << " bytes (2^" << config.blockBits << ")" << std::endl;
+    if (config.replacement != "lru") {
+        std::cout << "  Replacement: " << config.replacement << std::endl;
+    }
+    if (config.prefetcher != "none") {
+        std::cout << "  Prefetcher: " << config.prefetcher << " (degree " << config.prefetchDegree << ")" << std::endl;
+    }
+    if (config.mshrs > 1) {
+        std::cout << "  MSHRs: " << config.mshrs << std::endl;
+    }
+    if (config.writebackBuffer > 0) {
+        std::cout << "  Write-back buffer: " << config.writebackBuffer << " entries" << std::endl;
+    }
+    if (!config.protocol.empty()) {
+        std::cout << "  Protocol: " << config.protocol << std::endl;
+    }
+    if (config.l2SetBits > 0) {
+        int l2BlockBits = config.l2BlockBits > 0 ? config.l2BlockBits : config.blockBits;
+        std::cout << "  L2: " << (1 << config.l2SetBits) << " sets, " << config.l2Associativity
+                  << " ways, " << (1 << l2BlockBits) << "-byte blocks, " << config.l2Latency
+                  << " cycles, " << (config.l2Inclusive ? "inclusive" : "non-inclusive") << std::endl;
+    }
+    if (config.bus != "atomic") {
+        std::cout << "  Bus: " << config.bus << " (" << config.memoryBanks << " memory banks)" << std::endl;
+    }
+    if (!config.missProfileFile.empty()) {
+        std::cout << "  Miss profile: " << config.missProfileFile << std::endl;
+    }
+    if (config.sharingTop > 0) {
+        std::cout << "  Sharing report: top " << config.sharingTop << " blocks" << std::endl;
+    }
+    if (!config.checkpointFile.empty()) {
+        std::cout << "  Checkpoint: " << config.checkpointFile << " after " << config.checkpointAt << " instructions" << std::endl;
+    }
+    if (config.sampleInterval > 0) {
+        std::cout << "  Sampling: " << config.sampleSize << " of every " << config.sampleInterval
+                  << " instructions (after " << config.sampleWarmup << " detailed warm-up)" << std::endl;
+    }
+    if (!config.restoreFile.empty()) {
+        std::cout << "  Restored from: " << config.restoreFile << " (cycle " << sim.getCurrentCycle() << ")" << std::endl;
+    }
+    std::cout << "Output File: " << (config.outputFile.empty() ? "None" : config.outputFile) << std::endl;
+    std::cout << "=====================================\n\n";
+    
+    // Run simulation
+    std::cout << "Running simulation...\n";
+    if (config.threads > 0) {
+        sim.runParallel();
+    } else if (config.sampleInterval > 0) {
+        sim.runSampled();
+    } else {
+        while (!sim.isSimulationComplete()) {
+            sim.processNextCycle();
+        }
+    }
+    std::cout << "Simulation completed.\n";
+    sim.writeMissProfile();
+    
+    // Write statistics either to the specified output file or to stdout
+    if (!config.outputFile.empty()) {
+        std::ofstream ofs(config.outputFile);
+        if (!ofs) {
+            std::cerr << "Error: Could not open output file " << config.outputFile << std::endl;
+            return 1;
+        }
+        auto* origBuf = std::cout.rdbuf();
+        std::cout.rdbuf(ofs.rdbuf());
+        sim.printAllStats();
+        std::cout.rdbuf(origBuf);
+    } else {
+        sim.printAllStats();
+    }
+    
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include "TraceFormat.h"
+#include <iostream>
+#include <string>
+
+// Print help message
+static void printHelp(const char* programName) {
+    std::cout << "Usage: " << programName << " <file.trace> [<file.trace> ...]\n";
+    std::cout << "Convert text traces into the pre-decoded binary format.\n\n";
+    std::cout << "Each input <name>.trace is written next to it as <name>.btrace.\n";
+    std::cout << "Inputs may be compressed (<name>.trace.gz, <name>.trace.zst).\n";
+    std::cout << "L1simulate picks up <app>_procK.btrace automatically and falls\n";
+    std::cout << "back to <app>_procK.trace when no binary file is present.\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || std::string(argv[1]) == "-h") {
+        printHelp(argv[0]);
+        return argc < 2 ? 1 : 0;
+    }
+
+    const std::string textExt = TraceFormat::TEXT_EXTENSION;
+    int failures = 0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string input = argv[i];
+
+        // Replace a trailing ".trace" with ".btrace", otherwise append it
+        std::string output = input;
+        for (const std::string compressedExt : { TraceFormat::GZIP_EXTENSION, TraceFormat::ZSTD_EXTENSION }) {
+            if (output.size() >= compressedExt.size() &&
+                output.compare(output.size() - compressedExt.size(), compressedExt.size(), compressedExt) == 0) {
+                output.erase(output.size() - compressedExt.size());
+            }
+        }
+        if (output.size() >= textExt.size() &&
+            output.compare(output.size() - textExt.size(), textExt.size(), textExt) == 0) {
+            output.erase(output.size() - textExt.size());
+        }
+        output += TraceFormat::BINARY_EXTENSION;
+
+        uint64_t records = 0;
+        if (TraceFormat::convertTextTrace(input, output, &records)) {
+            std::cout << input << " -> " << output << " (" << records << " records)\n";
+        } else {
+            failures++;
+        }
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+#include "TraceFormat.h"
+#include "CompressedStream.h"
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cstdlib>
+
+namespace TraceFormat {
+
+// Records are collected in chunks of this many before being written out
+static const size_t WRITE_CHUNK_RECORDS = 1 << 16;
+
+// Convert a text trace into the binary format
+bool convertTextTrace(const std::string& textPath, const std::string& binaryPath,
+                      uint64_t* recordsWritten) {
+    Codec codec = CompressedStream::codecForPath(textPath);
+    std::ifstream plain;
+    CompressedStream compressed;
+    bool opened = false;
+    if (codec == Codec::NONE) {
+        plain.open(textPath);
+        opened = plain.is_open();
+    } else {
+        opened = compressed.open(textPath, codec);
+    }
+    std::istream& in = (codec == Codec::NONE) ? static_cast<std::istream&>(plain) : compressed;
+    if (!opened) {
+        std::cerr << "Error: Could not open trace file: " << textPath << std::endl;
+        return false;
+    }
+
+    std::ofstream out(binaryPath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Error: Could not create binary trace file: " << binaryPath << std::endl;
+        return false;
+    }
+
+    // Reserve space for the header; the record count is patched in at the end
+    Header header;
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.recordSize = RECORD_SIZE;
+    header.recordCount = 0;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<uint8_t> chunk;
+    chunk.reserve(WRITE_CHUNK_RECORDS * RECORD_SIZE);
+    uint64_t count = 0;
+    uint64_t lineNumber = 0;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        lineNumber++;
+
+        // Same tokenization as the text reader: "<op> <address>"
+        size_t pos = line.find_first_not_of(" \t\r");
+        if (pos == std::string::npos) {
+            break; // Blank line ends the trace for the text reader too
+        }
+        char opType = line[pos];
+        size_t addrBegin = line.find_first_not_of(" \t\r", pos + 1);
+        if (addrBegin == std::string::npos) {
+            break;
+        }
+        size_t addrEnd = line.find_first_of(" \t\r", addrBegin);
+        std::string addressStr = line.substr(addrBegin, addrEnd - addrBegin);
+
+        bool isWrite;
+        if (opType == 'R' || opType == 'r') {
+            isWrite = false;
+        } else if (opType == 'W' || opType == 'w') {
+            isWrite = true;
+        } else {
+            std::cerr << "Warning: Skipping unknown operation type '" << opType
+                      << "' at " << textPath << ":" << lineNumber << std::endl;
+            continue;
+        }
+
+        // Remove "0x" prefix if present
+        if (addressStr.substr(0, 2) == "0x") {
+            addressStr = addressStr.substr(2);
+        }
+        uint32_t address = static_cast<uint32_t>(std::strtoul(addressStr.c_str(), nullptr, 16));
+
+        size_t used = chunk.size();
+        chunk.resize(used + RECORD_SIZE);
+        encodeRecord(&chunk[used], isWrite, address);
+        count++;
+
+        if (chunk.size() >= WRITE_CHUNK_RECORDS * RECORD_SIZE) {
+            out.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+            chunk.clear();
+        }
+    }
+
+    if (!chunk.empty()) {
+        out.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+    }
+
+    // Patch the record count into the header
+    header.recordCount = count;
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    if (!out.good()) {
+        std::cerr << "Error: Failed while writing binary trace file: " << binaryPath << std::endl;
+        return false;
+    }
+
+    if (recordsWritten) {
+        *recordsWritten = count;
+    }
+    return true;
+}
+
+} // namespace TraceFormat
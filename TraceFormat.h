@@ -0,0 +1,85 @@
+#ifndef TRACE_FORMAT_H
+#define TRACE_FORMAT_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Pre-decoded binary trace format (.btrace)
+//
+// A small fixed header followed by packed 5-byte records:
+//   byte 0     : operation (0 = read, 1 = write)
+//   bytes 1..4 : 32-bit address, little-endian
+// Records are unaligned, so they are always decoded through memcpy.
+namespace TraceFormat {
+
+// File extensions for the two on-disk formats
+const char* const TEXT_EXTENSION   = ".trace";
+const char* const BINARY_EXTENSION = ".btrace";
+
+// Extra extensions of compressed traces (e.g. app1_proc0.trace.gz, app1_proc0.btrace.zst)
+const char* const GZIP_EXTENSION = ".gz";
+const char* const ZSTD_EXTENSION = ".zst";
+
+// Header constants
+const uint32_t MAGIC       = 0x4254314C; // "L1TB" in little-endian byte order
+const uint16_t VERSION     = 1;
+const uint16_t RECORD_SIZE = 5;
+
+// Operation bits stored in the first byte of each record
+const uint8_t OP_READ  = 0;
+const uint8_t OP_WRITE = 1;
+
+// On-disk header (16 bytes, no padding)
+struct Header {
+    uint32_t magic;        // MAGIC
+    uint16_t version;      // VERSION
+    uint16_t recordSize;   // RECORD_SIZE
+    uint64_t recordCount;  // Number of records that follow
+};
+static_assert(sizeof(Header) == 16, "TraceFormat::Header must be 16 bytes");
+
+// Check that a header read from disk describes a file we can decode
+inline bool isValidHeader(const Header& header) {
+    return header.magic == MAGIC &&
+           header.version == VERSION &&
+           header.recordSize == RECORD_SIZE;
+}
+
+// Encode one record into 5 bytes
+inline void encodeRecord(uint8_t* out, bool isWrite, uint32_t address) {
+    out[0] = isWrite ? OP_WRITE : OP_READ;
+    out[1] = static_cast<uint8_t>(address >> 0);
+    out[2] = static_cast<uint8_t>(address >> 8);
+    out[3] = static_cast<uint8_t>(address >> 16);
+    out[4] = static_cast<uint8_t>(address >> 24);
+}
+
+// Decode the address of one record
+inline uint32_t decodeAddress(const uint8_t* record) {
+    return static_cast<uint32_t>(record[1])       |
+           static_cast<uint32_t>(record[2]) << 8  |
+           static_cast<uint32_t>(record[3]) << 16 |
+           static_cast<uint32_t>(record[4]) << 24;
+}
+
+// Decode the operation bit of one record
+inline bool decodeIsWrite(const uint8_t* record) {
+    return (record[0] & 0x1) != 0;
+}
+
+// Build the trace file name for a core, e.g. ("app1", 2, ".btrace") -> "app1_proc2.btrace"
+inline std::string traceFileName(const std::string& appName, int coreId, const char* extension) {
+    return appName + "_proc" + std::to_string(coreId) + extension;
+}
+
+// Convert a text trace ("R 0x817ae8" per line) into the binary format.
+// The text trace may be gzip/zstd compressed (by its .gz/.zst extension).
+// Parsing stops at the first line the text reader would treat as end of trace.
+// Returns false (and prints the reason) if either file cannot be processed.
+bool convertTextTrace(const std::string& textPath, const std::string& binaryPath,
+                      uint64_t* recordsWritten = nullptr);
+
+} // namespace TraceFormat
+
+#endif // TRACE_FORMAT_H
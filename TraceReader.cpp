@@ -1,132 +1,520 @@
-#include "TraceReader.h"
-#include <iostream>
-#include <sstream>
-#include <cstdlib>
-
-// Constructor
-TraceReader::TraceReader(const std::string& appName, int numCores)
-    : applicationName(appName), numCores(numCores) {
-    
-    // Initialize vectors to the correct size
-    traceFiles.resize(numCores);
-    fileEnded.resize(numCores, false);
-}
-
-// Destructor
-TraceReader::~TraceReader() {
-    // Close all open files
-    for (auto& file : traceFiles) {
-        if (file.is_open()) {
-            file.close();
-        }
-    }
-}
-
-// Open trace files
-bool TraceReader::openTraceFiles() {
-    bool allFilesOpened = true;
-    
-    for (int i = 0; i < numCores; i++) {
-        // Construct filename based on application name and core ID
-        std::string filename = applicationName + "_proc" + std::to_string(i) + ".trace";
-        
-        // Open the file
-        traceFiles[i].open(filename);
-        
-        // Check if file opened successfully
-        if (!traceFiles[i].is_open()) {
-            std::cerr << "Error: Could not open trace file: " << filename << std::endl;
-            allFilesOpened = false;
-        }
-        
-        // Initialize EOF status
-        fileEnded[i] = false;
-    }
-    
-    return allFilesOpened;
-}
-
-// Check if there are more instructions for a core
-bool TraceReader::hasMoreInstructions(int coreId) const {
-    if (coreId < 0 || coreId >= numCores) {
-        std::cerr << "Error: Invalid core ID: " << coreId << std::endl;
-        return false;
-    }
-    
-    return !fileEnded[coreId];
-}
-
-// Get next instruction for a core
-Instruction TraceReader::getNextInstruction(int coreId) {
-    if (coreId < 0 || coreId >= numCores) {
-        std::cerr << "Error: Invalid core ID: " << coreId << std::endl;
-        return Instruction(); // Return invalid instruction
-    }
-    
-    if (fileEnded[coreId]) {
-        return Instruction(); // Return invalid instruction if at EOF
-    }
-    
-    // Read a line from the file
-    std::string line;
-    if (std::getline(traceFiles[coreId], line)) {
-        // Parse the line
-        std::istringstream iss(line);
-        char opType;
-        std::string addressStr;
-        
-        // Extract operation type and address
-        if (iss >> opType >> addressStr) {
-            Instruction::Type type;
-            
-            // Convert operation type
-            if (opType == 'R' || opType == 'r') {
-                type = Instruction::Type::READ;
-            } else if (opType == 'W' || opType == 'w') {
-                type = Instruction::Type::WRITE;
-            } else {
-                std::cerr << "Error: Unknown operation type in trace: " << opType << std::endl;
-                return Instruction(); // Return invalid instruction
-            }
-            
-            // Convert address string to uint32_t
-            uint32_t address = 0;
-            
-            // Remove "0x" prefix if present
-            if (addressStr.substr(0, 2) == "0x") {
-                addressStr = addressStr.substr(2);
-            }
-            
-            // Convert hex string to uint32_t
-            address = static_cast<uint32_t>(std::strtoul(addressStr.c_str(), nullptr, 16));
-            
-            // Return valid instruction
-            return Instruction(type, address);
-        }
-    }
-    
-    // If we reached here, we're at EOF or line parsing failed
-    fileEnded[coreId] = true;
-    return Instruction(); // Return invalid instruction
-}
-
-// Check if all trace files are at EOF
-bool TraceReader::allTracesCompleted() const {
-    for (bool ended : fileEnded) {
-        if (!ended) {
-            return false; // At least one trace still has instructions
-        }
-    }
-    return true; // All traces are complete
-}
-
-// Reset all trace files to beginning
-void TraceReader::resetTraces() {
-    for (int i = 0; i < numCores; i++) {
-        if (traceFiles[i].is_open()) {
-            traceFiles[i].clear();  // Clear EOF and error flags
-            traceFiles[i].seekg(0); // Go to beginning of file
-            fileEnded[i] = false;   // Reset EOF status
-        }
-    }
-}
\ No newline at end of file
+#include "TraceReader.h"
+#include "TraceFormat.h"
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Batches each core's prefetch ring can hold
+static const size_t PREFETCH_BATCHES = 8;
+
+// Constructor
+TraceReader::TraceReader(const std::string& appName, int numCores)
+    : applicationName(appName), numCores(numCores), prefetchStop(false) {
+    
+    // Initialize vectors to the correct size
+    traceFiles.resize(numCores);
+    mappedTraces.resize(numCores);
+    fileEnded.resize(numCores, false);
+    consumed.resize(numCores, 0);
+    compressedFiles.resize(numCores);
+    streamedBinary.resize(numCores, 0);
+    recordsLeft.resize(numCores, 0);
+    prefetchQueues.resize(numCores);
+    prefetchIndex.resize(numCores, 0);
+}
+
+// Constructor over in-memory traces
+TraceReader::TraceReader(std::shared_ptr<const SharedTrace> traces)
+    : applicationName(traces->applicationName),
+      numCores(static_cast<int>(traces->cores.size())),
+      sharedTrace(std::move(traces)), prefetchStop(false) {
+    
+    traceFiles.resize(numCores);
+    mappedTraces.resize(numCores);
+    sharedCursor.resize(numCores, 0);
+    fileEnded.resize(numCores, false);
+    consumed.resize(numCores, 0);
+    compressedFiles.resize(numCores);
+    streamedBinary.resize(numCores, 0);
+    recordsLeft.resize(numCores, 0);
+    prefetchQueues.resize(numCores);
+    prefetchIndex.resize(numCores, 0);
+}
+
+// Decode every trace file of an application into memory
+std::shared_ptr<const SharedTrace> SharedTrace::load(const std::string& appName, int numCores) {
+    TraceReader reader(appName, numCores);
+    if (!reader.openTraceFiles()) {
+        return nullptr;
+    }
+    
+    auto traces = std::make_shared<SharedTrace>();
+    traces->applicationName = appName;
+    traces->cores.resize(numCores);
+    
+    for (int i = 0; i < numCores; i++) {
+        while (reader.hasMoreInstructions(i)) {
+            Instruction inst = reader.getNextInstruction(i);
+            if (inst.isValid()) {
+                traces->cores[i].push_back(inst);
+            }
+        }
+    }
+    
+    return traces;
+}
+
+// Destructor
+TraceReader::~TraceReader() {
+    stopPrefetch();
+    
+    // Close all open files
+    for (auto& file : traceFiles) {
+        if (file.is_open()) {
+            file.close();
+        }
+    }
+    
+    unmapBinaryTraces();
+}
+
+// Map a binary trace file read-only; returns false if it is missing or unusable
+bool TraceReader::mapBinaryTrace(int coreId, const std::string& filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false; // No binary trace, caller falls back to text
+    }
+    
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(TraceFormat::Header)) {
+        std::cerr << "Warning: Ignoring truncated binary trace file: " << filename << std::endl;
+        close(fd);
+        return false;
+    }
+    
+    size_t length = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping stays valid after the descriptor is closed
+    
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Warning: Could not map binary trace file: " << filename << std::endl;
+        return false;
+    }
+    
+    const uint8_t* base = static_cast<const uint8_t*>(mapping);
+    TraceFormat::Header header;
+    std::memcpy(&header, base, sizeof(header));
+    
+    uint64_t payload = static_cast<uint64_t>(length - sizeof(header));
+    if (!TraceFormat::isValidHeader(header) ||
+        header.recordCount > payload / TraceFormat::RECORD_SIZE) {
+        std::cerr << "Warning: Ignoring malformed binary trace file: " << filename << std::endl;
+        munmap(mapping, length);
+        return false;
+    }
+    
+    // Records are consumed strictly front to back
+    madvise(mapping, length, MADV_SEQUENTIAL);
+    
+    MappedTrace& mapped = mappedTraces[coreId];
+    mapped.base = base;
+    mapped.length = length;
+    mapped.records = base + sizeof(header);
+    mapped.cursor = mapped.records;
+    mapped.end = mapped.records + header.recordCount * TraceFormat::RECORD_SIZE;
+    return true;
+}
+
+// Release all mappings
+void TraceReader::unmapBinaryTraces() {
+    for (auto& mapped : mappedTraces) {
+        if (mapped.isMapped()) {
+            munmap(const_cast<uint8_t*>(mapped.base), mapped.length);
+        }
+        mapped = MappedTrace();
+    }
+}
+
+// Try to open a compressed trace; returns false if it is missing or unusable
+bool TraceReader::openCompressedTrace(int coreId, const std::string& filename, bool binary) {
+    if (access(filename.c_str(), R_OK) != 0) {
+        return false; // No such file, try the next format
+    }
+    
+    Codec codec = CompressedStream::codecForPath(filename);
+    if (!CompressedStream::isCodecAvailable(codec)) {
+        std::cerr << "Warning: Skipping " << filename << ": built without "
+                  << CompressedStream::codecName(codec) << " support" << std::endl;
+        return false;
+    }
+    
+    std::unique_ptr<CompressedStream> stream(new CompressedStream());
+    if (!stream->open(filename, codec)) {
+        std::cerr << "Warning: Could not open compressed trace file: " << filename << std::endl;
+        return false;
+    }
+    
+    compressedFiles[coreId] = std::move(stream);
+    streamedBinary[coreId] = binary;
+    if (binary && !readStreamHeader(coreId)) {
+        std::cerr << "Warning: Ignoring malformed binary trace file: " << filename << std::endl;
+        compressedFiles[coreId].reset();
+        streamedBinary[coreId] = 0;
+        return false;
+    }
+    return true;
+}
+
+// Read and check the header of a compressed binary trace
+bool TraceReader::readStreamHeader(int coreId) {
+    TraceFormat::Header header;
+    if (!compressedFiles[coreId]->read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        !TraceFormat::isValidHeader(header)) {
+        return false;
+    }
+    recordsLeft[coreId] = header.recordCount;
+    return true;
+}
+
+// Stream a text-backed or compressed core reads from
+std::istream& TraceReader::inputStream(int coreId) {
+    if (compressedFiles[coreId]) {
+        return *compressedFiles[coreId];
+    }
+    return traceFiles[coreId];
+}
+
+// Decode the next instruction from a core's stream
+bool TraceReader::readStreamInstruction(int coreId, Instruction& inst) {
+    std::istream& in = inputStream(coreId);
+    
+    // Compressed binary traces carry the same 5-byte records as .btrace files
+    if (streamedBinary[coreId]) {
+        uint8_t record[TraceFormat::RECORD_SIZE];
+        if (recordsLeft[coreId] == 0 ||
+            !in.read(reinterpret_cast<char*>(record), sizeof(record))) {
+            return false;
+        }
+        recordsLeft[coreId]--;
+        inst = Instruction(TraceFormat::decodeIsWrite(record) ? Instruction::Type::WRITE
+                                                              : Instruction::Type::READ,
+                           TraceFormat::decodeAddress(record));
+        return true;
+    }
+    
+    std::string line;
+    return std::getline(in, line) && parseTraceLine(line, inst);
+}
+
+// Open trace files
+bool TraceReader::openTraceFiles() {
+    bool allFilesOpened = true;
+    
+    stopPrefetch();
+    
+    // In-memory traces need no files
+    if (sharedTrace) {
+        resetTraces();
+        return true;
+    }
+    
+    unmapBinaryTraces();
+    
+    for (int i = 0; i < numCores; i++) {
+        // Initialize EOF status
+        fileEnded[i] = false;
+        consumed[i] = 0;
+        compressedFiles[i].reset();
+        
+        // Prefer the pre-decoded binary trace when one has been generated
+        std::string binaryName = TraceFormat::traceFileName(applicationName, i, TraceFormat::BINARY_EXTENSION);
+        if (mapBinaryTrace(i, binaryName) ||
+            openCompressedTrace(i, binaryName + TraceFormat::ZSTD_EXTENSION, true) ||
+            openCompressedTrace(i, binaryName + TraceFormat::GZIP_EXTENSION, true)) {
+            continue;
+        }
+        
+        // Construct filename based on application name and core ID
+        std::string filename = TraceFormat::traceFileName(applicationName, i, TraceFormat::TEXT_EXTENSION);
+        
+        // Open the file
+        traceFiles[i].open(filename);
+        
+        // Fall back to a compressed copy of the text trace
+        if (traceFiles[i].is_open() ||
+            openCompressedTrace(i, filename + TraceFormat::ZSTD_EXTENSION, false) ||
+            openCompressedTrace(i, filename + TraceFormat::GZIP_EXTENSION, false)) {
+            continue;
+        }
+        
+        std::cerr << "Error: Could not open trace file: " << filename << std::endl;
+        allFilesOpened = false;
+    }
+    
+    return allFilesOpened;
+}
+
+// Check if there are more instructions for a core
+bool TraceReader::hasMoreInstructions(int coreId) const {
+    if (coreId < 0 || coreId >= numCores) {
+        std::cerr << "Error: Invalid core ID: " << coreId << std::endl;
+        return false;
+    }
+    
+    return !fileEnded[coreId];
+}
+
+// Get next instruction for a core
+Instruction TraceReader::getNextInstruction(int coreId) {
+    if (coreId < 0 || coreId >= numCores) {
+        std::cerr << "Error: Invalid core ID: " << coreId << std::endl;
+        return Instruction(); // Return invalid instruction
+    }
+    
+    if (fileEnded[coreId]) {
+        return Instruction(); // Return invalid instruction if at EOF
+    }
+    consumed[coreId]++;
+    
+    // In-memory traces are indexed directly
+    if (sharedTrace) {
+        const std::vector<Instruction>& trace = sharedTrace->cores[coreId];
+        if (sharedCursor[coreId] < trace.size()) {
+            return trace[sharedCursor[coreId]++];
+        }
+        fileEnded[coreId] = true;
+        return Instruction();
+    }
+    
+    // Binary traces decode straight out of the mapping, no per-record allocation
+    MappedTrace& mapped = mappedTraces[coreId];
+    if (mapped.isMapped()) {
+        if (mapped.cursor < mapped.end) {
+            const uint8_t* record = mapped.cursor;
+            mapped.cursor += TraceFormat::RECORD_SIZE;
+            return Instruction(TraceFormat::decodeIsWrite(record) ? Instruction::Type::WRITE
+                                                                  : Instruction::Type::READ,
+                               TraceFormat::decodeAddress(record));
+        }
+        fileEnded[coreId] = true;
+        return Instruction();
+    }
+    
+    // Text traces already decoded by the prefetch thread
+    if (prefetchQueues[coreId]) {
+        return nextPrefetchedInstruction(coreId);
+    }
+    
+    return readTextInstruction(coreId);
+}
+
+// Number of getNextInstruction calls a core's trace has answered
+uint64_t TraceReader::getConsumedCount(int coreId) const {
+    return consumed[coreId];
+}
+
+// Move a freshly opened trace past its first `count` instructions
+bool TraceReader::skipInstructions(int coreId, uint64_t count) {
+    // Replaying the reads (no simulation) leaves every format's cursor,
+    // prefetch ring and end-of-trace flag exactly where the run had them
+    while (consumed[coreId] < count) {
+        if (fileEnded[coreId]) {
+            return false;
+        }
+        getNextInstruction(coreId);
+    }
+    return consumed[coreId] == count;
+}
+
+// Check if a core's trace is served from a binary mapping
+bool TraceReader::isBinaryTrace(int coreId) const {
+    return coreId >= 0 && coreId < numCores && mappedTraces[coreId].isMapped();
+}
+
+// Decode the next instruction from the text trace of a core
+Instruction TraceReader::readTextInstruction(int coreId) {
+    // Read a line (or record) from the stream
+    Instruction inst;
+    if (readStreamInstruction(coreId, inst)) {
+        return inst;
+    }
+    
+    // If we reached here, we're at EOF or line parsing failed
+    fileEnded[coreId] = true;
+    return Instruction(); // Return invalid instruction
+}
+
+// Parse one text trace line
+bool TraceReader::parseTraceLine(const std::string& line, Instruction& inst) {
+    std::istringstream iss(line);
+    char opType;
+    std::string addressStr;
+    
+    // Extract operation type and address
+    if (!(iss >> opType >> addressStr)) {
+        return false;
+    }
+    
+    Instruction::Type type;
+    
+    // Convert operation type
+    if (opType == 'R' || opType == 'r') {
+        type = Instruction::Type::READ;
+    } else if (opType == 'W' || opType == 'w') {
+        type = Instruction::Type::WRITE;
+    } else {
+        std::cerr << "Error: Unknown operation type in trace: " << opType << std::endl;
+        inst = Instruction(); // Invalid instruction, but the trace goes on
+        return true;
+    }
+    
+    // Remove "0x" prefix if present
+    if (addressStr.substr(0, 2) == "0x") {
+        addressStr = addressStr.substr(2);
+    }
+    
+    // Convert hex string to uint32_t
+    uint32_t address = static_cast<uint32_t>(std::strtoul(addressStr.c_str(), nullptr, 16));
+    
+    inst = Instruction(type, address);
+    return true;
+}
+
+// Take the next instruction of a core from its prefetch ring
+Instruction TraceReader::nextPrefetchedInstruction(int coreId) {
+    SpscQueue<TraceBatch>& queue = *prefetchQueues[coreId];
+    unsigned int& index = prefetchIndex[coreId];
+    while (true) {
+        TraceBatch* batch = queue.front();
+        if (!batch) {
+            std::this_thread::yield(); // Decoder has not caught up yet
+            continue;
+        }
+        if (index < batch->count) {
+            return batch->items[index++];
+        }
+        if (batch->last) {
+            fileEnded[coreId] = true;
+            return Instruction();
+        }
+        queue.pop();
+        index = 0;
+    }
+}
+
+// Body of the prefetch thread: top up every core's ring one batch at a time
+void TraceReader::prefetchLoop() {
+    std::vector<uint8_t> done(numCores, 0);
+    for (int i = 0; i < numCores; i++) {
+        done[i] = prefetchQueues[i] ? 0 : 1;
+    }
+    
+    while (!prefetchStop.load(std::memory_order_relaxed)) {
+        bool pending = false;
+        bool progress = false;
+        for (int i = 0; i < numCores; i++) {
+            if (done[i]) continue;
+            pending = true;
+            
+            TraceBatch* batch = prefetchQueues[i]->reserve();
+            if (!batch) continue; // Ring full, the simulation is behind
+            
+            batch->count = 0;
+            batch->last = false;
+            while (batch->count < TraceBatch::CAPACITY) {
+                Instruction inst;
+                if (!readStreamInstruction(i, inst)) {
+                    batch->last = true;
+                    done[i] = 1;
+                    break;
+                }
+                batch->items[batch->count++] = inst;
+            }
+            prefetchQueues[i]->push();
+            progress = true;
+        }
+        if (!pending) return;
+        if (!progress) std::this_thread::yield();
+    }
+}
+
+// Decode the text traces on a background thread
+void TraceReader::startPrefetch() {
+    if (isPrefetching()) return;
+    
+    bool anyText = false;
+    for (int i = 0; i < numCores; i++) {
+        bool streamed = traceFiles[i].is_open() || compressedFiles[i];
+        if (!sharedTrace && !mappedTraces[i].isMapped() && streamed && !fileEnded[i]) {
+            prefetchQueues[i].reset(new SpscQueue<TraceBatch>(PREFETCH_BATCHES));
+            prefetchIndex[i] = 0;
+            anyText = true;
+        }
+    }
+    if (!anyText) return; // Binary and in-memory traces are already cheap to read
+    
+    prefetchStop.store(false);
+    prefetchThread = std::thread(&TraceReader::prefetchLoop, this);
+}
+
+// Stop the prefetch thread and drop undelivered batches
+void TraceReader::stopPrefetch() {
+    prefetchStop.store(true);
+    if (prefetchThread.joinable()) {
+        prefetchThread.join();
+    }
+    for (auto& queue : prefetchQueues) {
+        queue.reset();
+    }
+}
+
+// Check if a background thread is decoding the traces
+bool TraceReader::isPrefetching() const {
+    return prefetchThread.joinable();
+}
+
+// Check if all trace files are at EOF
+bool TraceReader::allTracesCompleted() const {
+    for (bool ended : fileEnded) {
+        if (!ended) {
+            return false; // At least one trace still has instructions
+        }
+    }
+    return true; // All traces are complete
+}
+
+// Reset all trace files to beginning
+void TraceReader::resetTraces() {
+    bool wasPrefetching = isPrefetching();
+    stopPrefetch();
+    
+    for (int i = 0; i < numCores; i++) {
+        consumed[i] = 0;
+        if (sharedTrace) {
+            sharedCursor[i] = 0;
+            fileEnded[i] = false;
+        } else if (mappedTraces[i].isMapped()) {
+            mappedTraces[i].cursor = mappedTraces[i].records;
+            fileEnded[i] = false;
+        } else if (compressedFiles[i]) {
+            compressedFiles[i]->rewind();
+            if (streamedBinary[i]) {
+                readStreamHeader(i);
+            }
+            fileEnded[i] = false;
+        } else if (traceFiles[i].is_open()) {
+            traceFiles[i].clear();  // Clear EOF and error flags
+            traceFiles[i].seekg(0); // Go to beginning of file
+            fileEnded[i] = false;   // Reset EOF status
+        }
+    }
+    
+    if (wasPrefetching) {
+        startPrefetch();
+    }
+}
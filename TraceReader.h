@@ -1,52 +1,155 @@
-#ifndef TRACE_READER_H
-#define TRACE_READER_H
-
-#include <string>
-#include <vector>
-#include <fstream>
-#include <cstdint>
-
-// Simple struct to represent an instruction from the trace
-struct Instruction {
-    enum class Type { READ, WRITE, INVALID };
-    
-    Type type;
-    uint32_t address;
-    
-    Instruction() : type(Type::INVALID), address(0) {}
-    Instruction(Type t, uint32_t addr) : type(t), address(addr) {}
-    
-    bool isValid() const { return type != Type::INVALID; }
-};
-
-class TraceReader {
-private:
-    std::string applicationName;            // Base name of the application
-    int numCores;                           // Number of cores/trace files
-    std::vector<std::ifstream> traceFiles;  // One file per core
-    std::vector<bool> fileEnded;            // Tracks EOF status for each file
-    
-public:
-    // Constructor
-    TraceReader(const std::string& appName, int numCores = 4);
-    
-    // Destructor
-    ~TraceReader();
-    
-    // Open trace files
-    bool openTraceFiles();
-    
-    // Check if there are more instructions for a core
-    bool hasMoreInstructions(int coreId) const;
-    
-    // Get next instruction for a core
-    Instruction getNextInstruction(int coreId);
-    
-    // Check if all trace files are at EOF
-    bool allTracesCompleted() const;
-    
-    // Reset all trace files to beginning
-    void resetTraces();
-};
-
+#ifndef TRACE_READER_H
+#define TRACE_READER_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include "SpscQueue.h"
+#include "CompressedStream.h"
+
+// Simple struct to represent an instruction from the trace
+struct Instruction {
+    enum class Type { READ, WRITE, INVALID };
+    
+    Type type;
+    uint32_t address;
+    
+    Instruction() : type(Type::INVALID), address(0) {}
+    Instruction(Type t, uint32_t addr) : type(t), address(addr) {}
+    
+    bool isValid() const { return type != Type::INVALID; }
+};
+
+// Every core's trace decoded into memory once, then replayed read-only by
+// any number of TraceReaders (e.g. one per simulator in a parameter sweep)
+struct SharedTrace {
+    std::string applicationName;
+    std::vector<std::vector<Instruction>> cores;  // Instructions per core, in trace order
+    
+    // Decode all trace files of an application; returns nullptr on failure
+    static std::shared_ptr<const SharedTrace> load(const std::string& appName, int numCores = 4);
+};
+
+// A run of instructions decoded ahead by the prefetch thread
+struct TraceBatch {
+    static const unsigned int CAPACITY = 256;
+    
+    unsigned int count = 0;        // Instructions filled in
+    bool last = false;             // The trace ends after this batch
+    Instruction items[CAPACITY];
+};
+
+// A read-only memory mapping of one binary (.btrace) trace file
+struct MappedTrace {
+    const uint8_t* base = nullptr;   // Start of the mapping (header included)
+    size_t length = 0;               // Length of the mapping in bytes
+    const uint8_t* records = nullptr; // First record
+    const uint8_t* cursor = nullptr;  // Next record to decode
+    const uint8_t* end = nullptr;     // One past the last record
+    
+    bool isMapped() const { return base != nullptr; }
+};
+
+class TraceReader {
+private:
+    std::string applicationName;            // Base name of the application
+    int numCores;                           // Number of cores/trace files
+    std::vector<std::ifstream> traceFiles;  // One file per core (text fallback)
+    std::vector<std::unique_ptr<CompressedStream>> compressedFiles; // Per core, for .gz/.zst traces
+    std::vector<uint8_t> streamedBinary;    // Core's compressed stream holds binary records
+    std::vector<uint64_t> recordsLeft;      // Records still to read from a compressed binary trace
+    std::vector<MappedTrace> mappedTraces;  // One mapping per core (binary format)
+    std::shared_ptr<const SharedTrace> sharedTrace; // In-memory traces (replaces files when set)
+    std::vector<size_t> sharedCursor;       // Next instruction per core in sharedTrace
+    std::vector<uint8_t> fileEnded;         // Tracks EOF status for each file (a byte per core,
+                                            // so cores may be advanced from different threads)
+    std::vector<uint64_t> consumed;         // getNextInstruction calls answered per core (checkpoints)
+    
+    // Prefetch: one ring of decoded batches per text-backed core, filled by
+    // prefetchThread and drained by whichever thread simulates the core
+    std::vector<std::unique_ptr<SpscQueue<TraceBatch>>> prefetchQueues; // Null = not prefetched
+    std::vector<unsigned int> prefetchIndex;  // Next instruction in each core's front batch
+    std::thread prefetchThread;
+    std::atomic<bool> prefetchStop;
+    
+    // Try to map <app>_procK.btrace for a core; returns false if unavailable
+    bool mapBinaryTrace(int coreId, const std::string& filename);
+    
+    // Release all mappings
+    void unmapBinaryTraces();
+    
+    // Try to open a compressed trace for a core; returns false if unavailable
+    bool openCompressedTrace(int coreId, const std::string& filename, bool binary);
+    
+    // Read and check the header of a compressed binary trace
+    bool readStreamHeader(int coreId);
+    
+    // Stream a text-backed or compressed core reads from
+    std::istream& inputStream(int coreId);
+    
+    // Decode the next instruction from a core's stream; false at end of trace
+    bool readStreamInstruction(int coreId, Instruction& inst);
+    
+    // Decode the next instruction from the text trace of a core
+    Instruction readTextInstruction(int coreId);
+    
+    // Parse one text trace line; false if the line ends the trace.
+    // An unknown operation yields true with an invalid instruction.
+    static bool parseTraceLine(const std::string& line, Instruction& inst);
+    
+    // Take the next instruction of a core from its prefetch ring
+    Instruction nextPrefetchedInstruction(int coreId);
+    
+    // Body of the prefetch thread
+    void prefetchLoop();
+    
+public:
+    // Constructor
+    TraceReader(const std::string& appName, int numCores = 4);
+    
+    // Constructor replaying in-memory traces instead of opening files
+    explicit TraceReader(std::shared_ptr<const SharedTrace> traces);
+    
+    // Destructor
+    ~TraceReader();
+    
+    // Open trace files
+    bool openTraceFiles();
+    
+    // Check if there are more instructions for a core
+    bool hasMoreInstructions(int coreId) const;
+    
+    // Get next instruction for a core
+    Instruction getNextInstruction(int coreId);
+    
+    // Number of getNextInstruction calls a core's trace has answered
+    uint64_t getConsumedCount(int coreId) const;
+    
+    // Move a freshly opened trace past its first `count` instructions (checkpoint
+    // restore); false if the trace is shorter
+    bool skipInstructions(int coreId, uint64_t count);
+    
+    // Check if a core's trace is served from a binary mapping
+    bool isBinaryTrace(int coreId) const;
+    
+    // Check if all trace files are at EOF
+    bool allTracesCompleted() const;
+    
+    // Reset all trace files to beginning
+    void resetTraces();
+    
+    // Decode the text traces on a background thread, ahead of the simulation
+    void startPrefetch();
+    
+    // Stop the prefetch thread (call before reopening or rewinding the files)
+    void stopPrefetch();
+    
+    // Check if a background thread is decoding the traces
+    bool isPrefetching() const;
+};
+
 #endif // TRACE_READER_H
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "TraceScheduler.h"
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+
+// Parse "app[:k],app[:k],..."
+bool TraceScheduler::parseSchedule(const std::string& spec, int defaultTraces,
+                                   std::vector<ScheduleEntry>& entries) {
+    entries.clear();
+    std::stringstream list(spec);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        ScheduleEntry entry{item, defaultTraces};
+        size_t colon = item.find(':');
+        if (colon != std::string::npos) {
+            entry.appName = item.substr(0, colon);
+            std::string count = item.substr(colon + 1);
+            if (count.empty() || count.find_first_not_of("0123456789") != std::string::npos) {
+                return false;
+            }
+            entry.traces = std::stoi(count);
+        }
+        if (entry.appName.empty() || entry.traces <= 0) {
+            return false;
+        }
+        entries.push_back(entry);
+    }
+    return !entries.empty() && spec.back() != ',';
+}
+
+// Constructor
+TraceScheduler::TraceScheduler(int numCores, unsigned int timeSlice, const unsigned int& clock)
+    : timeSlice(timeSlice), clock(clock), flushOnSwitch(false),
+      running(numCores, -1), sliceEnd(numCores, 0), sliceStarted(numCores, 0),
+      coreSwitches(numCores) {
+}
+
+// Open every program's traces and queue their streams
+bool TraceScheduler::open(const std::vector<ScheduleEntry>& entries) {
+    int mostTraces = 0;
+    for (const auto& entry : entries) {
+        readers.emplace_back(new TraceReader(entry.appName, entry.traces));
+        if (!readers.back()->openTraceFiles()) {
+            std::cerr << "Error: Failed to open the traces of " << entry.appName << "\n";
+            return false;
+        }
+        mostTraces = std::max(mostTraces, entry.traces);
+    }
+
+    // A program listed more than once runs as several processes: app, app#2, ...
+    std::vector<std::string> processNames;
+    for (size_t e = 0; e < entries.size(); ++e) {
+        int copy = 1;
+        for (size_t earlier = 0; earlier < e; ++earlier) {
+            if (entries[earlier].appName == entries[e].appName) copy++;
+        }
+        processNames.push_back(copy > 1 ? entries[e].appName + "#" + std::to_string(copy)
+                                        : entries[e].appName);
+    }
+
+    // Interleave the programs, so the first cores run a mix of them
+    for (int k = 0; k < mostTraces; ++k) {
+        for (size_t e = 0; e < entries.size(); ++e) {
+            if (k >= entries[e].traces) continue;
+            Stream stream;
+            stream.name = processNames[e] + "." + std::to_string(k);
+            stream.reader = readers[e].get();
+            stream.trace = k;
+            // Reverse the program's position into the top address bits
+            uint32_t relocation = 0;
+            for (uint32_t bits = static_cast<uint32_t>(e), b = 0; bits; bits >>= 1, ++b) {
+                if (bits & 1) relocation |= 0x80000000u >> b;
+            }
+            stream.relocation = relocation;
+            ready.push_back(static_cast<int>(streams.size()));
+            streams.push_back(stream);
+        }
+    }
+    return true;
+}
+
+// Decode the text traces on background threads
+void TraceScheduler::startPrefetch() {
+    for (auto& reader : readers) {
+        reader->startPrefetch();
+    }
+}
+
+// Flush a core's L1 whenever another stream is put on it
+void TraceScheduler::setFlushOnSwitch(bool enabled) {
+    flushOnSwitch = enabled;
+}
+
+bool TraceScheduler::flushesOnSwitch() const {
+    return flushOnSwitch;
+}
+
+// Retire or preempt the core's stream and dispatch the next waiting one
+bool TraceScheduler::schedule(int core) {
+    int current = running[core];
+    bool finished = current < 0 || !streamHasMore(current);
+    if (!finished && (timeSlice == 0 || !sliceStarted[core] || clock < sliceEnd[core] ||
+                      ready.empty())) {
+        return false;   // Keeps running
+    }
+    if (ready.empty()) {
+        return false;   // Finished, and nothing waits
+    }
+
+    if (!finished) {
+        streams[current].preemptions++;
+        ready.push_back(current);
+    }
+    int next = ready.front();
+    ready.pop_front();
+    running[core] = next;
+    sliceStarted[core] = 0;
+    streams[next].core = core;
+    if (current >= 0) {
+        coreSwitches[core].switches++;
+    }
+    return true;
+}
+
+// Check if a core has an instruction to run
+bool TraceScheduler::hasMoreInstructions(int core) const {
+    int current = running[core];
+    return (current >= 0 && streamHasMore(current)) || !ready.empty();
+}
+
+// Next instruction of the core's stream, relocated
+Instruction TraceScheduler::getNextInstruction(int core) {
+    int current = running[core];
+    if (current < 0) {
+        return Instruction();
+    }
+    if (!sliceStarted[core]) {
+        sliceStarted[core] = 1;
+        sliceEnd[core] = clock + timeSlice;
+    }
+    Stream& stream = streams[current];
+    Instruction inst = stream.reader->getNextInstruction(stream.trace);
+    if (inst.isValid()) {
+        inst.address ^= stream.relocation;
+        stream.instructions++;
+    }
+    if (!streamHasMore(current)) {
+        stream.finishCycle = clock;
+    }
+    return inst;
+}
+
+// Check if every stream has run to its end
+bool TraceScheduler::allStreamsCompleted() const {
+    for (const auto& reader : readers) {
+        if (!reader->allTracesCompleted()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// A switch flushed `lines` valid lines of a core's L1, `dirty` of them written back
+void TraceScheduler::recordFlush(int core, unsigned int lines, unsigned int dirty) {
+    coreSwitches[core].flushedLines += lines;
+    coreSwitches[core].flushedDirty += dirty;
+}
+
+// Check if a stream has instructions left
+bool TraceScheduler::streamHasMore(int stream) const {
+    return streams[stream].reader->hasMoreInstructions(streams[stream].trace);
+}
+
+// Statistics
+const std::vector<TraceScheduler::Stream>& TraceScheduler::getStreams() const {
+    return streams;
+}
+
+const std::vector<TraceScheduler::CoreSwitches>& TraceScheduler::getCoreSwitches() const {
+    return coreSwitches;
+}
+
+unsigned int TraceScheduler::getTimeSlice() const {
+    return timeSlice;
+}
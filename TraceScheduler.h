@@ -0,0 +1,112 @@
+#ifndef TRACE_SCHEDULER_H
+#define TRACE_SCHEDULER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <cstdint>
+#include "TraceReader.h"
+
+// One program of a --schedule list: its first `traces` trace files
+struct ScheduleEntry {
+    std::string appName;
+    int traces;
+};
+
+// Time-slices trace streams over the cores, as an OS would run more
+// threads than there are cores (multi-programmed workloads).
+//
+// Every trace file of every scheduled program is a stream. Streams wait in
+// one FIFO ready queue, interleaved across the programs (app1.0, app2.0,
+// app1.1, ...), and a core with nothing to run takes the front one. Once a
+// stream has held its core for timeSlice cycles and another stream is
+// waiting, it is preempted at its next fetch and goes to the back of the
+// queue; it may resume on any core. A slice starts at the stream's first
+// fetch, so the writebacks of a flush on switching do not shorten it.
+// Switches only happen between instructions, so a miss in flight completes
+// for the stream that issued it. With timeSlice 0 streams run to completion.
+//
+// Threads of one program share its address space. Programs are separate
+// processes: each one after the first has the reversed bits of its list
+// position XORed into the top of its addresses, so different programs (or
+// two copies of one) do not share blocks unless their relocated footprints
+// collide.
+class TraceScheduler {
+public:
+    // One trace of a program, scheduled as a thread
+    struct Stream {
+        std::string name;            // "<app>.<k>": trace k of its program ("<app>#2.<k>": of its second copy)
+        TraceReader* reader;
+        int trace;                   // Core index of the trace in its reader
+        uint32_t relocation;         // XORed into every address
+        uint64_t instructions = 0;   // Instructions fetched
+        unsigned int preemptions = 0; // Times its time slice ran out while others waited
+        int core = -1;               // Core it ran on last (-1 = never ran)
+        unsigned int finishCycle = 0; // Cycle it fetched past its last instruction (0 = running)
+    };
+
+    // Per core: context switches and the L1 state they flushed
+    struct CoreSwitches {
+        unsigned int switches = 0;   // Streams put on the core after its first
+        uint64_t flushedLines = 0;   // Valid lines invalidated by flushes
+        uint64_t flushedDirty = 0;   // ... of which were written back
+    };
+
+    // Parse "app[:k],app[:k],..." (k traces per program, default
+    // defaultTraces); returns false for anything else
+    static bool parseSchedule(const std::string& spec, int defaultTraces,
+                              std::vector<ScheduleEntry>& entries);
+
+    // Constructor - `clock` is the simulator's cycle, which times the slices
+    TraceScheduler(int numCores, unsigned int timeSlice, const unsigned int& clock);
+
+    // Open every program's traces and queue their streams; false on failure
+    bool open(const std::vector<ScheduleEntry>& entries);
+
+    // Decode the text traces on background threads (see TraceReader)
+    void startPrefetch();
+
+    // Flush the L1 of a core whenever another stream is put on it (default: keep it)
+    void setFlushOnSwitch(bool enabled);
+    bool flushesOnSwitch() const;
+
+    // Before a core fetches: retire its finished stream or preempt it once its
+    // slice is over, and dispatch the next waiting one. True if the core now
+    // runs a different stream than before.
+    bool schedule(int core);
+
+    // Check if a core has an instruction to run (its stream's, or a waiting stream)
+    bool hasMoreInstructions(int core) const;
+
+    // Next instruction of the core's stream, relocated
+    Instruction getNextInstruction(int core);
+
+    // Check if every stream has run to its end
+    bool allStreamsCompleted() const;
+
+    // A switch on `core` flushed `lines` valid lines, `dirty` of them written back
+    void recordFlush(int core, unsigned int lines, unsigned int dirty);
+
+    // Statistics
+    const std::vector<Stream>& getStreams() const;
+    const std::vector<CoreSwitches>& getCoreSwitches() const;
+    unsigned int getTimeSlice() const;
+
+private:
+    // Check if a stream has instructions left
+    bool streamHasMore(int stream) const;
+
+    unsigned int timeSlice;            // Cycles per slice (0 = run to completion)
+    const unsigned int& clock;
+    bool flushOnSwitch;
+    std::vector<std::unique_ptr<TraceReader>> readers;   // One per program
+    std::vector<Stream> streams;
+    std::deque<int> ready;             // Waiting streams, next first
+    std::vector<int> running;          // Per core: stream it runs (-1 = none yet)
+    std::vector<unsigned int> sliceEnd; // Per core: cycle its stream's slice ends
+    std::vector<uint8_t> sliceStarted;  // Per core: its stream has fetched since dispatch
+    std::vector<CoreSwitches> coreSwitches;
+};
+
+#endif // TRACE_SCHEDULER_H